@@ -0,0 +1,149 @@
+/*
+** pipe_latency.cpp
+**
+** This file is part of mkxp.
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Latency of a Screen.set image switch through the helper's
+ * FIFO, from the game writing the message to the helper's
+ * reader having it in hand (Pipe::wait + Pipe::readMessage,
+ * as in screen.cpp). The helper is a forked child here.
+ * Unix only.
+ *
+ *   c++ -O2 -Isrc/oneshot/headers -o pipe_latency benchmark/pipe_latency.cpp
+ *   ./pipe_latency [switches] [interval_us]
+ */
+
+#include "pipe.h"
+
+#include <sys/wait.h>
+#include <time.h>
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define PIPE_NAME "mkxp-pipe-latency"
+
+static uint64_t nowNs()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int runHelper(int count)
+{
+	Pipe ipc(PIPE_NAME, Pipe::Read);
+
+	std::vector<uint64_t> latencies;
+	latencies.reserve(count);
+
+	std::string msg;
+
+	while ((int) latencies.size() < count && !ipc.closed())
+	{
+		bool ready = ipc.wait(100);
+		bool any = false;
+
+		while (ipc.readMessage(msg))
+		{
+			const uint64_t now = nowNs();
+			uint64_t sent;
+
+			if (msg.size() < sizeof(sent))
+				continue;
+
+			memcpy(&sent, msg.data(), sizeof(sent));
+			latencies.push_back(now - sent);
+			any = true;
+		}
+
+		/* Nothing connected yet */
+		if (ready && !any)
+			usleep(1000);
+	}
+
+	if (latencies.empty())
+		return 1;
+
+	std::sort(latencies.begin(), latencies.end());
+
+	uint64_t sum = 0;
+
+	for (size_t i = 0; i < latencies.size(); ++i)
+		sum += latencies[i];
+
+	const size_t n = latencies.size();
+
+	printf("pipe_latency: %zu switches, mean %.1f us, p50 %.1f us, "
+	       "p99 %.1f us, max %.1f us\n", n,
+	       sum / 1000.0 / n,
+	       latencies[n / 2] / 1000.0,
+	       latencies[n * 99 / 100] / 1000.0,
+	       latencies[n - 1] / 1000.0);
+
+	/* We leave through _exit() */
+	fflush(stdout);
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	const int count = argc > 1 ? atoi(argv[1]) : 2000;
+	const int intervalUs = argc > 2 ? atoi(argv[2]) : 500;
+
+	/* Creates the FIFO before the helper goes looking for it */
+	Pipe ipc(PIPE_NAME, Pipe::Write);
+
+	pid_t pid = fork();
+
+	if (pid < 0)
+	{
+		perror("fork");
+		return 1;
+	}
+
+	if (pid == 0)
+		_exit(runHelper(count));
+
+	ipc.connect();
+
+	/* A typical image name after the timestamp */
+	std::string msg(sizeof(uint64_t), '\0');
+	msg += "journal_page_03";
+
+	for (int i = 0; i < count; ++i)
+	{
+		/* Spaced out, so this measures wake-up latency
+		 * rather than how fast the helper drains a burst */
+		usleep(intervalUs);
+
+		const uint64_t sent = nowNs();
+		memcpy(&msg[0], &sent, sizeof(sent));
+
+		ipc.writeMessage(msg);
+	}
+
+	int status = 0;
+	waitpid(pid, &status, 0);
+
+	ipc.close();
+
+	return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
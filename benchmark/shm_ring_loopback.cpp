@@ -0,0 +1,236 @@
+/*
+** shm_ring_loopback.cpp
+**
+** This file is part of mkxp.
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Loopback over the OtherView shared memory transport: a forked
+ * peer maps the block by name and shakes hands over it, like the
+ * OtherView instance does, and echoes pings back (round-trip latency), then drains a
+ * one-way stream (messages/sec). Both sides busy-poll, yielding
+ * after a while to cope with a single core. This measures the
+ * transport's own cost, not a frame's worth of waiting.
+ * Unix only.
+ *
+ *   c++ -O2 -Isrc/modshot/headers -Isrc/util/headers \
+ *       -o shm_ring_loopback benchmark/shm_ring_loopback.cpp \
+ *       src/modshot/source/shm-ring.cpp $(sdl2-config --cflags --libs) -lrt
+ *   ./shm_ring_loopback [pings] [messages] [message_size]
+ */
+
+#include "shm-ring.h"
+
+#include <sched.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Same layout as otherview-message.cpp */
+#define SHM_NAME "mkxp-shm-ring-loopback"
+#define SHM_RING_CAPACITY (1 << 20)
+#define SHM_RING_STRIDE (ShmRing::HeaderSize + SHM_RING_CAPACITY)
+#define SHM_SIZE (ShmHandshake::Size + SHM_RING_STRIDE * 2)
+
+/* Failed polls before giving the peer a chance to run */
+#define SPIN_LIMIT 256
+
+enum
+{
+	Ping = 1,
+	Stream,
+	StreamEnd
+};
+
+static uint64_t nowNs()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void backOff(int &spins)
+{
+	if (++spins < SPIN_LIMIT)
+		return;
+
+	sched_yield();
+	spins = 0;
+}
+
+static void pushWait(ShmRing &ring, int type, const std::string &data)
+{
+	for (int spins = 0; !ring.push(type, data.data(), data.size());)
+		backOff(spins);
+}
+
+static void popWait(ShmRing &ring, int &type, std::string &data)
+{
+	for (int spins = 0; !ring.pop(type, data);)
+		backOff(spins);
+}
+
+/* Echoes pings and counts streamed messages, which it
+ * reports back once the stream ends */
+static int runPeer()
+{
+	SharedMemory shm;
+
+	if (!shm.open(SHM_NAME, SHM_SIZE))
+		return 1;
+
+	ShmHandshake handshake;
+	handshake.attach(shm.data());
+
+	for (int spins = 0; handshake.peerPoll() != ShmHandshake::Linked;)
+		backOff(spins);
+
+	char *base = static_cast<char*>(shm.data()) + ShmHandshake::Size;
+
+	ShmRing in, out;
+	in.attach(base, SHM_RING_CAPACITY);
+	out.attach(base + SHM_RING_STRIDE, SHM_RING_CAPACITY);
+
+	uint32_t streamed = 0;
+	std::string data;
+	int type;
+
+	for (;;)
+	{
+		popWait(in, type, data);
+
+		if (type == Ping)
+		{
+			pushWait(out, Ping, data);
+		}
+		else if (type == Stream)
+		{
+			++streamed;
+		}
+		else if (type == StreamEnd)
+		{
+			pushWait(out, StreamEnd,
+			         std::string((const char*) &streamed, sizeof(streamed)));
+			return 0;
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	const int pings = argc > 1 ? atoi(argv[1]) : 100000;
+	const int messages = argc > 2 ? atoi(argv[2]) : 1000000;
+	const int msgSize = argc > 3 ? atoi(argv[3]) : 64;
+
+	SharedMemory shm;
+
+	if (!shm.create(SHM_NAME, SHM_SIZE))
+	{
+		fprintf(stderr, "Cannot create shared memory block\n");
+		return 1;
+	}
+
+	ShmHandshake handshake;
+	handshake.reset(shm.data(), SHM_SIZE);
+
+	pid_t pid = fork();
+
+	if (pid < 0)
+	{
+		perror("fork");
+		return 1;
+	}
+
+	if (pid == 0)
+		_exit(runPeer());
+
+	for (int spins = 0; !handshake.ownerPoll();)
+		backOff(spins);
+
+	char *base = static_cast<char*>(shm.data()) + ShmHandshake::Size;
+
+	ShmRing out, in;
+	out.attach(base, SHM_RING_CAPACITY);
+	in.attach(base + SHM_RING_STRIDE, SHM_RING_CAPACITY);
+
+	std::string msg(msgSize, 'x');
+	std::string reply;
+	int type;
+
+	/* Round trips */
+	std::vector<uint64_t> rtts;
+	rtts.reserve(pings);
+
+	for (int i = 0; i < pings; ++i)
+	{
+		const uint64_t start = nowNs();
+
+		pushWait(out, Ping, msg);
+		popWait(in, type, reply);
+
+		rtts.push_back(nowNs() - start);
+	}
+
+	std::sort(rtts.begin(), rtts.end());
+
+	uint64_t sum = 0;
+
+	for (size_t i = 0; i < rtts.size(); ++i)
+		sum += rtts[i];
+
+	const size_t n = rtts.size();
+
+	if (n > 0)
+		printf("shm_ring round trip: %zu pings of %d bytes, mean %.2f us, "
+		       "p50 %.2f us, p99 %.2f us, max %.2f us\n",
+		       n, msgSize, sum / 1000.0 / n,
+		       rtts[n / 2] / 1000.0, rtts[n * 99 / 100] / 1000.0,
+		       rtts[n - 1] / 1000.0);
+
+	/* One-way stream */
+	const uint64_t start = nowNs();
+
+	for (int i = 0; i < messages; ++i)
+		pushWait(out, Stream, msg);
+
+	pushWait(out, StreamEnd, std::string());
+	popWait(in, type, reply);
+
+	const double secs = (nowNs() - start) / 1e9;
+
+	uint32_t streamed = 0;
+
+	if (reply.size() == sizeof(streamed))
+		memcpy(&streamed, reply.data(), sizeof(streamed));
+
+	printf("shm_ring stream: %u/%d messages of %d bytes in %.3f s, "
+	       "%.2f M msgs/sec, %.1f MiB/s\n",
+	       streamed, messages, msgSize, secs,
+	       streamed / secs / 1e6,
+	       (double) streamed * msgSize / secs / (1024 * 1024));
+
+	int status = 0;
+	waitpid(pid, &status, 0);
+
+	return WIFEXITED(status) && WEXITSTATUS(status) == 0
+	    && streamed == (uint32_t) messages ? 0 : 1;
+}
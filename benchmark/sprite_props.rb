@@ -0,0 +1,54 @@
+# Sprite property churn
+#
+# Sets x, y, z, opacity, angle, zoom_x and visible on a batch of
+# sprites over and over, then prints the time spent per setter call.
+# This is the path DEF_PROP_I/F/B accessors take from Ruby.
+#
+#   modshot --preloadScript=benchmark/sprite_props.rb
+#
+# SPRITES and ROUNDS (environment) change the load.
+
+module SpritePropsBench
+  SPRITES = (ENV['SPRITES'] || 500).to_i
+  ROUNDS  = (ENV['ROUNDS'] || 400).to_i
+
+  def self.clock
+    Process.clock_gettime(Process::CLOCK_MONOTONIC)
+  end
+
+  def self.run
+    bitmap = Bitmap.new(32, 32)
+    sprites = Array.new(SPRITES) do
+      sprite = Sprite.new
+      sprite.bitmap = bitmap
+      sprite
+    end
+
+    calls = 0
+    start = clock
+
+    ROUNDS.times do |r|
+      sprites.each_with_index do |sprite, i|
+        sprite.x = i + r
+        sprite.y = r
+        sprite.z = i
+        sprite.opacity = 255 - (r & 127)
+        sprite.angle = r * 0.5
+        sprite.zoom_x = 1.0 + (r & 3) * 0.25
+        sprite.visible = r.even?
+      end
+      calls += SPRITES * 7
+    end
+
+    elapsed = clock - start
+
+    MKXP.puts(format('sprite_props: %d setter calls in %.3f s, %.1f ns/call',
+                     calls, elapsed, elapsed * 1e9 / calls))
+  ensure
+    sprites.each(&:dispose) if sprites
+    bitmap.dispose if bitmap
+  end
+end
+
+SpritePropsBench.run
+exit
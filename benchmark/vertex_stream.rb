@@ -0,0 +1,66 @@
+# Streamed vertex uploads
+#
+# Animates the wave effect on a batch of sprites, which rebuilds
+# each sprite's vertex array every frame, and prints the buffer
+# uploads (GL calls), bytes and CPU time per frame.
+#
+#   modshot --preloadScript=benchmark/vertex_stream.rb
+#
+# Run once with the default vertexStreamSize and once with
+# --vertexStreamSize=0 (every array in its own buffer) to compare.
+# SPRITES and FRAMES (environment) change the load.
+
+module VertexStreamBench
+  SPRITES = (ENV['SPRITES'] || 300).to_i
+  FRAMES  = (ENV['FRAMES'] || 600).to_i
+
+  def self.cpu_clock
+    Process.clock_gettime(Process::CLOCK_PROCESS_CPUTIME_ID)
+  end
+
+  def self.run
+    bitmap = Bitmap.new(32, 128)
+    bitmap.fill_rect(bitmap.rect, Color.new(255, 255, 255))
+    sprites = Array.new(SPRITES) do |i|
+      sprite = Sprite.new
+      sprite.bitmap = bitmap
+      sprite.x = (i * 37) % 608
+      sprite.y = (i * 53) % 352
+      sprite.wave_amp = 8
+      sprite.wave_speed = 360
+      sprite
+    end
+
+    # Let the arrays settle into being treated as dynamic
+    10.times do
+      sprites.each(&:update)
+      Graphics.update
+    end
+
+    uploads = 0
+    bytes = 0
+    start = cpu_clock
+
+    FRAMES.times do
+      sprites.each(&:update)
+      Graphics.update
+      stats = Graphics.gl_call_stats
+      uploads += stats[5]
+      bytes += stats[6]
+    end
+
+    elapsed = cpu_clock - start
+
+    MKXP.puts(format('vertex_stream: %d sprites, %d frames: ' \
+                     '%.1f buffer uploads/frame, %.1f KiB/frame, ' \
+                     '%.3f ms CPU/frame',
+                     SPRITES, FRAMES, uploads.to_f / FRAMES,
+                     bytes / 1024.0 / FRAMES, elapsed * 1000 / FRAMES))
+  ensure
+    sprites.each(&:dispose) if sprites
+    bitmap.dispose if bitmap
+  end
+end
+
+VertexStreamBench.run
+exit
@@ -0,0 +1,87 @@
+# Window frame rendering
+#
+# Fades the back opacity of a set of windows every frame, each
+# at its own phase, then keeps opening and closing message sized
+# windows. Prints texture allocations, draw calls and CPU time
+# per frame for both phases.
+#
+#   modshot --preloadScript=benchmark/window_frames.rb
+#
+# Fading windows should re-render their frame in place and
+# reopened ones reuse the cached frame, so neither phase should
+# allocate textures once warmed up. WINDOWS and FRAMES
+# (environment) change the load.
+
+module WindowFramesBench
+  WINDOWS = (ENV['WINDOWS'] || 8).to_i
+  FRAMES  = (ENV['FRAMES'] || 600).to_i
+
+  def self.cpu_clock
+    Process.clock_gettime(Process::CLOCK_PROCESS_CPUTIME_ID)
+  end
+
+  def self.measure(name)
+    # Warm up, so first time allocations don't count
+    10.times { yield; Graphics.update }
+
+    allocs = 0
+    draws = 0
+    start = cpu_clock
+
+    FRAMES.times do |frame|
+      yield frame
+      Graphics.update
+      stats = Graphics.gl_call_stats
+      draws += stats[2]
+      allocs += stats[7]
+    end
+
+    elapsed = cpu_clock - start
+
+    MKXP.puts(format('window_frames %s: %d windows, %d frames: ' \
+                     '%.2f texture allocs/frame, %.1f draws/frame, ' \
+                     '%.3f ms CPU/frame',
+                     name, WINDOWS, FRAMES, allocs.to_f / FRAMES,
+                     draws.to_f / FRAMES, elapsed * 1000 / FRAMES))
+  end
+
+  def self.make_window(skin, i)
+    window = Window.new
+    window.windowskin = skin
+    window.x = (i * 40) % 320
+    window.y = (i * 24) % 320
+    window.width = 320
+    window.height = 128
+    window
+  end
+
+  def self.run
+    skin = Bitmap.new(192, 128)
+    skin.fill_rect(0, 0, 128, 128, Color.new(40, 40, 80))
+    skin.fill_rect(128, 0, 64, 64, Color.new(220, 220, 220))
+
+    windows = Array.new(WINDOWS) { |i| make_window(skin, i) }
+
+    tick = 0
+    measure('fade') do
+      tick += 1
+      windows.each_with_index do |window, i|
+        window.back_opacity = (tick * 4 + i * 32) % 256
+      end
+    end
+
+    windows.each { |window| window.back_opacity = 160 }
+
+    measure('reopen') do |frame|
+      next unless frame && frame % 4 == 0
+      windows.each(&:dispose)
+      windows = Array.new(WINDOWS) { |i| make_window(skin, i) }
+    end
+  ensure
+    windows.each(&:dispose) if windows
+    skin.dispose if skin
+  end
+end
+
+WindowFramesBench.run
+exit
@@ -31,6 +31,7 @@
 #include "audio.h"
 #include "boost-hash.h"
 #include "version.h"
+#include "desktopworker.h"
 
 #include "otherview-message.h"
 
@@ -64,12 +65,15 @@ ScriptBinding scriptBindingImpl =
 ScriptBinding *scriptBinding = &scriptBindingImpl;
 
 void tableBindingInit();
+void eventGridBindingInit();
+void pathfinderBindingInit();
 void etcBindingInit();
 void fontBindingInit();
 void bitmapBindingInit();
 void spriteBindingInit();
 void viewportBindingInit();
 void planeBindingInit();
+void particleSystemBindingInit();
 void windowBindingInit();
 void tilemapBindingInit();
 void windowVXBindingInit();
@@ -109,12 +113,15 @@ RB_METHOD(_kernelCaller);
 static void mriBindingInit()
 {
 	tableBindingInit();
+	eventGridBindingInit();
+	pathfinderBindingInit();
 	etcBindingInit();
 	fontBindingInit();
 	bitmapBindingInit();
 	spriteBindingInit();
 	viewportBindingInit();
 	planeBindingInit();
+	particleSystemBindingInit();
 
 	windowBindingInit();
 	tilemapBindingInit();
@@ -716,15 +723,20 @@ static void mriBindingExecute()
 
 	ruby_cleanup(0);
 
+	/* at_exit handlers may have queued desktop requests (eg.
+	 * restoring the wallpaper); let them finish while the
+	 * engine is still around */
+	DesktopWorker::instance().wait();
+#ifdef __linux__
+	wallpaperBindingTerminate();
+#endif
+
 	shState->rtData().rqTermAck.set();
 }
 
 static void mriBindingTerminate()
 {
 	rb_raise(rb_eSystemExit, " ");
-#ifdef __linux__
-	wallpaperBindingTerminate();
-#endif
 }
 
 static void mriBindingReset()
@@ -25,6 +25,7 @@
 #include "binding-util.h"
 
 DECL_TYPE(Table);
+DECL_TYPE(EventGrid);
 DECL_TYPE(Rect);
 DECL_TYPE(Color);
 DECL_TYPE(Tone);
@@ -399,6 +399,73 @@ inline void rb_check_argc(int actual, int expected) {
                  expected);
 }
 
+/* Compile-time counterpart to 'rb_get_args': the format is derived
+ * from the pointer types passed in, so no format string is parsed and
+ * no varargs are walked at runtime. Supported argument types:
+ *   VALUE*       -> 'o'
+ *   int*         -> 'i'
+ *   double*      -> 'f'
+ *   bool*        -> 'b'
+ *   const char** -> 'z'
+ * 'Required' is the amount of mandatory arguments (the position of
+ * '|' in an equivalent format string); by default all are required.
+ * Returns the number of arguments that were read. */
+template<typename T>
+struct RbArgConv;
+
+template<>
+struct RbArgConv<VALUE> {
+    static inline void get(VALUE arg, VALUE *out, int) { *out = arg; }
+};
+
+template<>
+struct RbArgConv<int> {
+    static inline void get(VALUE arg, int *out, int argPos) {
+        rb_int_arg(arg, out, argPos);
+    }
+};
+
+template<>
+struct RbArgConv<double> {
+    static inline void get(VALUE arg, double *out, int argPos) {
+        rb_float_arg(arg, out, argPos);
+    }
+};
+
+template<>
+struct RbArgConv<bool> {
+    static inline void get(VALUE arg, bool *out, int argPos) {
+        rb_bool_arg(arg, out, argPos);
+    }
+};
+
+template<>
+struct RbArgConv<const char *> {
+    static inline void get(VALUE arg, const char **out, int) {
+        *out = RSTRING_PTR(rb_str_to_str(arg));
+    }
+};
+
+template<int Required = -1, typename... Args>
+inline int rb_get_typed_args(int argc, VALUE *argv, Args *...out) {
+    const int argMax = sizeof...(Args);
+    const int argMin = (Required < 0) ? argMax : Required;
+    
+    static_assert(Required <= argMax, "more required arguments than outputs");
+    
+    // FIXME print num of needed args vs provided
+    if (argc < argMin || argc > argMax)
+        rb_raise(rb_eArgError, "wrong number of arguments");
+    
+    int argI = 0;
+    int expand[] = { 0, (argI < argc
+                         ? (RbArgConv<Args>::get(argv[argI], out, argI), ++argI)
+                         : argI)... };
+    (void) expand;
+    
+    return argI;
+}
+
 #if RAPI_MAJOR < 2
 static inline void rb_error_arity(int argc, int min, int max) {
     if (argc > max || argc < min)
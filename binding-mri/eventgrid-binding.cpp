@@ -0,0 +1,226 @@
+/*
+** eventgrid-binding.cpp
+**
+** This file is part of mkxp.
+**
+** Copyright (C) 2013 Jonas Kulla <Nyocurio@gmail.com>
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "eventgrid.h"
+#include "table.h"
+#include "binding-util.h"
+#include "binding-types.h"
+#include "serializable-binding.h"
+
+DEF_TYPE(EventGrid);
+
+RB_METHOD(eventGridInitialize)
+{
+	int width, height;
+	rb_get_typed_args<2>(argc, argv, &width, &height);
+
+	EventGrid *g = new EventGrid(width, height);
+
+	setPrivateData(self, g);
+
+	return self;
+}
+
+/* Array of [ox, oy] pairs, like Game_Event#collision */
+static void footprintFromValue(VALUE ary, std::vector<Vec2i> &out)
+{
+	Check_Type(ary, T_ARRAY);
+
+	out.clear();
+	out.reserve(RARRAY_LEN(ary));
+
+	for (long i = 0; i < RARRAY_LEN(ary); ++i)
+	{
+		VALUE pair = rb_ary_entry(ary, i);
+		Check_Type(pair, T_ARRAY);
+
+		out.push_back(Vec2i(NUM2INT(rb_ary_entry(pair, 0)),
+		                    NUM2INT(rb_ary_entry(pair, 1))));
+	}
+}
+
+static VALUE idsToArray(const std::vector<int> &ids)
+{
+	VALUE ary = rb_ary_new2(ids.size());
+
+	for (size_t i = 0; i < ids.size(); ++i)
+		rb_ary_push(ary, INT2FIX(ids[i]));
+
+	return ary;
+}
+
+/* insert(id, x, y [, tile_id, through, no_graphic [, footprint]]) */
+RB_METHOD(eventGridInsert)
+{
+	EventGrid *g = getPrivateData<EventGrid>(self);
+
+	int id, x, y;
+	int tileId = 0;
+	bool through = false, noGraphic = false;
+	VALUE footprintObj = Qnil;
+
+	int count = rb_get_typed_args<3>(argc, argv, &id, &x, &y,
+	                                 &tileId, &through, &noGraphic,
+	                                 &footprintObj);
+
+	g->insert(id, x, y);
+
+	if (count > 3)
+		g->setState(id, tileId, through, noGraphic);
+
+	if (!NIL_P(footprintObj))
+	{
+		std::vector<Vec2i> footprint;
+		footprintFromValue(footprintObj, footprint);
+
+		g->setFootprint(id, footprint);
+	}
+
+	return self;
+}
+
+RB_METHOD(eventGridMove)
+{
+	EventGrid *g = getPrivateData<EventGrid>(self);
+
+	int id, x, y;
+	rb_get_typed_args<3>(argc, argv, &id, &x, &y);
+
+	g->move(id, x, y);
+
+	return self;
+}
+
+RB_METHOD(eventGridRemove)
+{
+	EventGrid *g = getPrivateData<EventGrid>(self);
+
+	int id;
+	rb_get_typed_args<1>(argc, argv, &id);
+
+	g->remove(id);
+
+	return self;
+}
+
+RB_METHOD(eventGridSetState)
+{
+	EventGrid *g = getPrivateData<EventGrid>(self);
+
+	int id, tileId;
+	bool through, noGraphic;
+	rb_get_typed_args<4>(argc, argv, &id, &tileId, &through, &noGraphic);
+
+	g->setState(id, tileId, through, noGraphic);
+
+	return self;
+}
+
+RB_METHOD(eventGridClear)
+{
+	RB_UNUSED_PARAM;
+
+	EventGrid *g = getPrivateData<EventGrid>(self);
+
+	g->clear();
+
+	return self;
+}
+
+RB_METHOD(eventGridGetAt)
+{
+	EventGrid *g = getPrivateData<EventGrid>(self);
+
+	int x, y;
+	rb_get_typed_args<2>(argc, argv, &x, &y);
+
+	return idsToArray(g->at(x, y));
+}
+
+RB_METHOD(eventGridCovering)
+{
+	EventGrid *g = getPrivateData<EventGrid>(self);
+
+	int x, y;
+	rb_get_typed_args<2>(argc, argv, &x, &y);
+
+	return idsToArray(g->covering(x, y));
+}
+
+/* passable?(data, passages, priorities, x, y, d [, self_id]) */
+RB_METHOD(eventGridPassable)
+{
+	EventGrid *g = getPrivateData<EventGrid>(self);
+
+	VALUE dataObj, passagesObj, prioritiesObj;
+	int x, y, d;
+	int selfId = 0;
+
+	rb_get_typed_args<6>(argc, argv, &dataObj, &passagesObj,
+	                     &prioritiesObj, &x, &y, &d, &selfId);
+
+	Table *data = getPrivateDataCheck<Table>(dataObj, TableType);
+	Table *passages = getPrivateDataCheck<Table>(passagesObj, TableType);
+	Table *priorities = getPrivateDataCheck<Table>(prioritiesObj, TableType);
+
+	return rb_bool_new(g->passable(*data, *passages, *priorities,
+	                               x, y, d, selfId));
+}
+
+#define EVENTGRID_GETTER(name, Name) \
+	RB_METHOD(eventGrid##Name) \
+	{ \
+		RB_UNUSED_PARAM \
+		EventGrid *g = getPrivateData<EventGrid>(self); \
+		return INT2NUM(g->name()); \
+	}
+
+EVENTGRID_GETTER(width, Width)
+EVENTGRID_GETTER(height, Height)
+EVENTGRID_GETTER(count, Count)
+
+MARSH_LOAD_FUN(EventGrid)
+INITCOPY_FUN(EventGrid)
+
+void
+eventGridBindingInit()
+{
+	VALUE klass = rb_define_class("EventGrid", rb_cObject);
+	rb_define_alloc_func(klass, classAllocate<&EventGridType>);
+
+	serializableBindingInit<EventGrid>(klass);
+
+	rb_define_class_method(klass, "_load", EventGridLoad);
+
+	_rb_define_method(klass, "initialize", eventGridInitialize);
+	_rb_define_method(klass, "initialize_copy", EventGridInitializeCopy);
+	_rb_define_method(klass, "insert", eventGridInsert);
+	_rb_define_method(klass, "move", eventGridMove);
+	_rb_define_method(klass, "remove", eventGridRemove);
+	_rb_define_method(klass, "set_state", eventGridSetState);
+	_rb_define_method(klass, "clear", eventGridClear);
+	_rb_define_method(klass, "[]", eventGridGetAt);
+	_rb_define_method(klass, "covering", eventGridCovering);
+	_rb_define_method(klass, "passable?", eventGridPassable);
+	_rb_define_method(klass, "width", eventGridWidth);
+	_rb_define_method(klass, "height", eventGridHeight);
+	_rb_define_method(klass, "count", eventGridCount);
+}
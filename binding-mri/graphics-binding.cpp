@@ -21,6 +21,7 @@
 
 #include "graphics.h"
 #include "sharedstate.h"
+#include "glstate.h"
 #include "binding-util.h"
 #include "binding-types.h"
 #include "exception.h"
@@ -117,6 +118,31 @@ RB_METHOD(graphicsHeight)
 	return rb_fix_new(shState->graphics().height());
 }
 
+/* [issued, elided, draws, tex_uploads, tex_bytes, buf_uploads, buf_bytes,
+ *  tex_allocs] for the last presented frame (see GLCallStats) */
+RB_METHOD(graphicsGLCallStats)
+{
+	RB_UNUSED_PARAM;
+
+	const GLCallStats &stats = GLState::frameStats();
+
+	return rb_ary_new3(8, UINT2NUM(stats.issued), UINT2NUM(stats.elided),
+	                   UINT2NUM(stats.draws),
+	                   UINT2NUM(stats.texUploads), UINT2NUM(stats.uploadBytes),
+	                   UINT2NUM(stats.bufUploads), UINT2NUM(stats.bufBytes),
+	                   UINT2NUM(stats.texAllocs));
+}
+
+RB_METHOD(graphicsFrameTimeStats)
+{
+	RB_UNUSED_PARAM;
+
+	double p50, p99, max;
+	shState->graphics().frameTimeStats(p50, p99, max);
+
+	return rb_ary_new3(3, rb_float_new(p50), rb_float_new(p99), rb_float_new(max));
+}
+
 RB_METHOD(graphicsWait)
 {
 	RB_UNUSED_PARAM;
@@ -234,6 +260,8 @@ void graphicsBindingInit()
 	//{
 	_rb_define_module_function(module, "width", graphicsWidth);
 	_rb_define_module_function(module, "height", graphicsHeight);
+	_rb_define_module_function(module, "gl_call_stats", graphicsGLCallStats);
+	_rb_define_module_function(module, "frame_time_stats", graphicsFrameTimeStats);
 	_rb_define_module_function(module, "wait", graphicsWait);
 	_rb_define_module_function(module, "fadeout", graphicsFadeout);
 	_rb_define_module_function(module, "fadein", graphicsFadein);
@@ -124,6 +124,50 @@ RB_METHOD(inputQuit)
 	return rb_bool_new(shState->input().hasQuit());
 }
 
+/* raw_events -> [[type, code, time], ...]
+ * Key codes are given as Input::KEY_* button codes,
+ * times in microseconds on the same clock as raw_time */
+RB_METHOD(inputRawEvents)
+{
+	RB_UNUSED_PARAM;
+
+	static const char *typeNames[] =
+	{
+		"key_down", "key_up",
+		"mouse_down", "mouse_up",
+		"controller_down", "controller_up",
+		"joystick_down", "joystick_up"
+	};
+
+	const std::vector<InputEvent> &events = shState->input().rawEvents();
+	VALUE ary = rb_ary_new2(events.size());
+
+	for (size_t i = 0; i < events.size(); ++i)
+	{
+		const InputEvent &e = events[i];
+		int code = e.code;
+
+		if (e.type == InputEvent::KeyDown || e.type == InputEvent::KeyUp)
+			code = e.keySlot - SDL_NUM_SCANCODES + BUTTONCODE_SDLK_OFFSET;
+
+		VALUE ev = rb_ary_new2(3);
+		rb_ary_push(ev, ID2SYM(rb_intern(typeNames[e.type])));
+		rb_ary_push(ev, INT2FIX(code));
+		rb_ary_push(ev, ULL2NUM(e.time));
+
+		rb_ary_push(ary, ev);
+	}
+
+	return ary;
+}
+
+RB_METHOD(inputRawTime)
+{
+	RB_UNUSED_PARAM;
+
+	return ULL2NUM(EventThread::inputClock());
+}
+
 RB_METHOD(inputModkeys) {
 	RB_UNUSED_PARAM;
 	return INT2FIX(shState->input().modkeys);
@@ -555,6 +599,9 @@ inputBindingInit()
 
 	_rb_define_module_function(module, "quit?", inputQuit);
 
+	_rb_define_module_function(module, "raw_events", inputRawEvents);
+	_rb_define_module_function(module, "raw_time", inputRawTime);
+
 	_rb_define_module_function(module, "start_text_input", inputStartTextInput);
 	_rb_define_module_function(module, "stop_text_input", inputStopTextInput);
 	_rb_define_module_function(module, "text_input", inputTextInput);
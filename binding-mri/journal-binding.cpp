@@ -46,6 +46,19 @@ static volatile int message_len = 0;
 		unlink(PIPE_PATH.c_str());
 		remove(PIPE_PATH.c_str());
 	}
+
+	/* Framed like Pipe::writeMessage (32 bit host order length,
+	 * then the payload) in a single write, so the journal can
+	 * tell back to back messages apart. An empty message
+	 * tells it to close */
+	static ssize_t write_message(int fd, const char *data, uint32_t size)
+	{
+		std::vector<char> frame(sizeof(size) + size);
+		memcpy(&frame[0], &size, sizeof(size));
+		memcpy(&frame[sizeof(size)], data, size);
+
+		return write(fd, &frame[0], frame.size());
+	}
 #endif
 
 int server_thread(void *data)
@@ -79,7 +92,7 @@ int server_thread(void *data)
 		active = true;
 		if (message_len > 0)
 		{
-			if (write(out_pipe, (char*)message_buffer, message_len) == -1)
+			if (write_message(out_pipe, (char*)message_buffer, message_len) == -1)
 			{
 				Debug() << "Failure writing to journal's pipe!";
 			}
@@ -135,7 +148,7 @@ RB_METHOD(journalSet)
 	// Attempt to send it over the tubes
 	if (out_pipe != -1) {
 		// We have a connection, so send it over
-		if (write(out_pipe, (char*)message_buffer, message_len) <= 0) {
+		if (write_message(out_pipe, (char*)message_buffer, message_len) <= 0) {
 			// In the case of an error, close
 			close(out_pipe);
 			out_pipe = -1;
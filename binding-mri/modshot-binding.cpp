@@ -6,6 +6,7 @@
 #include "binding-types.h"
 #include "eventthread.h"
 #include "debugwriter.h"
+#include "desktopworker.h"
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
@@ -98,6 +99,9 @@ RB_METHOD(modwindowSetTransparentColor)
 }
 */
 
+// Notifications are sent from the desktop worker thread (registering
+// the app alone can take a D-Bus round trip); returns a ticket that can
+// be checked with ModShot.notify_done?
 RB_METHOD(modshotNotify)
 {
 	RB_UNUSED_PARAM;
@@ -106,49 +110,67 @@ RB_METHOD(modshotNotify)
 	VALUE icon = Qnil;
 	rb_get_args(argc, argv, "zz|o", &title, &info, &icon RB_ARG_END);
 
-#ifdef _WIN32
-	if (!notifi.hasTrayIcon)
-		notifi.addTrayIcon("OneShot");
-#elif defined __linux__
-	if (!notifi.hasGApp)
-		notifi.regApp("org.ModShot.Notifier");
-#endif
+	std::string titleStr(title);
+	std::string infoStr(info);
+	int iconId = 0;
+	std::string iconPath;
+	bool hasIconPath = false;
 
 	switch (TYPE(icon))
 	{
-		case T_NIL:
-			notifi.send(title, info, 0, NULL);
-			break;
 		case T_FIXNUM:
-			notifi.send(title, info, NUM2INT(icon), NULL);
+			iconId = NUM2INT(icon);
 			break;
 		case T_STRING:
-		{
-			std::string iconStr = std::string(RSTRING_PTR(icon), RSTRING_LEN(icon));
-			notifi.send(title, info, 0, iconStr.c_str());
+			iconPath = std::string(RSTRING_PTR(icon), RSTRING_LEN(icon));
+			hasIconPath = true;
 			break;
-		}
 		default:
-			notifi.send(title, info, 0, NULL);
 			break;
 	}
 
-	return Qnil;
+	unsigned int ticket = DesktopWorker::instance().post([=]() {
+#ifdef _WIN32
+		if (!notifi.hasTrayIcon)
+			notifi.addTrayIcon("OneShot");
+#elif defined __linux__
+		if (!notifi.hasGApp)
+			notifi.regApp("org.ModShot.Notifier");
+#endif
+
+		notifi.send(titleStr.c_str(), infoStr.c_str(), iconId,
+		            hasIconPath ? iconPath.c_str() : NULL);
+	});
+
+	return UINT2NUM(ticket);
 }
 
 RB_METHOD(modshotNotifyCleanup)
 {
 	RB_UNUSED_PARAM;
 
+	unsigned int ticket = DesktopWorker::instance().post([]() {
 #ifdef _WIN32
-	if (notifi.hasTrayIcon)
-		notifi.delTrayIcon();
+		if (notifi.hasTrayIcon)
+			notifi.delTrayIcon();
 #elif defined __linux__
-	if (notifi.hasGApp)
-		notifi.quitApp();
+		if (notifi.hasGApp)
+			notifi.quitApp();
 #endif
+	});
 
-	return Qnil;
+	return UINT2NUM(ticket);
+}
+
+// notify_done?([ticket]) -> whether that request (or all of them) went through
+RB_METHOD(modshotNotifyDone)
+{
+	RB_UNUSED_PARAM;
+	VALUE ticket = Qnil;
+	rb_get_args(argc, argv, "|o", &ticket RB_ARG_END);
+	if (NIL_P(ticket))
+		return rb_bool_new(DesktopWorker::instance().idle());
+	return rb_bool_new(DesktopWorker::instance().finished(NUM2UINT(ticket)));
 }
 
 void modshotBindingInit()
@@ -159,6 +181,7 @@ void modshotBindingInit()
 	// ModShot:: module functions
 	_rb_define_module_function(modshot_module, "notify", modshotNotify);
 	_rb_define_module_function(modshot_module, "notify_cleanup", modshotNotifyCleanup);
+	_rb_define_module_function(modshot_module, "notify_done?", modshotNotifyDone);
 
 	// ModWindow:: module functions
 	_rb_define_module_function(modwindow_module, "GetWindowSize", GetWindowSize);
@@ -1,6 +1,19 @@
 module RPG
   module Cache
     @cache = {}
+    # Baked hue variants are full texture copies, so only the most
+    # recently used ones are kept. Sprites can use Sprite#hue with
+    # the base bitmap instead to avoid baking entirely.
+    HUE_CACHE_SIZE = 16
+    @hue_cache = {}
+    def self.hue_variant(key)
+      bitmap = @hue_cache.delete(key)
+      if bitmap.nil? or bitmap.disposed?
+        bitmap = yield
+        @hue_cache.shift while @hue_cache.size >= HUE_CACHE_SIZE
+      end
+      @hue_cache[key] = bitmap
+    end
     def self.load_bitmap(folder_name, filename, hue = 0)
       path = folder_name + filename
       if not @cache.include?(path) or @cache[path].disposed?
@@ -13,12 +26,11 @@ module RPG
       if hue == 0
         @cache[path]
       else
-        key = [path, hue]
-        if not @cache.include?(key) or @cache[key].disposed?
-          @cache[key] = @cache[path].clone
-          @cache[key].hue_change(hue)
+        self.hue_variant([path, hue]) do
+          bitmap = @cache[path].clone
+          bitmap.hue_change(hue)
+          bitmap
         end
-        @cache[key]
       end
     end
     def self.animation(filename, hue)
@@ -74,6 +86,7 @@ module RPG
     end
     def self.clear
       @cache = {}
+      @hue_cache = {}
       GC.start
     end
   end
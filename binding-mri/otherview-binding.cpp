@@ -5,29 +5,52 @@
 #include "otherview-message.h"
 #include "debugwriter.h"
 
+// send(message[, type]); messages may hold binary data
 RB_METHOD(sendMessage)
 {
     OtherViewMessager &messager = shState->otherView();
 
     const char* message;
-    rb_get_args(argc, argv, "z", &message RB_ARG_END);
-    Debug() << "Sending message: " << message;
+    int len;
+    int type = 0;
+    rb_get_args(argc, argv, "s|i", &message, &len, &type RB_ARG_END);
 
-    bool ret = messager.sendMsg(message);
+    bool ret = messager.sendMsg(message, len, type);
 
     return rb_bool_new(ret);
 }
 RB_METHOD(readMessage) 
 {
     OtherViewMessager &messager = shState->otherView();
-    VALUE rtn = rb_str_new_cstr(messager.getMsg().c_str());
+    std::string msg = messager.getMsg();
+    VALUE rtn = rb_str_new(msg.data(), msg.size());
     return rtn;
 }
 
 
+// All messages received so far, as [type, message] pairs
+RB_METHOD(drainMessages)
+{
+    RB_UNUSED_PARAM;
+    OtherViewMessager &messager = shState->otherView();
+
+    std::vector<OtherViewMessager::Message> messages;
+    messager.drain(messages);
+
+    VALUE ary = rb_ary_new2(messages.size());
+    for (size_t i = 0; i < messages.size(); ++i) {
+        const OtherViewMessager::Message &m = messages[i];
+        VALUE pair = rb_ary_new3(2, INT2NUM(m.type),
+                                 rb_str_new(m.data.data(), m.data.size()));
+        rb_ary_push(ary, pair);
+    }
+    return ary;
+}
+
 void otherviewBindingInit()
 {
     VALUE module = rb_define_module("OtherView");
     _rb_define_module_function(module, "send", sendMessage);
     _rb_define_module_function(module, "read", readMessage);
+    _rb_define_module_function(module, "drain", drainMessages);
 }
\ No newline at end of file
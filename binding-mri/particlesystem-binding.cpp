@@ -0,0 +1,241 @@
+/*
+** particlesystem-binding.cpp
+**
+** This file is part of mkxp.
+**
+** Copyright (C) 2013 Jonas Kulla <Nyocurio@gmail.com>
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "particlesystem.h"
+#include "disposable-binding.h"
+#include "viewportelement-binding.h"
+#include "binding-util.h"
+#include "binding-types.h"
+
+DEF_TYPE(ParticleSystem);
+
+RB_METHOD(particleSystemInitialize)
+{
+	ParticleSystem *p = viewportElementInitialize<ParticleSystem>(argc, argv, self);
+
+	setPrivateData(self, p);
+
+	/* Wrap property objects */
+	p->initDynAttribs();
+
+	wrapProperty(self, &p->getColor(), "color", ColorType);
+	wrapProperty(self, &p->getTone(), "tone", ToneType);
+
+	return self;
+}
+
+RB_METHOD(particleSystemUpdate)
+{
+	RB_UNUSED_PARAM;
+
+	ParticleSystem *p = getPrivateData<ParticleSystem>(self);
+
+	GUARD_EXC( p->update(); );
+
+	return Qnil;
+}
+
+RB_METHOD(particleSystemEmit)
+{
+	ParticleSystem *p = getPrivateData<ParticleSystem>(self);
+
+	int count;
+	rb_get_typed_args<1>(argc, argv, &count);
+
+	GUARD_EXC( p->emit(count); );
+
+	return self;
+}
+
+RB_METHOD(particleSystemShift)
+{
+	ParticleSystem *p = getPrivateData<ParticleSystem>(self);
+
+	double dx, dy;
+	rb_get_typed_args<2>(argc, argv, &dx, &dy);
+
+	GUARD_EXC( p->shift(dx, dy); );
+
+	return self;
+}
+
+RB_METHOD(particleSystemClear)
+{
+	RB_UNUSED_PARAM;
+
+	ParticleSystem *p = getPrivateData<ParticleSystem>(self);
+
+	GUARD_EXC( p->clear(); );
+
+	return self;
+}
+
+RB_METHOD(particleSystemGetCount)
+{
+	RB_UNUSED_PARAM;
+
+	ParticleSystem *p = getPrivateData<ParticleSystem>(self);
+
+	int count = 0;
+	GUARD_EXC( count = p->getCount(); );
+
+	return rb_fix_new(count);
+}
+
+RB_METHOD(particleSystemSetEmitArea)
+{
+	ParticleSystem *p = getPrivateData<ParticleSystem>(self);
+
+	int x, y, width, height;
+	rb_get_typed_args<4>(argc, argv, &x, &y, &width, &height);
+
+	GUARD_EXC( p->setEmitArea(x, y, width, height); );
+
+	return self;
+}
+
+RB_METHOD(particleSystemSetVelocity)
+{
+	ParticleSystem *p = getPrivateData<ParticleSystem>(self);
+
+	double minX, maxX, minY, maxY;
+	rb_get_typed_args<4>(argc, argv, &minX, &maxX, &minY, &maxY);
+
+	GUARD_EXC( p->setVelocity(minX, maxX, minY, maxY); );
+
+	return self;
+}
+
+RB_METHOD(particleSystemSetLifetime)
+{
+	ParticleSystem *p = getPrivateData<ParticleSystem>(self);
+
+	int min, max;
+	rb_get_typed_args<2>(argc, argv, &min, &max);
+
+	GUARD_EXC( p->setLifetime(min, max); );
+
+	return self;
+}
+
+RB_METHOD(particleSystemSetScale)
+{
+	ParticleSystem *p = getPrivateData<ParticleSystem>(self);
+
+	double min, max;
+	rb_get_typed_args<2>(argc, argv, &min, &max);
+
+	GUARD_EXC( p->setScale(min, max); );
+
+	return self;
+}
+
+RB_METHOD(particleSystemSetScaleCurve)
+{
+	ParticleSystem *p = getPrivateData<ParticleSystem>(self);
+
+	double start, end;
+	rb_get_typed_args<2>(argc, argv, &start, &end);
+
+	GUARD_EXC( p->setScaleCurve(start, end); );
+
+	return self;
+}
+
+RB_METHOD(particleSystemSetOpacityCurve)
+{
+	ParticleSystem *p = getPrivateData<ParticleSystem>(self);
+
+	double start, end;
+	rb_get_typed_args<2>(argc, argv, &start, &end);
+
+	GUARD_EXC( p->setOpacityCurve(start, end); );
+
+	return self;
+}
+
+RB_METHOD(particleSystemSetWave)
+{
+	ParticleSystem *p = getPrivateData<ParticleSystem>(self);
+
+	int min, max;
+	rb_get_typed_args<2>(argc, argv, &min, &max);
+
+	GUARD_EXC( p->setWave(min, max); );
+
+	return self;
+}
+
+DEF_PROP_OBJ_REF(ParticleSystem, Bitmap, Bitmap, "bitmap")
+
+DEF_PROP_OBJ_VAL(ParticleSystem, Color, Color, "color")
+DEF_PROP_OBJ_VAL(ParticleSystem, Tone,  Tone,  "tone")
+
+DEF_PROP_I(ParticleSystem, Opacity)
+DEF_PROP_I(ParticleSystem, BlendType)
+DEF_PROP_I(ParticleSystem, MaxParticles)
+DEF_PROP_I(ParticleSystem, WrapWidth)
+DEF_PROP_I(ParticleSystem, WrapHeight)
+
+DEF_PROP_F(ParticleSystem, EmitRate)
+DEF_PROP_F(ParticleSystem, AccelX)
+DEF_PROP_F(ParticleSystem, AccelY)
+
+DEF_PROP_B(ParticleSystem, RandomSign)
+DEF_PROP_B(ParticleSystem, Wrap)
+
+void
+particleSystemBindingInit()
+{
+	VALUE klass = rb_define_class("ParticleSystem", rb_cObject);
+	rb_define_alloc_func(klass, classAllocate<&ParticleSystemType>);
+
+	disposableBindingInit<ParticleSystem>     (klass);
+	viewportElementBindingInit<ParticleSystem>(klass);
+
+	_rb_define_method(klass, "initialize",        particleSystemInitialize);
+	_rb_define_method(klass, "update",            particleSystemUpdate);
+	_rb_define_method(klass, "emit",              particleSystemEmit);
+	_rb_define_method(klass, "shift",             particleSystemShift);
+	_rb_define_method(klass, "clear",             particleSystemClear);
+	_rb_define_method(klass, "count",             particleSystemGetCount);
+	_rb_define_method(klass, "set_emit_area",     particleSystemSetEmitArea);
+	_rb_define_method(klass, "set_velocity",      particleSystemSetVelocity);
+	_rb_define_method(klass, "set_lifetime",      particleSystemSetLifetime);
+	_rb_define_method(klass, "set_scale",         particleSystemSetScale);
+	_rb_define_method(klass, "set_scale_curve",   particleSystemSetScaleCurve);
+	_rb_define_method(klass, "set_opacity_curve", particleSystemSetOpacityCurve);
+	_rb_define_method(klass, "set_wave",          particleSystemSetWave);
+
+	INIT_PROP_BIND( ParticleSystem, Bitmap,       "bitmap"        );
+	INIT_PROP_BIND( ParticleSystem, Opacity,      "opacity"       );
+	INIT_PROP_BIND( ParticleSystem, BlendType,    "blend_type"    );
+	INIT_PROP_BIND( ParticleSystem, MaxParticles, "max_particles" );
+	INIT_PROP_BIND( ParticleSystem, EmitRate,     "emit_rate"     );
+	INIT_PROP_BIND( ParticleSystem, AccelX,       "accel_x"       );
+	INIT_PROP_BIND( ParticleSystem, AccelY,       "accel_y"       );
+	INIT_PROP_BIND( ParticleSystem, RandomSign,   "random_sign"   );
+	INIT_PROP_BIND( ParticleSystem, Wrap,         "wrap"          );
+	INIT_PROP_BIND( ParticleSystem, WrapWidth,    "wrap_width"    );
+	INIT_PROP_BIND( ParticleSystem, WrapHeight,   "wrap_height"   );
+	INIT_PROP_BIND( ParticleSystem, Color,        "color"         );
+	INIT_PROP_BIND( ParticleSystem, Tone,         "tone"          );
+}
@@ -0,0 +1,150 @@
+/*
+** pathfinder-binding.cpp
+**
+** This file is part of mkxp.
+**
+** Copyright (C) 2013 Jonas Kulla <Nyocurio@gmail.com>
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pathfinder.h"
+#include "eventgrid.h"
+#include "table.h"
+#include "binding-util.h"
+#include "binding-types.h"
+
+/* Default A* expansion budget per query */
+#define PATH_MAX_NODES 4096
+
+DEF_TYPE(FlowField);
+
+static Pathfinder pathfinderFromArgs(VALUE gridObj, VALUE dataObj,
+                                     VALUE passagesObj, VALUE prioritiesObj)
+{
+	EventGrid *grid = getPrivateDataCheck<EventGrid>(gridObj, EventGridType);
+	Table *data = getPrivateDataCheck<Table>(dataObj, TableType);
+	Table *passages = getPrivateDataCheck<Table>(passagesObj, TableType);
+	Table *priorities = getPrivateDataCheck<Table>(prioritiesObj, TableType);
+
+	return Pathfinder(*grid, *data, *passages, *priorities);
+}
+
+/* find_path(grid, data, passages, priorities, sx, sy, tx, ty
+ *           [, self_id, max_nodes]) -> Array of directions or nil */
+RB_METHOD(pathfinderFindPath)
+{
+	RB_UNUSED_PARAM;
+
+	VALUE gridObj, dataObj, passagesObj, prioritiesObj;
+	int sx, sy, tx, ty;
+	int selfId = 0, maxNodes = PATH_MAX_NODES;
+
+	rb_get_typed_args<8>(argc, argv, &gridObj, &dataObj, &passagesObj,
+	                     &prioritiesObj, &sx, &sy, &tx, &ty,
+	                     &selfId, &maxNodes);
+
+	Pathfinder pf = pathfinderFromArgs(gridObj, dataObj,
+	                                   passagesObj, prioritiesObj);
+
+	std::vector<int> dirs;
+
+	if (!pf.findPath(sx, sy, tx, ty, selfId, maxNodes, dirs))
+		return Qnil;
+
+	VALUE ary = rb_ary_new2(dirs.size());
+
+	for (size_t i = 0; i < dirs.size(); ++i)
+		rb_ary_push(ary, INT2FIX(dirs[i]));
+
+	return ary;
+}
+
+RB_METHOD(flowFieldInitialize)
+{
+	RB_UNUSED_PARAM;
+
+	FlowField *f = new FlowField();
+
+	setPrivateData(self, f);
+
+	return self;
+}
+
+/* update(grid, data, passages, priorities, tx, ty) */
+RB_METHOD(flowFieldUpdate)
+{
+	FlowField *f = getPrivateData<FlowField>(self);
+
+	VALUE gridObj, dataObj, passagesObj, prioritiesObj;
+	int tx, ty;
+
+	rb_get_typed_args(argc, argv, &gridObj, &dataObj, &passagesObj,
+	                  &prioritiesObj, &tx, &ty);
+
+	Pathfinder pf = pathfinderFromArgs(gridObj, dataObj,
+	                                   passagesObj, prioritiesObj);
+
+	f->update(pf, tx, ty);
+
+	return self;
+}
+
+RB_METHOD(flowFieldInvalidate)
+{
+	RB_UNUSED_PARAM;
+
+	FlowField *f = getPrivateData<FlowField>(self);
+
+	f->invalidate();
+
+	return self;
+}
+
+RB_METHOD(flowFieldDirection)
+{
+	FlowField *f = getPrivateData<FlowField>(self);
+
+	int x, y;
+	rb_get_typed_args(argc, argv, &x, &y);
+
+	return INT2FIX(f->direction(x, y));
+}
+
+RB_METHOD(flowFieldDistance)
+{
+	FlowField *f = getPrivateData<FlowField>(self);
+
+	int x, y;
+	rb_get_typed_args(argc, argv, &x, &y);
+
+	return INT2FIX(f->distance(x, y));
+}
+
+void
+pathfinderBindingInit()
+{
+	VALUE module = rb_define_module("Pathfinder");
+
+	_rb_define_module_function(module, "find_path", pathfinderFindPath);
+
+	VALUE klass = rb_define_class("FlowField", rb_cObject);
+	rb_define_alloc_func(klass, classAllocate<&FlowFieldType>);
+
+	_rb_define_method(klass, "initialize", flowFieldInitialize);
+	_rb_define_method(klass, "update", flowFieldUpdate);
+	_rb_define_method(klass, "invalidate", flowFieldInvalidate);
+	_rb_define_method(klass, "direction", flowFieldDirection);
+	_rb_define_method(klass, "distance", flowFieldDistance);
+}
@@ -59,7 +59,7 @@ RB_METHOD(screenStart)
 RB_METHOD(screenFinish)
 {
 	RB_UNUSED_PARAM;
-	ipc.write("END", sizeof("END"));
+	ipc.writeMessage("END");
 	ipc.close();
 	return Qnil;
 }
@@ -71,7 +71,7 @@ RB_METHOD(screenSet)
 	rb_get_args(argc, argv, "z", &imageName RB_ARG_END);
 	if (!ipc.isOpen())
 		start();
-	ipc.write(imageName, strlen(imageName) + 1);
+	ipc.writeMessage(imageName);
 	return Qnil;
 }
 
@@ -28,6 +28,9 @@
 #include "binding-util.h"
 #include "binding-types.h"
 
+#include <string.h>
+#include <math.h>
+
 DEF_TYPE(Sprite);
 
 RB_METHOD(spriteInitialize)
@@ -59,6 +62,7 @@ DEF_PROP_I(Sprite, BushDepth)
 DEF_PROP_I(Sprite, BushOpacity)
 DEF_PROP_I(Sprite, Opacity)
 DEF_PROP_I(Sprite, BlendType)
+DEF_PROP_I(Sprite, Hue)
 DEF_PROP_I(Sprite, WaveAmp)
 DEF_PROP_I(Sprite, WaveLength)
 DEF_PROP_I(Sprite, WaveSpeed)
@@ -98,6 +102,113 @@ RB_METHOD(spriteHeight)
 	return rb_fix_new(value);
 }
 
+/* Field order of the struct-of-arrays buffer taken by
+ * 'Sprite.update_batch'. For N sprites, the buffer holds
+ * N values of the first field, then N of the second, etc. */
+enum SpriteBatchField
+{
+	BatchX = 0,
+	BatchY,
+	BatchZoomX,
+	BatchZoomY,
+	BatchOpacity,
+	BatchAngle,
+
+	BatchFieldsN
+};
+
+static void
+spriteApplyBatchField(Sprite *s, int field, double value)
+{
+	switch (field)
+	{
+	case BatchX :       s->setX((int) value);       break;
+	case BatchY :       s->setY((int) value);       break;
+	case BatchZoomX :   s->setZoomX(value);         break;
+	case BatchZoomY :   s->setZoomY(value);         break;
+	case BatchOpacity : s->setOpacity((int) value); break;
+	case BatchAngle :   s->setAngle(value);         break;
+	}
+}
+
+/* Sprite.update_batch(sprites, data)
+ *
+ * Applies x, y, zoom_x, zoom_y, opacity and angle to every sprite
+ * in 'sprites' in one call. 'data' is either a String of packed
+ * native floats (Array#pack("f*")) or a flat Array of numerics,
+ * laid out as described by SpriteBatchField. A NaN float or nil
+ * entry leaves that property untouched. Returns 'sprites'. */
+RB_METHOD(spriteUpdateBatch)
+{
+	RB_UNUSED_PARAM;
+
+	VALUE spritesObj, dataObj;
+	rb_get_typed_args(argc, argv, &spritesObj, &dataObj);
+
+	spritesObj = rb_ary_to_ary(spritesObj);
+
+	const long count = RARRAY_LEN(spritesObj);
+	const long needed = count * BatchFieldsN;
+
+	const float *packed = 0;
+	const VALUE *values = 0;
+
+	if (RB_TYPE_P(dataObj, RUBY_T_STRING))
+	{
+		if (RSTRING_LEN(dataObj) < needed * (long) sizeof(float))
+			rb_raise(rb_eArgError, "batch data too short (%ld bytes for %ld sprites)",
+			         (long) RSTRING_LEN(dataObj), count);
+
+		packed = reinterpret_cast<const float*>(RSTRING_PTR(dataObj));
+	}
+	else
+	{
+		dataObj = rb_ary_to_ary(dataObj);
+
+		if (RARRAY_LEN(dataObj) < needed)
+			rb_raise(rb_eArgError, "batch data too short (%ld values for %ld sprites)",
+			         (long) RARRAY_LEN(dataObj), count);
+
+		values = RARRAY_CONST_PTR(dataObj);
+	}
+
+	const VALUE *sprites = RARRAY_CONST_PTR(spritesObj);
+
+	for (long i = 0; i < count; ++i)
+	{
+		getPrivateDataCheck<Sprite>(sprites[i], SpriteType);
+		Sprite *s = getPrivateData<Sprite>(sprites[i]);
+
+		for (int f = 0; f < BatchFieldsN; ++f)
+		{
+			const long idx = f * count + i;
+			double value;
+
+			if (packed)
+			{
+				float fv;
+				memcpy(&fv, packed + idx, sizeof(fv));
+
+				if (isnan(fv))
+					continue;
+
+				value = fv;
+			}
+			else
+			{
+				if (NIL_P(values[idx]))
+					continue;
+
+				rb_float_arg(values[idx], &value, f);
+			}
+
+			GUARD_EXC( spriteApplyBatchField(s, f, value); )
+		}
+	}
+
+	return spritesObj;
+}
+
 void
 spriteBindingInit()
 {
@@ -110,6 +221,8 @@ spriteBindingInit()
 
 	_rb_define_method(klass, "initialize", spriteInitialize);
 
+	rb_define_class_method(klass, "update_batch", spriteUpdateBatch);
+
 	INIT_PROP_BIND( Sprite, Bitmap,    "bitmap"     );
 	INIT_PROP_BIND( Sprite, SrcRect,   "src_rect"   );
 	INIT_PROP_BIND( Sprite, X,         "x"          );
@@ -124,6 +237,7 @@ spriteBindingInit()
 	INIT_PROP_BIND( Sprite, BushDepth, "bush_depth" );
 	INIT_PROP_BIND( Sprite, Opacity,   "opacity"    );
 	INIT_PROP_BIND( Sprite, BlendType, "blend_type" );
+	INIT_PROP_BIND( Sprite, Hue,       "hue"        );
 	INIT_PROP_BIND( Sprite, Color,     "color"      );
 	INIT_PROP_BIND( Sprite, Tone,      "tone"       );
 	INIT_PROP_BIND( Sprite, Obscured,  "obscured"   );
@@ -13,6 +13,17 @@
 #include "config.h"
 #include "oneshot.h"
 #include "debugwriter.h"
+#include "desktopworker.h"
+
+// Engine state a desktop job needs, read on the RGSS thread when the
+// job is posted. Jobs may still be running while the engine shuts
+// down, so they must not touch shState themselves.
+struct DesktopContext
+{
+	std::string desktopEnv;
+	std::string gameFolder;
+	std::string workDir;
+};
 
 #ifdef _WIN32
 	#include <windows.h>
@@ -53,16 +64,19 @@
 		static std::map<std::string, bool> defBlurs;
 		// Fallback settings
 		static std::string fallbackPath;
+		// Working directory, wallpaper paths are relative to it
+		static std::string gameDirStr;
 	#endif
 #endif
 
 #ifdef __linux__
-	void desktopEnvironmentInit()
+	void desktopEnvironmentInit(const DesktopContext &ctx)
 	{
 		if (desktop != "uninitialized") {
 			return;
 		}
-		desktop = shState->oneshot().desktopEnv;
+		desktop = ctx.desktopEnv;
+		gameDirStr = ctx.workDir;
 		if (desktop == "cinnamon" || desktop == "gnome" || desktop == "mate" || desktop == "deepin") {
 			if (desktop == "cinnamon" || desktop == "gnome" || desktop == "deepin") {
 				if (desktop == "cinnamon") bgsetting = g_settings_new("org.cinnamon.desktop.background");
@@ -166,14 +180,10 @@
 	}
 #endif
 
-RB_METHOD(wallpaperSet)
+// Runs on the desktop worker thread
+static void setWallpaper(const DesktopContext &ctx, const std::string &nameStr, int color)
 {
-	RB_UNUSED_PARAM;
-	const char *name;
-	int color;
-	rb_get_args(argc, argv, "zi", &name, &color RB_ARG_END);
 	std::string path;
-	std::string nameStr = name;
 #ifdef _WIN32
 	path = "Wallpaper\\" + nameStr + ".bmp";
 	Debug() << "Setting wallpaper to" << path;
@@ -244,7 +254,7 @@ end:
 	if (hKey)
 		RegCloseKey(hKey);
 #else
-	std::string nameFix(name);
+	std::string nameFix(nameStr);
 	std::size_t found = nameFix.find("w32");
 	if (found != std::string::npos) {
 		nameFix.replace(nameFix.end()-3, nameFix.end(), "unix");
@@ -258,14 +268,12 @@ end:
 			MacDesktop::CacheCurrentBackground();
 			isCached = true;
 		}
-		MacDesktop::ChangeBackground(shState->config().gameFolder + path, ((color >> 16) & 0xFF) / 255.0, ((color >> 8) & 0xFF) / 255.0, (color & 0xFF) / 255.0);
+		MacDesktop::ChangeBackground(ctx.gameFolder + path, ((color >> 16) & 0xFF) / 255.0, ((color >> 8) & 0xFF) / 255.0, (color & 0xFF) / 255.0);
 	#else
-		char gameDir[PATH_MAX];
-		if (getcwd(gameDir, sizeof(gameDir)) == NULL) {
-			return Qnil;
+		desktopEnvironmentInit(ctx);
+		if (gameDirStr.empty()) {
+			return;
 		}
-		std::string gameDirStr(gameDir);
-		desktopEnvironmentInit();
 		if (desktop == "cinnamon" || desktop == "gnome" || desktop == "mate" || desktop == "deepin") {
 			std::stringstream hexColor;
 			hexColor << "#" << std::hex << color;
@@ -303,7 +311,7 @@ end:
 				if (!colorArrType) {
 					// Let's do some debug output here and skip changing the color
 					Debug() << "WALLPAPER ERROR: xfconf-query call returned" << colorCommandRes;
-					return Qnil;
+					return;
 				}
 			}
 			g_value_init(&colorValue, colorArrType);
@@ -359,12 +367,11 @@ end:
 		}
 	#endif
 #endif
-	return Qnil;
 }
 
-RB_METHOD(wallpaperReset)
+// Runs on the desktop worker thread
+static void resetWallpaper(const DesktopContext &ctx)
 {
-	RB_UNUSED_PARAM;
 #ifdef _WIN32
 	if (isCached) {
 		int colorId = COLOR_BACKGROUND;
@@ -394,7 +401,7 @@ RB_METHOD(wallpaperReset)
 	#ifdef __APPLE__
 		MacDesktop::ResetBackground();
 	#else
-		desktopEnvironmentInit();
+		desktopEnvironmentInit(ctx);
 		if (desktop == "cinnamon" || desktop == "gnome" || desktop == "mate" || desktop == "deepin") {
 			if (desktop == "cinnamon" || desktop == "gnome" || desktop == "deepin") {
 				g_settings_set_string(bgsetting, "picture-uri", defPictureURI.c_str());
@@ -482,6 +489,65 @@ RB_METHOD(wallpaperReset)
 		}
 	#endif
 #endif
+}
+
+static DesktopContext desktopContext()
+{
+	DesktopContext ctx;
+	ctx.desktopEnv = shState->oneshot().desktopEnv;
+	ctx.gameFolder = shState->config().gameFolder;
+#ifdef __linux__
+	char workDir[PATH_MAX];
+	if (getcwd(workDir, sizeof(workDir)) != NULL) {
+		ctx.workDir = workDir;
+	}
+#endif
+	return ctx;
+}
+
+// Changing the wallpaper can take a while (D-Bus round trips, spawning
+// qdbus/xfconf-query), so it's done in the background. Both calls return
+// a ticket that can be checked with Wallpaper.done?
+RB_METHOD(wallpaperSet)
+{
+	RB_UNUSED_PARAM;
+	const char *name;
+	int color;
+	rb_get_args(argc, argv, "zi", &name, &color RB_ARG_END);
+	std::string nameStr = name;
+	DesktopContext ctx = desktopContext();
+	unsigned int ticket = DesktopWorker::instance().post([ctx, nameStr, color]() {
+		setWallpaper(ctx, nameStr, color);
+	});
+	return UINT2NUM(ticket);
+}
+
+RB_METHOD(wallpaperReset)
+{
+	RB_UNUSED_PARAM;
+	DesktopContext ctx = desktopContext();
+	unsigned int ticket = DesktopWorker::instance().post([ctx]() {
+		resetWallpaper(ctx);
+	});
+	return UINT2NUM(ticket);
+}
+
+// done?([ticket]) -> whether that request (or all of them) went through
+RB_METHOD(wallpaperDone)
+{
+	RB_UNUSED_PARAM;
+	VALUE ticket = Qnil;
+	rb_get_args(argc, argv, "|o", &ticket RB_ARG_END);
+	if (NIL_P(ticket))
+		return rb_bool_new(DesktopWorker::instance().idle());
+	return rb_bool_new(DesktopWorker::instance().finished(NUM2UINT(ticket)));
+}
+
+// Blocks until all pending desktop requests went through
+RB_METHOD(wallpaperWait)
+{
+	RB_UNUSED_PARAM;
+	DesktopWorker::instance().wait();
 	return Qnil;
 }
 
@@ -492,12 +558,14 @@ void wallpaperBindingInit()
 	// Functions
 	_rb_define_module_function(module, "set", wallpaperSet);
 	_rb_define_module_function(module, "reset", wallpaperReset);
+	_rb_define_module_function(module, "done?", wallpaperDone);
+	_rb_define_module_function(module, "wait", wallpaperWait);
 }
 
 #ifdef __linux__
+// Only called once the desktop worker went idle
 void wallpaperBindingTerminate()
 {
-	// Clean up.
 	if (desktop == "xfce") {
 		xfconf_shutdown();
 	}
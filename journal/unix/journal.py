@@ -1,6 +1,6 @@
 # -*- coding: utf-8 -*-
 
-import os, sys, time
+import os, struct, sys, time
 
 from PyQt5.QtCore import Qt, QEvent, QThread, pyqtSignal, QRect, QRectF, QTimer, QPoint
 from PyQt5.QtWidgets import QApplication, QWidget, QDesktopWidget, QLabel
@@ -35,6 +35,20 @@ class PipeThread(QThread):
 		del kwargs['pipe']
 		super().__init__(*args, **kwargs)
 
+# The game sends each message as a 32 bit length (native byte
+# order) followed by the payload; an empty message means close.
+FRAME_HEADER = struct.Struct('=I')
+
+def take_messages(buf):
+	messages = []
+	while len(buf) >= FRAME_HEADER.size:
+		size, = FRAME_HEADER.unpack_from(buf)
+		end = FRAME_HEADER.size + size
+		if len(buf) < end: break
+		messages.append(bytes(buf[FRAME_HEADER.size:end]))
+		del buf[:end]
+	return messages
+
 class WatchPipe(PipeThread):
 	change_image = pyqtSignal(str)
 
@@ -47,14 +61,19 @@ class WatchPipe(PipeThread):
 			pipe.flush()
 
 			was_nondefault = False
+			buf = bytearray()
 
 			while os.path.exists(self.pipe): # Make sure the file still exists and wasn't cleaned up by SyngleChance
-				message = os.read(pipe.fileno(), 256)
-				if len(message) > 0:
-					m = message.decode()
-					if m != 'default_en':
-						was_nondefault = True
-					self.change_image.emit(m)
+				data = os.read(pipe.fileno(), 4096)
+				if len(data) > 0:
+					buf.extend(data)
+					for message in take_messages(buf):
+						m = message.decode()
+						if m == '':
+							m = 'CLOSE'
+						elif m != 'default_en':
+							was_nondefault = True
+						self.change_image.emit(m)
 				else:
 					try:
 						st = os.stat(self.pipe)
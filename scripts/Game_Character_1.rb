@@ -10,8 +10,8 @@ class Game_Character
   # * Public Instance Variables
   #--------------------------------------------------------------------------
   attr_reader   :id                       # ID
-  attr_accessor   :x                        # map x-coordinate (logical)
-  attr_accessor   :y                        # map y-coordinate (logical)
+  attr_reader   :x                        # map x-coordinate (logical)
+  attr_reader   :y                        # map y-coordinate (logical)
   attr_accessor   :real_x                   # map x-coordinate (real * 128)
   attr_accessor   :real_y                   # map y-coordinate (real * 128)
   attr_reader   :tile_id                  # tile ID (invalid if 0)
@@ -148,10 +148,11 @@ class Game_Character
       # impassable
       return false
     end
-    # Loop all events
-    for event in $game_map.events.values
+    # All events covering the move tile
+    for id in $game_map.event_grid.covering(new_x, new_y)
+      event = $game_map.events[id]
       next if event.through || event.character_name.empty?
-      return false if event.intersects?(new_x, new_y)
+      return false
     end
     # If player coordinates are consistent with move destination
     if $game_player.x == new_x and $game_player.y == new_y
@@ -220,6 +221,30 @@ class Game_Character
     @real_x = @x * 128
     @real_y = @y * 128
     @prelock_direction = 0
+    sync_grid
+  end
+  #--------------------------------------------------------------------------
+  # * Update Map Event Grid
+  #     Called after position, through or graphic changes. Only map
+  #     events are indexed, so other characters do nothing here.
+  #--------------------------------------------------------------------------
+  def sync_grid
+  end
+  #--------------------------------------------------------------------------
+  # * Set Map X-Coordinate
+  #     x : new x-coordinate (logical)
+  #--------------------------------------------------------------------------
+  def x=(x)
+    @x = x
+    sync_grid
+  end
+  #--------------------------------------------------------------------------
+  # * Set Map Y-Coordinate
+  #     y : new y-coordinate (logical)
+  #--------------------------------------------------------------------------
+  def y=(y)
+    @y = y
+    sync_grid
   end
   #--------------------------------------------------------------------------
   # * Get Screen X-Coordinates
@@ -316,8 +316,10 @@ class Game_Character
           @direction_fix = false
         when 37  # Through ON
           @through = true
+          sync_grid
         when 38  # Through OFF
           @through = false
+          sync_grid
         when 39  # Always on top ON
           @always_on_top = true
         when 40  # Always on top OFF
@@ -325,6 +327,7 @@ class Game_Character
         when 41  # Change Graphic
           @tile_id = 0
           @character_name = command.parameters[0]
+          sync_grid
           @character_hue = command.parameters[1]
           @direction = command.parameters[2]
           @prelock_direction = 0
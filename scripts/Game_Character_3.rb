@@ -23,6 +23,7 @@ class Game_Character
       emit_footprint(2)
       # Update coordinates
       @y += 1
+      sync_grid
       # Increase steps
       increase_steps
     # If impassable
@@ -48,6 +49,7 @@ class Game_Character
       emit_footprint(4)
       # Update coordinates
       @x -= 1
+      sync_grid
       # Increase steps
       increase_steps
     # If impassable
@@ -73,6 +75,7 @@ class Game_Character
       emit_footprint(6)
       # Update coordinates
       @x += 1
+      sync_grid
       # Increase steps
       increase_steps
     # If impassable
@@ -98,6 +101,7 @@ class Game_Character
       emit_footprint(8)
       # Update coordinates
       @y -= 1
+      sync_grid
       # Increase steps
       increase_steps
     # If impassable
@@ -121,6 +125,7 @@ class Game_Character
       # Update coordinates
       @x -= 1
       @y += 1
+      sync_grid
       # Increase steps
       increase_steps
     end
@@ -140,6 +145,7 @@ class Game_Character
       # Update coordinates
       @x += 1
       @y += 1
+      sync_grid
       # Increase steps
       increase_steps
     end
@@ -159,6 +165,7 @@ class Game_Character
       # Update coordinates
       @x -= 1
       @y -= 1
+      sync_grid
       # Increase steps
       increase_steps
     end
@@ -178,6 +185,7 @@ class Game_Character
       # Update coordinates
       @x += 1
       @y -= 1
+      sync_grid
       # Increase steps
       increase_steps
     end
@@ -233,6 +241,25 @@ class Game_Character
     end
   end
   #--------------------------------------------------------------------------
+  # * Move toward Player Along Path
+  #     Follows the map's flow field around obstacles, falling back to
+  #     the greedy step when the player can't be reached
+  #--------------------------------------------------------------------------
+  def move_toward_player_path
+    case $game_map.player_flow_field.direction(@x, @y)
+    when 2
+      move_down
+    when 4
+      move_left
+    when 6
+      move_right
+    when 8
+      move_up
+    else
+      move_toward_player
+    end
+  end
+  #--------------------------------------------------------------------------
   # * Move away from Player
   #--------------------------------------------------------------------------
   def move_away_from_player
@@ -332,6 +359,7 @@ class Game_Character
       # Update coordinates
       @x = new_x
       @y = new_y
+      sync_grid
       # Calculate distance
       distance = Math.sqrt(x_plus * x_plus + y_plus * y_plus).round
       # Set jump count
@@ -55,6 +55,12 @@ class Game_Event < Game_Character
     return false
   end
   #--------------------------------------------------------------------------
+  # * Update Map Event Grid
+  #--------------------------------------------------------------------------
+  def sync_grid
+    $game_map.sync_event(self)
+  end
+  #--------------------------------------------------------------------------
   # * Return name
   #--------------------------------------------------------------------------
   def name
@@ -163,6 +169,7 @@ class Game_Event < Game_Character
       @trigger = nil
       @list = nil
       @interpreter = nil
+      sync_grid
       # End method
       return
     end
@@ -195,6 +202,7 @@ class Game_Event < Game_Character
     @trigger = @page.trigger
     @list = @page.list
     @interpreter = nil
+    sync_grid
     # If trigger is [parallel process]
     if @trigger == 4
       # Create parallel process interpreter
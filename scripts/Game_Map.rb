@@ -126,10 +126,12 @@ class Game_Map
     # Clear refresh request flag
     @need_refresh = false
     # Set map event data
+    @event_grid = nil
     @events = {}
     for i in @map.events.keys
       @events[i] = Game_Event.new(@map_id, @map.events[i])
     end
+    build_event_grid
     # Set common event data
     @common_events = {}
     for i in 1...$data_common_events.size
@@ -329,63 +331,64 @@ class Game_Map
       # impassable
       return false
     end
-    x %= self.width
-    y %= self.height
-    # Change direction (0,2,4,6,8,10) to obstacle bit (0,1,2,4,8,0)
-    bit = (1 << (d / 2 - 1)) & 0x0f
-    # Loop in all events
-    for event in events.values
-      # If tiles other than self are consistent with coordinates
-      if event.tile_id >= 0 and event != self_event and
-         event.x == x and event.y == y and not event.through
-        # If blank tile
-        if event.tile_id == 0 && event.character_name.empty?
-          return false
-        # If obstacle bit is set
-        elsif @passages[event.tile_id] & bit != 0
-          # impassable
-          return false
-        # If obstacle bit is set in all directions
-        elsif @passages[event.tile_id] & 0x0f == 0x0f
-          # impassable
-          return false
-        # If priorities other than that are 0
-        elsif @priorities[event.tile_id] == 0
-          # passable
-          return true
-        end
-      end
-    end
-    # Loop searches in order from top of layer
-    blank = 0
-    [2, 1, 0].each do |i|
-      # Get tile ID
-      tile_id = data[x, y, i]
-      # Tile ID acquistion failure
-      next if tile_id == nil
-
-      # Only handle blank if all three layers are blank
-      if tile_id < 48 && i > 0
-        blank += 1
-        next if blank < 3
-      end
-
-      # If obstacle bit is set
-      if @passages[tile_id] & bit != 0
-        # impassable
-        return false
-      # If obstacle bit is set in all directions
-      elsif @passages[tile_id] & 0x0f == 0x0f
-        # impassable
-        return false
-      # If priorities other than that are 0
-      elsif @priorities[tile_id] == 0
-        # passable
-        return true
-      end
+    # Events on the tile are checked first, then the tile layers
+    # from the top down (see EventGrid#passable?)
+    self_id = self_event.is_a?(Game_Event) ? self_event.id : 0
+    return event_grid.passable?(data, @passages, @priorities, x, y, d, self_id)
+  end
+  #--------------------------------------------------------------------------
+  # * Get Event Grid
+  #     Tile -> event ID index, kept current by Game_Event#sync_grid
+  #--------------------------------------------------------------------------
+  def event_grid
+    # Built on first use after setup; saves only carry an empty
+    # grid (see EventGrid#_dump), rebuilt here after loading
+    build_event_grid if @event_grid == nil || @event_grid.width == 0
+    return @event_grid
+  end
+  #--------------------------------------------------------------------------
+  # * Build Event Grid
+  #--------------------------------------------------------------------------
+  def build_event_grid
+    @event_grid = EventGrid.new(width, height)
+    for event in @events.values
+      sync_event(event)
     end
-    # passable
-    return true
+  end
+  #--------------------------------------------------------------------------
+  # * Update Event in Grid
+  #     event : event (Game_Event)
+  #--------------------------------------------------------------------------
+  def sync_event(event)
+    # Events are still being created during setup
+    return if @event_grid == nil
+    @event_grid.insert(event.id, event.x, event.y, event.tile_id,
+                       event.through, event.character_name.empty?,
+                       event.collision)
+  end
+  #--------------------------------------------------------------------------
+  # * Find Path
+  #     sx, sy     : start coordinates
+  #     tx, ty     : target coordinates
+  #     self_event : moving event (ignored when checking passability)
+  #     Returns an array of directions (2,4,6,8), or nil if unreachable
+  #--------------------------------------------------------------------------
+  def find_path(sx, sy, tx, ty, self_event = nil)
+    self_id = self_event.is_a?(Game_Event) ? self_event.id : 0
+    return Pathfinder.find_path(event_grid, data, @passages, @priorities,
+                                sx, sy, tx, ty, self_id)
+  end
+  #--------------------------------------------------------------------------
+  # * Get Flow Field Toward Player
+  #     Shared by every character chasing the player; only rebuilt when
+  #     the player, events or map data change. Kept out of the saved
+  #     map state on purpose.
+  #--------------------------------------------------------------------------
+  def player_flow_field
+    @@player_flow_field ||= FlowField.new
+    @@player_flow_field.update(event_grid, data, @passages, @priorities,
+                               $game_player.x, $game_player.y)
+    return @@player_flow_field
   end
   #--------------------------------------------------------------------------
   # * Determine Thicket
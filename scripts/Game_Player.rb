@@ -109,10 +109,11 @@ class Game_Player < Game_Character
     if $game_system.map_interpreter.running?
       return result
     end
-    # All event loops
-    for event in $game_map.events.values
-      # If event coordinates and triggers are consistent
-      if event.x == @x and event.y == @y and triggers.include?(event.trigger)
+    # All events on this tile
+    for id in $game_map.event_grid[@x, @y]
+      event = $game_map.events[id]
+      # If triggers are consistent
+      if triggers.include?(event.trigger)
         # If starting determinant is same position event (other than jumping)
         if not event.jumping? and event.over_trigger?
           event.start
@@ -134,10 +135,11 @@ class Game_Player < Game_Character
     # Calculate front event coordinates
     new_x = @x + (@direction == 6 ? 1 : @direction == 4 ? -1 : 0)
     new_y = @y + (@direction == 2 ? 1 : @direction == 8 ? -1 : 0)
-    # All event loops
-    for event in $game_map.events.values
-      # If event coordinates and triggers are consistent
-      if event.intersects?(new_x, new_y) && triggers.include?(event.trigger)
+    # All events covering the front tile
+    for id in $game_map.event_grid.covering(new_x, new_y)
+      event = $game_map.events[id]
+      # If triggers are consistent
+      if triggers.include?(event.trigger)
         # If starting determinant is front event (other than jumping)
         if not event.jumping? and not event.over_trigger?
           event.start
@@ -156,10 +158,11 @@ class Game_Player < Game_Character
     if $game_system.map_interpreter.running?
       return result
     end
-    # All event loops
-    for event in $game_map.events.values
-      # If event coordinates and triggers are consistent
-      if event.x == x and event.y == y and [1,2].include?(event.trigger)
+    # All events on the touched tile
+    for id in $game_map.event_grid[x, y]
+      event = $game_map.events[id]
+      # If triggers are consistent
+      if [1,2].include?(event.trigger)
         # If starting determinant is front event (other than jumping)
         if not event.jumping? and not event.over_trigger?
           event.start
@@ -44,8 +44,9 @@ class Sprite_Character
       @character_hue = @character.character_hue
       # If tile ID value is valid
       if @tile_id >= 384
-        @sprite.bitmap = RPG::Cache.tile($game_map.tileset_name,
-          @tile_id, @character.character_hue)
+        # Hue is applied when drawing, so all hues share one bitmap
+        @sprite.bitmap = RPG::Cache.tile($game_map.tileset_name, @tile_id, 0)
+        @sprite.hue = @character.character_hue
         @light_sprite.visible = false
         @sprite.src_rect.set(0, 0, 32, 32)
         @light_sprite.src_rect.set(0, 0, 32, 32)
@@ -53,8 +54,8 @@ class Sprite_Character
         self.oy = 32
       # If tile ID value is invalid
       else
-        @sprite.bitmap = RPG::Cache.character(@character.character_name,
-          @character.character_hue)
+        @sprite.bitmap = RPG::Cache.character(@character.character_name, 0)
+        @sprite.hue = @character.character_hue
         begin
           @light_sprite.bitmap = RPG::Cache.lightmap(@character.character_name)
           @light_sprite.visible = true
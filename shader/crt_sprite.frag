@@ -2,6 +2,8 @@ vec2 u_resolution = vec2(320, 240);
 uniform sampler2D texture;
 varying vec2 v_texCoord;
 
+uniform mediump float hueAdjust;
+
 const float SIZE = 0.0075; // Tweakable. Original: 0.0075
 const float VERTICAL_FACTOR = 0.75; // Tweakable. Original: 0.86
 
@@ -10,6 +12,26 @@ const float SIZE_HALF = SIZE * 0.5;
 const float TO_ONE = 1. / SIZE;
 const float VERTICAL_FACTOR_INV = 1. - VERTICAL_FACTOR;
 
+/* Same conversion as hue.frag */
+vec3 rgb2hsv(vec3 c)
+{
+	const vec4 K = vec4(0.0, -1.0 / 3.0, 2.0 / 3.0, -1.0);
+	vec4 p = mix(vec4(c.bg, K.wz), vec4(c.gb, K.xy), step(c.b, c.g));
+	vec4 q = mix(vec4(p.xyw, c.r), vec4(c.r, p.yzx), step(p.x, c.r));
+
+	float d = q.x - min(q.w, q.y);
+	const float eps = 1.0e-10;
+
+	return vec3(abs(q.z + (q.w - q.y) / (6.0 * d + eps)), d / (q.x + eps), q.x);
+}
+
+vec3 hsv2rgb(vec3 c)
+{
+	const vec4 K = vec4(1.0, 2.0 / 3.0, 1.0 / 3.0, 3.0);
+	vec3 p = abs(fract(c.xxx + K.xyz) * 6.0 - K.www);
+	return c.z * mix(K.xxx, clamp(p - K.xxx, 0.0, 1.0), c.y);
+}
+
 float Distance(vec2 origin, vec2 point) {
     return abs(sqrt(pow(point.x - origin.x, 2.) + pow(point.y - origin.y, 2.)));
 }
@@ -85,5 +107,14 @@ void main() {
     vec2 st = gl_FragCoord.xy / min(u_resolution.y, u_resolution.x);
     vec4 color = ColorReduction(st);
     vec4 usedTexture = texture2D(texture, v_texCoord);
+
+    /* Hued characters rely on this instead of a baked copy */
+    if (hueAdjust != 0.0)
+    {
+        vec3 hsv = rgb2hsv(usedTexture.rgb);
+        hsv.x += hueAdjust;
+        usedTexture.rgb = hsv2rgb(hsv);
+    }
+
     gl_FragColor = usedTexture - color;
 }
\ No newline at end of file
@@ -1,9 +1,15 @@
 
+uniform sampler2D texture;
+
 uniform lowp float alpha;
 
-varying lowp vec4 v_color;
+varying vec2 v_texCoord;
 
 void main()
 {
-	gl_FragColor = vec4(v_color.rgb * alpha, 1);
+	/* One texel per tile; tiles without
+	 * a flash color have zero alpha */
+	lowp vec4 color = texture2D(texture, v_texCoord);
+
+	gl_FragColor = vec4(color.rgb * alpha, color.a);
 }
@@ -0,0 +1,31 @@
+
+uniform sampler2D texture;
+
+uniform lowp vec4 tone;
+uniform lowp vec4 color;
+
+varying vec2 v_texCoord;
+varying lowp vec4 v_color;
+
+const vec3 lumaF = vec3(.299, .587, .114);
+
+void main()
+{
+	/* Sample source color */
+	vec4 frag = texture2D(texture, v_texCoord);
+
+	/* Apply gray */
+	float luma = dot(frag.rgb, lumaF);
+	frag.rgb = mix(frag.rgb, vec3(luma), tone.w);
+
+	/* Apply tone */
+	frag.rgb += tone.rgb;
+
+	/* Apply per particle opacity */
+	frag.a *= v_color.a;
+
+	/* Apply color */
+	frag.rgb = mix(frag.rgb, color.rgb, color.a);
+
+	gl_FragColor = frag;
+}
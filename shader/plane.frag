@@ -7,14 +7,20 @@ uniform lowp float opacity;
 uniform lowp vec4 color;
 uniform lowp vec4 flash;
 
+/* Normalized src_rect the tex coords repeat within */
+uniform vec4 srcRect;
+
 varying vec2 v_texCoord;
 
 const vec3 lumaF = vec3(.299, .587, .114);
 
 void main()
 {
+	/* Wrap into the source rect */
+	vec2 texCoord = srcRect.xy + mod(v_texCoord - srcRect.xy, srcRect.zw);
+
 	/* Sample source color */
-	vec4 frag = texture2D(texture, v_texCoord);
+	vec4 frag = texture2D(texture, texCoord);
 	
 	/* Apply gray */
 	float luma = dot(frag.rgb, lumaF);
@@ -9,14 +9,45 @@ uniform lowp vec4 color;
 uniform float bushDepth;
 uniform lowp float bushOpacity;
 
+uniform mediump float hueAdjust;
+
 varying vec2 v_texCoord;
 
 const vec3 lumaF = vec3(.299, .587, .114);
 
+/* Same conversion as hue.frag */
+vec3 rgb2hsv(vec3 c)
+{
+	const vec4 K = vec4(0.0, -1.0 / 3.0, 2.0 / 3.0, -1.0);
+	vec4 p = mix(vec4(c.bg, K.wz), vec4(c.gb, K.xy), step(c.b, c.g));
+	vec4 q = mix(vec4(p.xyw, c.r), vec4(c.r, p.yzx), step(p.x, c.r));
+
+	float d = q.x - min(q.w, q.y);
+	const float eps = 1.0e-10;
+
+	return vec3(abs(q.z + (q.w - q.y) / (6.0 * d + eps)), d / (q.x + eps), q.x);
+}
+
+vec3 hsv2rgb(vec3 c)
+{
+	const vec4 K = vec4(1.0, 2.0 / 3.0, 1.0 / 3.0, 3.0);
+	vec3 p = abs(fract(c.xxx + K.xyz) * 6.0 - K.www);
+	return c.z * mix(K.xxx, clamp(p - K.xxx, 0.0, 1.0), c.y);
+}
+
 void main()
 {
 	/* Sample source color */
 	vec4 frag = texture2D(texture, v_texCoord);
+
+	/* Apply hue rotation (uniform branch, so sprites
+	 * without a hue don't pay for the conversion) */
+	if (hueAdjust != 0.0)
+	{
+		vec3 hsv = rgb2hsv(frag.rgb);
+		hsv.x += hueAdjust;
+		frag.rgb = hsv2rgb(hsv);
+	}
 	
 	/* Apply gray */
 	float luma = dot(frag.rgb, lumaF);
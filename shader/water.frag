@@ -2,6 +2,10 @@ uniform sampler2D texture;
 uniform float iTime;
 uniform lowp float opacity;
 
+/* Normalized src_rect the tex coords repeat within;
+ * left zero for screen effects, which don't wrap */
+uniform vec4 srcRect;
+
 varying vec2 v_texCoord;
 
 #define T iTime
@@ -116,7 +120,10 @@ void main()
    
 	vec2 uv = v_texCoord;
     vec3 v = calcNormal(vec3(uv.x,1,uv.y),.01);
-	vec4 fragColor = texture2D(texture,uv+(v.xz/15.*.25));
+	vec2 texCoord = uv+(v.xz/15.*.25);
+	if (srcRect.z > 0.)
+		texCoord = srcRect.xy + mod(texCoord - srcRect.xy, srcRect.zw);
+	vec4 fragColor = texture2D(texture,texCoord);
     fragColor.a *= opacity;
     gl_FragColor = fragColor;
 }
\ No newline at end of file
@@ -0,0 +1,83 @@
+
+uniform sampler2D texture;
+
+/* In pixels */
+uniform vec2 skinSize;
+uniform vec2 frameSize;
+
+uniform lowp float backOpacity;
+uniform lowp float bgStretch;
+
+varying vec2 v_texCoord;
+
+vec4 skin(vec2 pos)
+{
+	return texture2D(texture, pos / skinSize);
+}
+
+bool inside(vec2 pos, vec4 rect)
+{
+	return all(greaterThanEqual(pos, rect.xy)) &&
+	       all(lessThan(pos, rect.xy + rect.zw));
+}
+
+/* Same as drawing 'src' over 'dst' with BlendNormal,
+ * but kept unpremultiplied */
+vec4 over(vec4 dst, vec4 src)
+{
+	float a = src.a + dst.a * (1.0 - src.a);
+
+	if (a == 0.0)
+		return vec4(0.0);
+
+	vec3 rgb = src.rgb * src.a + dst.rgb * dst.a * (1.0 - src.a);
+
+	return vec4(rgb / a, a);
+}
+
+/* Composites the part of the skin at 'src' onto 'rect',
+ * repeating it every 'tile' pixels */
+void layer(inout vec4 frag, vec2 pos, vec4 rect, vec2 src, vec2 tile)
+{
+	if (!inside(pos, rect))
+		return;
+
+	frag = over(frag, skin(src + mod(pos - rect.xy, tile)));
+}
+
+void main()
+{
+	vec2 pos = v_texCoord * skinSize;
+	vec2 s = frameSize;
+
+	vec4 frag = vec4(0.0);
+
+	/* Background, 2px inset */
+	vec4 bgRect = vec4(2.0, 2.0, s - 4.0);
+
+	if (inside(pos, bgRect))
+	{
+		vec2 bgPos = pos - bgRect.xy;
+
+		if (bgStretch != 0.0)
+			frag = skin(bgPos * (128.0 / bgRect.zw));
+		else
+			frag = skin(mod(bgPos, 128.0));
+
+		frag.a *= backOpacity;
+	}
+
+	/* Borders (top, bottom, left, right) */
+	layer(frag, pos, vec4(8.0, 0.0, s.x - 16.0, 16.0),       vec2(144.0,  0.0), vec2(32.0, 16.0));
+	layer(frag, pos, vec4(8.0, s.y - 16.0, s.x - 16.0, 16.0), vec2(144.0, 48.0), vec2(32.0, 16.0));
+	layer(frag, pos, vec4(0.0, 8.0, 16.0, s.y - 16.0),       vec2(128.0, 16.0), vec2(16.0, 32.0));
+	layer(frag, pos, vec4(s.x - 16.0, 8.0, 16.0, s.y - 16.0), vec2(176.0, 16.0), vec2(16.0, 32.0));
+
+	/* Corners */
+	layer(frag, pos, vec4(0.0, 0.0, 16.0, 16.0),               vec2(128.0,  0.0), vec2(16.0));
+	layer(frag, pos, vec4(s.x - 16.0, 0.0, 16.0, 16.0),        vec2(176.0,  0.0), vec2(16.0));
+	layer(frag, pos, vec4(0.0, s.y - 16.0, 16.0, 16.0),        vec2(128.0, 48.0), vec2(16.0));
+	layer(frag, pos, vec4(s.x - 16.0, s.y - 16.0, 16.0, 16.0), vec2(176.0, 48.0), vec2(16.0));
+
+	gl_FragColor = frag;
+}
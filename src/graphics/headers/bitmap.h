@@ -31,7 +31,7 @@
 class Font;
 class ShaderBase;
 struct TEXFBO;
-struct SDL_Surface;
+class MegaTexture;
 
 struct BitmapPrivate;
 // FIXME make this class use proper RGSS classes again
@@ -110,16 +110,28 @@ public:
 
 	/* <internal> */
 	TEXFBO &getGLTypes();
-	SDL_Surface *megaSurface() const;
+	MegaTexture *megaTexture() const;
 	void ensureNonMega() const;
 
 	/* Binds the backing texture and sets the correct
 	 * texture size uniform in shader */
 	void bindTex(ShaderBase &shader);
 
+	/* For drawing 'rect' of the bitmap: the texture bound by
+	 * bindTex(shader, rect) holds 'viewRect(rect)' of it (all
+	 * of it, unless this is a mega surface). prepareView() has
+	 * to be called for 'rect' before drawing starts */
+	IntRect viewRect(const IntRect &rect) const;
+	void prepareView(const IntRect &rect);
+	void bindTex(ShaderBase &shader, const IntRect &rect);
+
 	/* Adds 'rect' to tainted area */
 	void taintArea(const IntRect &rect);
 
+	/* Changes whenever the contents do,
+	 * and is never shared between Bitmaps */
+	unsigned int contentStamp() const;
+
 	sigc::signal<void> modified;
 
 private:
@@ -0,0 +1,111 @@
+/*
+** frameprofiler.h
+**
+** This file is part of mkxp.
+**
+** Copyright (C) 2013 Jonas Kulla <Nyocurio@gmail.com>
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FRAMEPROFILER_H
+#define FRAMEPROFILER_H
+
+#include <typeinfo>
+
+struct Config;
+struct Vec2i;
+struct FrameProfilerPrivate;
+
+/* Opt-in breakdown of where each frame's time goes. CPU time
+ * is measured per scope with the performance counter, GPU time
+ * per pass through timer queries (when the driver has them).
+ * Results are written as Chrome trace events and drawn as a
+ * bar graph over the game screen */
+class FrameProfiler
+{
+public:
+	/* Top level phases summed up per frame */
+	enum Phase
+	{
+		Script,
+		PrepareDraw,
+		Composite,
+		PostEffects,
+		Swap,
+		LimiterSleep,
+
+		PhaseCount,
+		NoPhase = PhaseCount
+	};
+
+	FrameProfiler(const Config &conf);
+	~FrameProfiler();
+
+	bool enabled() const { return active; }
+
+	/* Scopes nest; time spent in a nested phase is not counted
+	 * towards the enclosing one. With 'gpu', the GL commands
+	 * issued inside the scope are timed too */
+	void begin(const char *name, Phase phase = NoPhase, bool gpu = false);
+	void begin(const std::type_info &type);
+	void end();
+
+	/* Called when the scripts hand control to Graphics.update;
+	 * everything since the last frame counts as script time */
+	void scriptDone();
+
+	/* Called right after the buffer swap */
+	void endFrame();
+
+	/* Draws the graph into the currently bound (window)
+	 * framebuffer. 'budgetMs' is marked as a reference line */
+	void drawOverlay(const Vec2i &winSize, double budgetMs);
+
+private:
+	bool active;
+	FrameProfilerPrivate *p;
+};
+
+/* Profiles the enclosing block, if the profiler is enabled */
+class ProfileScope
+{
+public:
+	ProfileScope(FrameProfiler &prof, const char *name,
+	             FrameProfiler::Phase phase = FrameProfiler::NoPhase,
+	             bool gpu = false)
+	    : prof(prof)
+	{
+		if (prof.enabled())
+			prof.begin(name, phase, gpu);
+	}
+
+	ProfileScope(FrameProfiler &prof, const std::type_info &type)
+	    : prof(prof)
+	{
+		if (prof.enabled())
+			prof.begin(type);
+	}
+
+	~ProfileScope()
+	{
+		if (prof.enabled())
+			prof.end();
+	}
+
+private:
+	FrameProfiler &prof;
+};
+
+#endif // FRAMEPROFILER_H
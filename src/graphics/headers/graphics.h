@@ -65,6 +65,9 @@ public:
 	DECL_ATTR( Smooth,     bool )
 	DECL_ATTR( Frameskip,  bool )
 
+	/* Over the last few hundred frames, in milliseconds */
+	void frameTimeStats(double &p50, double &p99, double &max) const;
+
 	/* <internal> */
 	Scene *getScreen() const;
 	/* Repaint screen with static image until exitCond
@@ -0,0 +1,94 @@
+/*
+** particlesystem.h
+**
+** This file is part of mkxp.
+**
+** Copyright (C) 2013 Jonas Kulla <Nyocurio@gmail.com>
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PARTICLESYSTEM_H
+#define PARTICLESYSTEM_H
+
+#include "disposable.h"
+#include "viewport.h"
+#include "util.h"
+
+class Bitmap;
+struct Color;
+struct Tone;
+
+struct ParticleSystemPrivate;
+
+/* A pool of lightweight particles sharing one bitmap,
+ * simulated natively and drawn as a single batch.
+ * Particles are centered on their position and are
+ * scaled/faded over their lifetime by linear curves */
+class ParticleSystem : public ViewportElement, public Disposable
+{
+public:
+	ParticleSystem(Viewport *viewport = 0);
+	~ParticleSystem();
+
+	/* Advance the simulation by one frame */
+	void update();
+
+	/* Spawn 'count' particles immediately */
+	void emit(int count);
+
+	/* Offset every live particle (eg. to follow map scrolling) */
+	void shift(float dx, float dy);
+
+	void clear();
+	int getCount() const;
+
+	/* Emitter parameters; min/max pairs are sampled uniformly */
+	void setEmitArea(int x, int y, int width, int height);
+	void setVelocity(float minX, float maxX, float minY, float maxY);
+	void setLifetime(int minFrames, int maxFrames);
+	void setScale(float min, float max);
+	void setScaleCurve(float start, float end);
+	void setOpacityCurve(float start, float end);
+	void setWave(int minPeriod, int maxPeriod);
+
+	DECL_ATTR( Bitmap,       Bitmap* )
+	DECL_ATTR( Opacity,      int     )
+	DECL_ATTR( BlendType,    int     )
+	DECL_ATTR( EmitRate,     float   )
+	DECL_ATTR( MaxParticles, int     )
+	DECL_ATTR( RandomSign,   bool    )
+	DECL_ATTR( AccelX,       float   )
+	DECL_ATTR( AccelY,       float   )
+	DECL_ATTR( Wrap,         bool    )
+	DECL_ATTR( WrapWidth,    int     )
+	DECL_ATTR( WrapHeight,   int     )
+	DECL_ATTR( Color,        Color&  )
+	DECL_ATTR( Tone,         Tone&   )
+
+	void initDynAttribs();
+
+private:
+	ParticleSystemPrivate *p;
+
+	void draw();
+	void onGeometryChange(const Scene::Geometry &);
+
+	void releaseResources();
+	const char *klassName() const { return "particle system"; }
+
+	ABOUT_TO_ACCESS_DISP
+};
+
+#endif // PARTICLESYSTEM_H
@@ -0,0 +1,118 @@
+/*
+** presentthread.h
+**
+** This file is part of mkxp.
+**
+** Copyright (C) 2013 Jonas Kulla <Nyocurio@gmail.com>
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef PRESENTTHREAD_H
+#define PRESENTTHREAD_H
+
+#include "gl-util.h"
+#include "etc-internal.h"
+
+#include <SDL2/SDL_video.h>
+
+struct SDL_Thread;
+struct SDL_mutex;
+struct SDL_cond;
+
+/* Moves the final blit to the window and the buffer swap
+ * (and with it any vsync wait) onto a thread with its own,
+ * shared GL context, so the RGSS thread can go on with the
+ * next frame right away. Finished frames are handed over
+ * through two slots, which bounds the added latency to one
+ * frame: the RGSS thread waits for a slot to come free
+ * before it can render into it */
+class PresentThread
+{
+public:
+	/* Must be called from the RGSS thread with its context
+	 * current. Returns null if the driver lacks something
+	 * we need (native blits, shared contexts) or the
+	 * presenting thread can't bind the window */
+	static PresentThread *create(SDL_Window *window);
+	~PresentThread();
+
+	/* What the RGSS thread's context is to be made current
+	 * on while presenting is pipelined: null if it gave
+	 * up the window surface, the window otherwise */
+	SDL_Window *mainSurface() const { return surfaceless ? 0 : window; }
+
+	/* The slot the next frame is to be copied into, sized
+	 * 'size'. Waits until the presenter is done with it */
+	TEXFBO &acquire(const Vec2i &size);
+
+	/* Hands the acquired slot over to be shown, blitting
+	 * 'src' to 'dst' in window coordinates */
+	void queue(const IntRect &src, const IntRect &dst, bool smooth);
+
+private:
+	PresentThread(SDL_Window *window, SDL_GLContext mainCtx,
+	              SDL_GLContext ctx, int swapInterval, bool surfaceless);
+
+	enum Startup
+	{
+		Starting,
+		Running,
+		Failed
+	};
+
+	/* False if the thread couldn't make its context current */
+	bool waitStarted();
+	void setStartup(Startup value);
+
+	void run();
+
+	enum SlotState
+	{
+		Free,
+		Acquired,
+		Queued,
+		Showing
+	};
+
+	struct Slot
+	{
+		TEXFBO frame;
+		SlotState state;
+		_GLsync fence;
+
+		IntRect src, dst;
+		bool smooth;
+	};
+
+	SDL_Window *window;
+	SDL_GLContext mainCtx;
+	SDL_GLContext ctx;
+	int swapInterval;
+	bool surfaceless;
+
+	Slot slots[2];
+	int writeSlot;
+	int readSlot;
+
+	SDL_mutex *mutex;
+	SDL_cond *cond;
+	Startup startup;
+	bool quit;
+
+	SDL_Thread *thread;
+};
+
+#endif // PRESENTTHREAD_H
@@ -61,6 +61,7 @@ public:
 	DECL_ATTR( BushOpacity, int     )
 	DECL_ATTR( Opacity,     int     )
 	DECL_ATTR( BlendType,   int     )
+	DECL_ATTR( Hue,         int     )
 	DECL_ATTR( Color,       Color&  )
 	DECL_ATTR( Tone,        Tone&   )
 	DECL_ATTR( WaveAmp,     int     )
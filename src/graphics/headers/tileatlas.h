@@ -23,6 +23,8 @@
 #define TILEATLAS_H
 
 #include "etc-internal.h"
+#include "gl-util.h"
+#include "texcache.h"
 
 #include <vector>
 
@@ -62,6 +64,27 @@ BlitVec calcBlits(int tilesetH, const Vec2i &atlasSize);
  * pixel coordinate in the atlas */
 Vec2i tileToAtlasCoor(int tileX, int tileY, int tilesetH, int atlasH);
 
+/* Identifies atlas contents by the content stamps of the
+ * Bitmaps it's built from (tileset first, then autotiles,
+ * 'NoBitmap' for unusable ones) and the atlas size */
+struct Key
+{
+	enum { NoBitmap = ~0u };
+
+	std::vector<unsigned int> stamps;
+	Vec2i size;
+
+	bool operator==(const Key &other) const
+	{
+		return size == other.size && stamps == other.stamps;
+	}
+};
+
+/* Built atlases, shared between all Tilemaps using the same
+ * tileset and autotiles. Switching back to a recently used
+ * tileset is free as long as its atlas is still idle */
+typedef TexCache<Key> Cache;
+
 }
 
 #endif // TILEATLAS_H
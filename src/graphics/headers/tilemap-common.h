@@ -110,25 +110,29 @@ atSelectSubPos(FloatRect &pos, int i)
 	}
 }
 
+/* Flash colors of the tiles in view, kept in a texture with
+ * one texel per tile and drawn as a single quad. Changing a
+ * flash cell only re-uploads the texels showing it */
 struct FlashMap
 {
 	FlashMap()
 		: dirty(false),
+	      cellChange(false),
 	      data(0),
-	      allocQuads(0)
+	      texSize(0, 0),
+	      flashCount(0)
 	{
-		vao.vbo = VBO::gen();
-		vao.ibo = shState->globalIBO().ibo;
-		GLMeta::vaoFillInVertexData<CVertex>(vao);
-
-		GLMeta::vaoInit(vao);
+		tex = TEX::gen();
+		TEX::bind(tex);
+		TEX::setRepeat(false);
+		TEX::setSmooth(false);
 	}
 
 	~FlashMap()
 	{
-		GLMeta::vaoFini(vao);
-		VBO::del(vao.vbo);
+		TEX::del(tex);
 		dataCon.disconnect();
+		cellCon.disconnect();
 	}
 
 	Table *getData() const
@@ -143,13 +147,16 @@ struct FlashMap
 
 		data = value;
 		dataCon.disconnect();
+		cellCon.disconnect();
 		dirty = true;
 
 		if (!data)
 			return;
 
 		dataCon = data->modified.connect
-			(sigc::mem_fun(this, &FlashMap::setDirty));
+			(sigc::mem_fun(this, &FlashMap::onModified));
+		cellCon = data->cellModified.connect
+			(sigc::mem_fun(this, &FlashMap::onCellModified));
 	}
 
 	void setViewport(const IntRect &value)
@@ -160,21 +167,25 @@ struct FlashMap
 
 	void prepare()
 	{
-		if (!dirty)
-			return;
-
-		rebuildBuffer();
-		dirty = false;
+		if (dirty)
+		{
+			rebuildTexels();
+			uploadAll();
+			dirty = false;
+			dirtyCells.clear();
+		}
+		else if (!dirtyCells.empty())
+		{
+			uploadDirtyCells();
+			dirtyCells.clear();
+		}
 	}
 
 	void draw(float alpha, const Vec2i &trans)
 	{
-		const size_t count = quadCount();
-
-		if (count == 0)
+		if (flashCount == 0)
 			return;
 
-		GLMeta::vaoBind(vao);
 		glState.blendMode.pushSet(BlendAddition);
 
 		FlashMapShader &shader = shState->shaders().flashMap;
@@ -182,97 +193,148 @@ struct FlashMap
 		shader.applyViewportProj();
 		shader.setAlpha(alpha);
 		shader.setTranslation(trans);
+		shader.setTexSize(texSize);
 
-		gl.DrawElements(GL_TRIANGLES, count * 6, _GL_INDEX_TYPE, 0);
+		TEX::bind(tex);
+		quad.draw();
 
 		glState.blendMode.pop();
-
-		GLMeta::vaoUnbind(vao);
 	}
 
 private:
-	void setDirty()
-	{
-		dirty = true;
-	}
+	/* Uploading many single texels costs more
+	 * than just sending the whole (small) texture */
+	enum { MaxCellUploads = 16 };
 
-	size_t quadCount() const
+	struct Texel
 	{
-		return vertices.size() / 4;
-	}
+		uint8_t r, g, b, a;
+	};
 
-	bool sampleFlashColor(Vec4 &out, int x, int y) const
+	static Texel unpackFlashColor(int16_t packed)
 	{
-		int16_t packed = tableGetWrapped(*data, x, y);
+		Texel t = { 0, 0, 0, 0 };
 
 		if (packed == 0)
-			return false;
+			return t;
 
-		const float max = 0xF;
+		/* Scale 4 bit channels to 8 bit */
+		t.b = ((packed & 0x000F) >> 0) * 0x11;
+		t.g = ((packed & 0x00F0) >> 4) * 0x11;
+		t.r = ((packed & 0x0F00) >> 8) * 0x11;
+		t.a = 0xFF;
 
-		float b = ((packed & 0x000F) >> 0) / max;
-		float g = ((packed & 0x00F0) >> 4) / max;
-		float r = ((packed & 0x0F00) >> 8) / max;
+		return t;
+	}
 
-		out = Vec4(r, g, b, 1);
+	void setTexel(int x, int y, const Texel &t)
+	{
+		Texel &old = texels[y*viewp.w + x];
 
-		return true;
+		flashCount += (t.a != 0) - (old.a != 0);
+		old = t;
 	}
 
-	void rebuildBuffer()
+	void rebuildTexels()
 	{
-		vertices.clear();
+		texels.assign(viewp.w * viewp.h, Texel());
+		flashCount = 0;
 
-		if (!data)
+		if (!data || data->xSize() == 0 || data->ySize() == 0)
 			return;
 
-		for (int x = 0; x < viewp.w; ++x)
-			for (int y = 0; y < viewp.h; ++y)
-			{
-				Vec4 color;
-
-				if (!sampleFlashColor(color, x+viewp.x, y+viewp.y))
-					continue;
+		for (int y = 0; y < viewp.h; ++y)
+			for (int x = 0; x < viewp.w; ++x)
+				setTexel(x, y, unpackFlashColor(tableGetWrapped(*data, x+viewp.x, y+viewp.y)));
+	}
 
-				FloatRect posRect(x*32, y*32, 32, 32);
+	/* Table::set() emits 'cellModified' right before 'modified';
+	 * a 'modified' on its own (eg. Table::resize()) changed the
+	 * whole layout */
+	void onModified()
+	{
+		if (cellChange)
+		{
+			cellChange = false;
+			return;
+		}
 
-				CVertex v[4];
-				Quad::setPosRect(v, posRect);
-				Quad::setColor(v, color);
+		dirty = true;
+	}
 
-				for (size_t i = 0; i < 4; ++i)
-					vertices.push_back(v[i]);
-			}
+	void onCellModified(int x, int y, int z)
+	{
+		cellChange = true;
 
-		if (vertices.size() == 0)
+		if (dirty || z != 0)
 			return;
 
-		VBO::bind(vao.vbo);
+		const Texel t = unpackFlashColor(data->get(x, y));
+
+		/* With wrapping, a cell may show up in
+		 * the viewport more than once */
+		for (int vy = wrap(y - viewp.y, data->ySize()); vy < viewp.h; vy += data->ySize())
+			for (int vx = wrap(x - viewp.x, data->xSize()); vx < viewp.w; vx += data->xSize())
+			{
+				setTexel(vx, vy, t);
+				dirtyCells.push_back(Vec2i(vx, vy));
+			}
+	}
+
+	void uploadAll()
+	{
+		TEX::bind(tex);
 
-		if (quadCount() > allocQuads)
+		if (texSize != viewp.size())
 		{
-			allocQuads = quadCount();
-			VBO::allocEmpty(sizeof(CVertex) * vertices.size());
+			texSize = viewp.size();
+			TEX::allocEmpty(texSize.x, texSize.y);
+
+			quad.setTexPosRect(FloatRect(0, 0, texSize.x, texSize.y),
+			                   FloatRect(0, 0, texSize.x*32, texSize.y*32));
 		}
 
-		VBO::uploadSubData(0, sizeof(CVertex) * vertices.size(), dataPtr(vertices));
+		if (!texels.empty())
+			TEX::uploadSubImage(0, 0, texSize.x, texSize.y, dataPtr(texels), GL_RGBA);
+	}
+
+	void uploadDirtyCells()
+	{
+		if (dirtyCells.size() > MaxCellUploads)
+		{
+			uploadAll();
+			return;
+		}
 
-		VBO::unbind();
+		TEX::bind(tex);
 
-		/* Ensure global IBO size */
-		shState->ensureQuadIBO(quadCount());
+		for (size_t i = 0; i < dirtyCells.size(); ++i)
+		{
+			const Vec2i &c = dirtyCells[i];
+			TEX::uploadSubImage(c.x, c.y, 1, 1, &texels[c.y*viewp.w + c.x], GL_RGBA);
+		}
 	}
 
+	/* Everything needs to be rebuilt */
 	bool dirty;
+	/* 'modified' about to follow a handled 'cellModified' */
+	bool cellChange;
+	/* Viewport cells changed since the last upload */
+	std::vector<Vec2i> dirtyCells;
 
 	Table *data;
 	sigc::connection dataCon;
+	sigc::connection cellCon;
 
 	IntRect viewp;
 
-	GLMeta::VAO vao;
-	size_t allocQuads;
-	std::vector<CVertex> vertices;
+	TEX::ID tex;
+	Vec2i texSize;
+	Quad quad;
+
+	std::vector<Texel> texels;
+	/* Texels with a flash color */
+	int flashCount;
 };
 
 #endif // TILEMAPCOMMON_H
@@ -0,0 +1,62 @@
+/*
+** windowframe.h
+**
+** This file is part of mkxp.
+**
+** Copyright (C) 2013 Jonas Kulla <Nyocurio@gmail.com>
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef WINDOWFRAME_H
+#define WINDOWFRAME_H
+
+#include "etc-internal.h"
+#include "texcache.h"
+
+namespace WindowFrame
+{
+
+/* Identifies a rendered window frame (background and
+ * borders) by the windowskin's content stamp and
+ * everything else that goes into drawing it */
+struct Key
+{
+	unsigned int skinStamp;
+	Vec2i size;
+	int backOpacity;
+	bool bgStretch;
+
+	Key()
+	    : skinStamp(0),
+	      backOpacity(0),
+	      bgStretch(false)
+	{}
+
+	bool operator==(const Key &other) const
+	{
+		return skinStamp == other.skinStamp && size == other.size &&
+		       backOpacity == other.backOpacity && bgStretch == other.bgStretch;
+	}
+};
+
+/* Rendered frames, shared between all Windows using the same
+ * skin at the same size, so reopening a message or choice
+ * window is free as long as its frame is still idle */
+typedef TexCache<Key> Cache;
+
+}
+
+#endif // WINDOWFRAME_H
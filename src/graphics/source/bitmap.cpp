@@ -29,8 +29,12 @@
 
 #include <pixman.h>
 
+#include <string.h>
+#include <vector>
+
 #include "gl-util.h"
 #include "gl-meta.h"
+#include "megatexture.h"
 #include "quad.h"
 #include "quadarray.h"
 #include "transform.h"
@@ -46,7 +50,7 @@
 
 #define GUARD_MEGA \
 	{ \
-		if (p->megaSurface) \
+		if (p->mega) \
 			throw Exception(Exception::MKXPError, \
                             "Operation not supported for mega surfaces"); \
 	}
@@ -82,11 +86,11 @@ struct BitmapPrivate
 
 	Font *font;
 
-	/* "Mega surfaces" are a hack to allow Tilesets to be used
-	 * whose Bitmaps don't fit into a regular texture. They're
-	 * kept in RAM and will throw an error if they're used in
-	 * any context other than as Tilesets */
-	SDL_Surface *megaSurface;
+	/* "Mega surfaces" are Bitmaps that don't fit into a regular
+	 * texture. They're split into pages, and can be drawn and
+	 * used as blit sources, but will throw an error on any
+	 * operation modifying them */
+	MegaTexture *mega;
 
 	/* A cached version of the bitmap in client memory, for
 	 * getPixel calls. Is invalidated any time the bitmap
@@ -94,6 +98,16 @@ struct BitmapPrivate
 	SDL_Surface *surface;
 	SDL_PixelFormat *format;
 
+	/* With "pixelShadowBuffer", 'surface' is instead kept as
+	 * a CPU side copy of the texture. setPixel only writes to
+	 * it, and the touched area ('pending') is uploaded in one
+	 * go before the texture is next used. GPU operations mark
+	 * the area they drew to as 'stale', which is read back
+	 * once a getPixel call actually needs it */
+	bool shadow;
+	IntRect pending;
+	pixman_region16_t stale;
+
 	/* The 'tainted' area describes which parts of the
 	 * bitmap are not cleared, ie. don't have 0 opacity.
 	 * If we're blitting / drawing text to a cleared part
@@ -102,21 +116,33 @@ struct BitmapPrivate
 	 * ourselves the expensive blending calculation */
 	pixman_region16_t tainted;
 
+	/* Renewed from the global stamp counter on every
+	 * modification, so it identifies both the Bitmap
+	 * and its current contents */
+	unsigned int stamp;
+
 	BitmapPrivate(Bitmap *self)
 	    : self(self),
-	      megaSurface(0),
-	      surface(0)
+	      mega(0),
+	      surface(0),
+	      shadow(shState->config().pixelShadowBuffer),
+	      stamp(shState->genTimeStamp())
 	{
 		format = SDL_AllocFormat(SDL_PIXELFORMAT_ABGR8888);
 
 		font = &shState->defaultFont();
 		pixman_region_init(&tainted);
+		pixman_region_init(&stale);
 	}
 
 	~BitmapPrivate()
 	{
+		if (surface)
+			SDL_FreeSurface(surface);
+
 		SDL_FreeFormat(format);
 		pixman_region_fini(&tainted);
+		pixman_region_fini(&stale);
 	}
 
 	void allocSurface()
@@ -166,14 +192,94 @@ struct BitmapPrivate
 		return result != PIXMAN_REGION_OUT;
 	}
 
+	void ensureShadow()
+	{
+		if (surface)
+			return;
+
+		/* Fresh surfaces are zeroed, which is all an
+		 * untainted bitmap can contain */
+		allocSurface();
+
+		if (pixman_region_not_empty(&tainted))
+			markStale(IntRect(0, 0, gl.width, gl.height));
+	}
+
+	void markStale(const IntRect &rect)
+	{
+		IntRect norm = normalizedRect(rect);
+		pixman_region_union_rect
+		        (&stale, &stale, norm.x, norm.y, norm.w, norm.h);
+
+		/* Keep it within the bitmap */
+		pixman_region_intersect_rect
+		        (&stale, &stale, 0, 0, gl.width, gl.height);
+	}
+
+	bool touchesStale(const IntRect &rect)
+	{
+		pixman_box16_t box;
+		box.x1 = rect.x;
+		box.y1 = rect.y;
+		box.x2 = rect.x + rect.w;
+		box.y2 = rect.y + rect.h;
+
+		return pixman_region_contains_rectangle(&stale, &box)
+		        != PIXMAN_REGION_OUT;
+	}
+
+	/* Uploads pixels written since the texture was last used */
+	void flushPending()
+	{
+		if (pending.w == 0)
+			return;
+
+		TEX::bind(gl.tex);
+		GLMeta::subRectImageUpload(surface->w, pending.x, pending.y,
+		                           pending.x, pending.y, pending.w, pending.h,
+		                           surface, GL_RGBA);
+		GLMeta::subRectImageEnd();
+
+		pending = IntRect();
+	}
+
+	/* Reads back whatever GPU operations drew since the last sync */
+	void syncStale()
+	{
+		flushPending();
+
+		if (!pixman_region_not_empty(&stale))
+			return;
+
+		const pixman_box16_t *ext = pixman_region_extents(&stale);
+		const int w = ext->x2 - ext->x1;
+		const int h = ext->y2 - ext->y1;
+
+		std::vector<uint8_t> buffer(w * h * 4);
+
+		FBO::bind(gl.fbo);
+		::gl.ReadPixels(ext->x1, ext->y1, w, h, GL_RGBA, GL_UNSIGNED_BYTE, &buffer[0]);
+
+		for (int y = 0; y < h; ++y)
+			memcpy((uint8_t*) surface->pixels + (ext->y1 + y) * surface->pitch + ext->x1 * 4,
+			       &buffer[y * w * 4], w * 4);
+
+		pixman_region_fini(&stale);
+		pixman_region_init(&stale);
+	}
+
 	void bindTexture(ShaderBase &shader)
 	{
+		flushPending();
+
 		TEX::bind(gl.tex);
 		shader.setTexSize(Vec2i(gl.width, gl.height));
 	}
 
 	void bindFBO()
 	{
+		flushPending();
+
 		FBO::bind(gl.fbo);
 	}
 
@@ -225,12 +331,36 @@ struct BitmapPrivate
 	{
 		if (surface && freeSurface)
 		{
-			SDL_FreeSurface(surface);
-			surface = 0;
+			if (shadow)
+			{
+				markStale(IntRect(0, 0, gl.width, gl.height));
+			}
+			else
+			{
+				SDL_FreeSurface(surface);
+				surface = 0;
+			}
 		}
 
+		stamp = shState->genTimeStamp();
 		self->modified();
 	}
+
+	/* Like the above, for GPU operations that
+	 * only drew to 'rect' */
+	void onModified(const IntRect &rect)
+	{
+		if (surface && shadow)
+		{
+			markStale(rect);
+			stamp = shState->genTimeStamp();
+			self->modified();
+
+			return;
+		}
+
+		onModified();
+	}
 };
 
 struct BitmapOpenHandler : FileSystem::OpenHandler
@@ -264,8 +394,7 @@ Bitmap::Bitmap(const char *filename)
 	{
 		/* Mega surface */
 		p = new BitmapPrivate(this);
-		p->megaSurface = imgSurf;
-		SDL_SetSurfaceBlendMode(p->megaSurface, SDL_BLENDMODE_NONE);
+		p->mega = new MegaTexture(imgSurf);
 	}
 	else
 	{
@@ -327,8 +456,8 @@ int Bitmap::width() const
 {
 	guardDisposed();
 
-	if (p->megaSurface)
-		return p->megaSurface->w;
+	if (p->mega)
+		return p->mega->width();
 
 	return p->gl.width;
 }
@@ -337,8 +466,8 @@ int Bitmap::height() const
 {
 	guardDisposed();
 
-	if (p->megaSurface)
-		return p->megaSurface->h;
+	if (p->mega)
+		return p->mega->height();
 
 	return p->gl.height;
 }
@@ -389,92 +518,54 @@ void Bitmap::stretchBlt(const IntRect &destRect,
 	if (opacity == 0)
 		return;
 
-	SDL_Surface *srcSurf = source.megaSurface();
-
-	if (srcSurf && shState->config().subImageFix)
-	{
-		/* Blit from software surface, for broken GL drivers */
-		Vec2i gpTexSize;
-		shState->ensureTexSize(sourceRect.w, sourceRect.h, gpTexSize);
-		shState->bindTex();
-
-		GLMeta::subRectImageUpload(srcSurf->w, sourceRect.x, sourceRect.y, 0, 0,
-		                           sourceRect.w, sourceRect.h, srcSurf, GL_RGBA);
-		GLMeta::subRectImageEnd();
-
-		SimpleShader &shader = shState->shaders().simple;
-		shader.bind();
-		shader.setTranslation(Vec2i());
-		shader.setTexSize(gpTexSize);
+	p->flushPending();
+	source.p->flushPending();
 
-		p->pushSetViewport(shader);
-		p->bindFBO();
-
-		Quad &quad = shState->gpQuad();
-		quad.setTexRect(FloatRect(0, 0, sourceRect.w, sourceRect.h));
-		quad.setPosRect(destRect);
-
-		p->blitQuad(quad);
-		p->popViewport();
-
-		p->addTaintedArea(destRect);
-		p->onModified();
+	TEXFBO *srcTex = &source.p->gl;
+	IntRect srcRect = sourceRect;
+	TEXFBO megaTemp;
 
-		return;
-	}
-	else if (srcSurf)
+	if (MegaTexture *mega = source.p->mega)
 	{
-		/* Blit from software surface */
-		/* Don't do transparent blits for now */
-		if (opacity < 255)
-			source.ensureNonMega();
+		if (opacity == 255 && !p->touchesTaintedArea(destRect) &&
+		    sourceRect.w > 0 && sourceRect.h > 0)
+		{
+			/* Copy straight from the pages */
+			mega->blit(p->gl, sourceRect, destRect);
 
-		SDL_Rect srcRect = sourceRect;
-		SDL_Rect dstRect = destRect;
-		SDL_Rect btmRect = { 0, 0, width(), height() };
-		SDL_Rect bltRect;
+			p->addTaintedArea(destRect);
+			p->onModified(destRect);
 
-		if (SDL_IntersectRect(&btmRect, &dstRect, &bltRect) != SDL_TRUE)
 			return;
+		}
 
-		int bpp;
-		Uint32 rMask, gMask, bMask, aMask;
-		SDL_PixelFormatEnumToMasks(SDL_PIXELFORMAT_ABGR8888,
-		                           &bpp, &rMask, &gMask, &bMask, &aMask);
-		SDL_Surface *blitTemp =
-			SDL_CreateRGBSurface(0, destRect.w, destRect.h, bpp, rMask, gMask, bMask, aMask);
+		/* Gather the source area into one texture, and
+		 * continue as if it was a regular bitmap */
+		const IntRect gather = normalizedRect(sourceRect);
 
-		SDL_BlitScaled(srcSurf, &srcRect, blitTemp, 0);
+		if (gather.w == 0 || gather.h == 0)
+			return;
 
-		TEX::bind(p->gl.tex);
+		megaTemp = shState->texPool().request(gather.w, gather.h);
 
-		if (bltRect.w == dstRect.w && bltRect.h == dstRect.h)
-		{
-			/* Dest rectangle lies within bounding box */
-			TEX::uploadSubImage(destRect.x, destRect.y,
-			                    destRect.w, destRect.h,
-			                    blitTemp->pixels, GL_RGBA);
-		}
-		else
-		{
-			/* Clipped blit */
-			GLMeta::subRectImageUpload(blitTemp->w, bltRect.x - dstRect.x, bltRect.y - dstRect.y,
-			                           bltRect.x, bltRect.y, bltRect.w, bltRect.h, blitTemp, GL_RGBA);
-			GLMeta::subRectImageEnd();
-		}
+		FBO::bind(megaTemp.fbo);
+		glState.clearColor.pushSet(Vec4());
+		FBO::clear();
+		glState.clearColor.pop();
 
-		SDL_FreeSurface(blitTemp);
+		mega->blit(megaTemp, gather, IntRect(0, 0, gather.w, gather.h));
 
-		p->onModified();
-		return;
+		srcTex = &megaTemp;
+		srcRect.x -= gather.x;
+		srcRect.y -= gather.y;
 	}
 
 	if (opacity == 255 && !p->touchesTaintedArea(destRect))
 	{
 		/* Fast blit */
 		GLMeta::blitBegin(p->gl);
-		GLMeta::blitSource(source.p->gl);
-		GLMeta::blitRectangle(sourceRect, destRect);
+		GLMeta::blitSource(*srcTex);
+		GLMeta::blitRectangle(srcRect, destRect);
 		GLMeta::blitEnd();
 	}
 	else
@@ -489,10 +580,10 @@ void Bitmap::stretchBlt(const IntRect &destRect,
 		GLMeta::blitRectangle(destRect, Vec2i());
 		GLMeta::blitEnd();
 
-		FloatRect bltSubRect((float) sourceRect.x / source.width(),
-		                     (float) sourceRect.y / source.height(),
-		                     ((float) source.width() / sourceRect.w) * ((float) destRect.w / gpTex.width),
-		                     ((float) source.height() / sourceRect.h) * ((float) destRect.h / gpTex.height));
+		FloatRect bltSubRect((float) srcRect.x / srcTex->width,
+		                     (float) srcRect.y / srcTex->height,
+		                     ((float) srcTex->width / srcRect.w) * ((float) destRect.w / gpTex.width),
+		                     ((float) srcTex->height / srcRect.h) * ((float) destRect.h / gpTex.height));
 
 		BltShader &shader = shState->shaders().blt;
 		shader.bind();
@@ -501,10 +592,11 @@ void Bitmap::stretchBlt(const IntRect &destRect,
 		shader.setOpacity(normOpacity);
 
 		Quad &quad = shState->gpQuad();
-		quad.setTexPosRect(sourceRect, destRect);
+		quad.setTexPosRect(srcRect, destRect);
 		quad.setColor(Vec4(1, 1, 1, normOpacity));
 
-		source.p->bindTexture(shader);
+		TEX::bind(srcTex->tex);
+		shader.setTexSize(Vec2i(srcTex->width, srcTex->height));
 		p->bindFBO();
 		p->pushSetViewport(shader);
 
@@ -513,8 +605,11 @@ void Bitmap::stretchBlt(const IntRect &destRect,
 		p->popViewport();
 	}
 
+	if (megaTemp.tex != TEX::ID(0))
+		shState->texPool().release(megaTemp);
+
 	p->addTaintedArea(destRect);
-	p->onModified();
+	p->onModified(destRect);
 }
 
 void Bitmap::fillRect(int x, int y,
@@ -539,7 +634,7 @@ void Bitmap::fillRect(const IntRect &rect, const Vec4 &color)
 		/* Fill op */
 		p->addTaintedArea(rect);
 
-	p->onModified();
+	p->onModified(rect);
 }
 
 void Bitmap::gradientFillRect(int x, int y,
@@ -590,7 +685,7 @@ void Bitmap::gradientFillRect(const IntRect &rect,
 
 	p->addTaintedArea(rect);
 
-	p->onModified();
+	p->onModified(rect);
 }
 
 void Bitmap::clearRect(int x, int y, int width, int height)
@@ -606,7 +701,7 @@ void Bitmap::clearRect(const IntRect &rect)
 
 	p->fillRect(rect, Vec4());
 
-	p->onModified();
+	p->onModified(rect);
 }
 
 void Bitmap::mask(Bitmap *mask, int x, int y)
@@ -615,6 +710,9 @@ void Bitmap::mask(Bitmap *mask, int x, int y)
 
 	GUARD_MEGA;
 
+	p->flushPending();
+	mask->p->flushPending();
+
 	Quad &quad = shState->gpQuad();
 	FloatRect rect(0, 0, width(), height());
 	quad.setTexPosRect(rect, rect);
@@ -658,6 +756,8 @@ void Bitmap::blur()
 
 	GUARD_MEGA;
 
+	p->flushPending();
+
 	Quad &quad = shState->gpQuad();
 	FloatRect rect(0, 0, width(), height());
 	quad.setTexPosRect(rect, rect);
@@ -798,6 +898,9 @@ void Bitmap::clear()
 
 	GUARD_MEGA;
 
+	/* Whatever setPixel wrote is about to be cleared anyway */
+	p->pending = IntRect();
+
 	p->bindFBO();
 
 	glState.clearColor.pushSet(Vec4());
@@ -808,7 +911,20 @@ void Bitmap::clear()
 
 	p->clearTaintedArea();
 
-	p->onModified();
+	if (p->shadow && p->surface)
+	{
+		/* No need to read back what we know is empty */
+		memset(p->surface->pixels, 0, p->surface->pitch * p->surface->h);
+
+		pixman_region_fini(&p->stale);
+		pixman_region_init(&p->stale);
+
+		p->onModified(false);
+	}
+	else
+	{
+		p->onModified();
+	}
 }
 
 static uint32_t &getPixelAt(SDL_Surface *surf, SDL_PixelFormat *form, int x, int y)
@@ -828,7 +944,15 @@ Color Bitmap::getPixel(int x, int y) const
 	if (x < 0 || y < 0 || x >= width() || y >= height())
 		return Vec4();
 
-	if (!p->surface)
+	if (p->shadow)
+	{
+		p->ensureShadow();
+
+		/* Only sync if the GPU drew over this pixel */
+		if (pixman_region_contains_point(&p->stale, x, y, 0))
+			p->syncStale();
+	}
+	else if (!p->surface)
 	{
 		p->allocSurface();
 
@@ -863,6 +987,52 @@ void Bitmap::setPixel(int x, int y, const Color &color)
 		(uint8_t) clamp<double>(color.alpha, 0, 255)
 	};
 
+	if (p->shadow)
+	{
+		if (x < 0 || y < 0 || x >= width() || y >= height())
+			return;
+
+		p->ensureShadow();
+
+		uint32_t &surfPixel = getPixelAt(p->surface, p->format, x, y);
+		surfPixel = SDL_MapRGBA(p->format, pixel[0], pixel[1], pixel[2], pixel[3]);
+
+		/* This pixel is now up to date on our side */
+		pixman_region16_t px;
+		pixman_region_init_rect(&px, x, y, 1, 1);
+		pixman_region_subtract(&p->stale, &p->stale, &px);
+		pixman_region_fini(&px);
+
+		/* Grow the pending upload, as long as it
+		 * doesn't pick up any stale pixels */
+		IntRect pixelRect(x, y, 1, 1);
+
+		if (p->pending.w == 0)
+		{
+			p->pending = pixelRect;
+		}
+		else
+		{
+			IntRect grown;
+			SDL_UnionRect(&p->pending, &pixelRect, &grown);
+
+			if (p->touchesStale(grown))
+			{
+				p->flushPending();
+				p->pending = pixelRect;
+			}
+			else
+			{
+				p->pending = grown;
+			}
+		}
+
+		p->addTaintedArea(pixelRect);
+		p->onModified(false);
+
+		return;
+	}
+
 	TEX::bind(p->gl.tex);
 	TEX::uploadSubImage(x, y, 1, 1, &pixel, GL_RGBA);
 
@@ -1042,6 +1212,8 @@ void Bitmap::drawText(const IntRect &rect, const char *str, int align)
 	if (str[0] == ' ' && str[1] == '\0')
 		return;
 
+	p->flushPending();
+
 	TTF_Font *font = p->font->getSdlFont();
 	const Color &fontColor = p->font->getColor();
 	const Color &outColor = p->font->getOutColor();
@@ -1241,7 +1413,8 @@ void Bitmap::drawText(const IntRect &rect, const char *str, int align)
 	SDL_FreeSurface(txtSurf);
 	p->addTaintedArea(posRect);
 
-	p->onModified();
+	/* Scaled text can bleed into the neighbouring pixels */
+	p->onModified(IntRect(posRect.x - 1, posRect.y - 1, posRect.w + 2, posRect.h + 2));
 }
 
 /* http://www.lemoda.net/c/utf8-to-ucs2/index.html */
@@ -1328,12 +1501,14 @@ void Bitmap::setInitFont(Font *value)
 
 TEXFBO &Bitmap::getGLTypes()
 {
+	p->flushPending();
+
 	return p->gl;
 }
 
-SDL_Surface *Bitmap::megaSurface() const
+MegaTexture *Bitmap::megaTexture() const
 {
-	return p->megaSurface;
+	return p->mega;
 }
 
 void Bitmap::ensureNonMega() const
@@ -1349,15 +1524,46 @@ void Bitmap::bindTex(ShaderBase &shader)
 	p->bindTexture(shader);
 }
 
+IntRect Bitmap::viewRect(const IntRect &rect) const
+{
+	if (p->mega)
+		return p->mega->viewRect(rect);
+
+	return IntRect(0, 0, p->gl.width, p->gl.height);
+}
+
+void Bitmap::prepareView(const IntRect &rect)
+{
+	if (p->mega)
+		p->mega->prepareView(rect);
+}
+
+void Bitmap::bindTex(ShaderBase &shader, const IntRect &rect)
+{
+	if (p->mega)
+		p->mega->bindView(shader, rect);
+	else
+		p->bindTexture(shader);
+}
+
+unsigned int Bitmap::contentStamp() const
+{
+	return p->stamp;
+}
+
 void Bitmap::taintArea(const IntRect &rect)
 {
 	p->addTaintedArea(rect);
+	p->stamp = shState->genTimeStamp();
+
+	if (p->shadow && p->surface)
+		p->markStale(rect);
 }
 
 void Bitmap::releaseResources()
 {
-	if (p->megaSurface)
-		SDL_FreeSurface(p->megaSurface);
+	if (p->mega)
+		delete p->mega;
 	else
 		shState->texPool().release(p->gl);
 
@@ -0,0 +1,541 @@
+/*
+** frameprofiler.cpp
+**
+** This file is part of mkxp.
+**
+** Copyright (C) 2013 Jonas Kulla <Nyocurio@gmail.com>
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "frameprofiler.h"
+
+#include "config.h"
+#include "sharedstate.h"
+#include "glstate.h"
+#include "gl-fun.h"
+#include "shader.h"
+#include "quad.h"
+#include "quadarray.h"
+#include "etc-internal.h"
+#include "debugwriter.h"
+
+#include <SDL2/SDL_timer.h>
+
+#include <stdio.h>
+#include <ctype.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include <deque>
+#include <map>
+#include <string>
+
+/* Frames shown in the overlay graph */
+#define HISTORY_FRAMES 120
+
+/* Overlay layout, in window pixels */
+#define GRAPH_X 8
+#define GRAPH_Y 8
+#define GRAPH_PX_PER_MS 2
+#define GRAPH_MAX_MS 50
+#define GRAPH_CPU_W 2
+#define GRAPH_STRIDE 4
+
+/* Trace thread ids */
+#define TID_CPU 1
+#define TID_GPU 2
+
+static const char *phaseNames[] =
+{
+	"script",
+	"prepareDraw",
+	"composite",
+	"postEffects",
+	"swap",
+	"limiterSleep"
+};
+
+static const Vec4 phaseColors[] =
+{
+	Vec4(0.95f, 0.80f, 0.20f, 0.9f), /* script: yellow */
+	Vec4(0.60f, 0.40f, 0.90f, 0.9f), /* prepareDraw: purple */
+	Vec4(0.20f, 0.80f, 0.30f, 0.9f), /* composite: green */
+	Vec4(0.20f, 0.60f, 0.95f, 0.9f), /* postEffects: blue */
+	Vec4(0.95f, 0.35f, 0.25f, 0.9f), /* swap: red */
+	Vec4(0.35f, 0.35f, 0.35f, 0.6f)  /* limiterSleep: dark gray */
+};
+
+static const Vec4 otherColor(0.75f, 0.75f, 0.75f, 0.9f);
+static const Vec4 gpuColor(0.95f, 0.30f, 0.85f, 0.9f);
+static const Vec4 budgetColor(1, 1, 1, 0.6f);
+static const Vec4 backColor(0, 0, 0, 0.5f);
+
+struct FrameSample
+{
+	double phaseMs[FrameProfiler::PhaseCount];
+	double totalMs;
+	double gpuMs;
+
+	void clear()
+	{
+		memset(this, 0, sizeof(*this));
+	}
+};
+
+struct FrameProfilerPrivate
+{
+	struct Scope
+	{
+		const char *name;
+		int phase;
+		uint64_t start;
+		/* Time spent in nested phases */
+		uint64_t childPhaseTicks;
+		GLuint gpuBegin;
+	};
+
+	struct GpuPass
+	{
+		const char *name;
+		uint64_t cpuStartUs;
+		GLuint begin, end;
+		unsigned int frame;
+	};
+
+	FILE *trace;
+	bool firstEvent;
+	bool overlay;
+	bool gpuTimers;
+
+	uint64_t freq;
+	uint64_t origin;
+	uint64_t frameStart;
+	uint64_t scriptStart;
+	unsigned int frame;
+
+	uint64_t phaseTicks[FrameProfiler::PhaseCount];
+
+	std::vector<Scope> stack;
+	std::deque<GpuPass> gpuPending;
+	std::vector<GLuint> freeQueries;
+
+	FrameSample history[HISTORY_FRAMES];
+
+	/* Readable names of SceneElement subclasses,
+	 * keyed by type_info::name() */
+	std::map<const char*, std::string> typeNames;
+
+	ColorQuadArray *overlayQuads;
+
+	FrameProfilerPrivate(const Config &conf)
+	    : trace(0),
+	      firstEvent(true),
+	      overlay(conf.frameProfiler),
+	      gpuTimers(gl.QueryCounter != 0),
+	      freq(SDL_GetPerformanceFrequency()),
+	      origin(SDL_GetPerformanceCounter()),
+	      frameStart(origin),
+	      scriptStart(origin),
+	      frame(0),
+	      overlayQuads(0)
+	{
+		memset(phaseTicks, 0, sizeof(phaseTicks));
+
+		for (size_t i = 0; i < HISTORY_FRAMES; ++i)
+			history[i].clear();
+
+		if (!conf.frameProfilerTrace.empty())
+			openTrace(conf.frameProfilerTrace.c_str());
+
+		if (!gpuTimers)
+			Debug() << "FrameProfiler: No timer queries, GPU times unavailable";
+	}
+
+	~FrameProfilerPrivate()
+	{
+		if (trace)
+		{
+			fputs("\n]\n", trace);
+			fclose(trace);
+		}
+
+		for (size_t i = 0; i < gpuPending.size(); ++i)
+		{
+			freeQueries.push_back(gpuPending[i].begin);
+			freeQueries.push_back(gpuPending[i].end);
+		}
+
+		if (!freeQueries.empty())
+			gl.DeleteQueries(freeQueries.size(), &freeQueries[0]);
+
+		delete overlayQuads;
+	}
+
+	void openTrace(const char *path)
+	{
+		trace = fopen(path, "w");
+
+		if (!trace)
+		{
+			Debug() << "FrameProfiler: Cannot open" << path << "for writing";
+			return;
+		}
+
+		fputs("[\n", trace);
+
+		writeThreadName(TID_CPU, "CPU");
+		writeThreadName(TID_GPU, "GPU");
+	}
+
+	void separate()
+	{
+		if (!firstEvent)
+			fputs(",\n", trace);
+
+		firstEvent = false;
+	}
+
+	void writeThreadName(int tid, const char *name)
+	{
+		separate();
+		fprintf(trace, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+		               "\"args\":{\"name\":\"%s\"}}", tid, name);
+	}
+
+	void writeComplete(const char *name, const char *cat, int tid,
+	                   uint64_t tsUs, uint64_t durUs)
+	{
+		if (!trace)
+			return;
+
+		separate();
+		fprintf(trace, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+		               "\"ts\":%llu,\"dur\":%llu}",
+		        name, cat, tid, (unsigned long long) tsUs, (unsigned long long) durUs);
+	}
+
+	void writeCounters(uint64_t tsUs, const GLCallStats &stats)
+	{
+		if (!trace)
+			return;
+
+		separate();
+		fprintf(trace, "{\"name\":\"gl\",\"ph\":\"C\",\"pid\":1,\"ts\":%llu,"
+		               "\"args\":{\"draws\":%u,\"texUploads\":%u,\"uploadBytes\":%u,"
+		               "\"texAllocs\":%u,\"bufUploads\":%u,\"bufBytes\":%u,"
+		               "\"issued\":%u,\"elided\":%u}}",
+		        (unsigned long long) tsUs, stats.draws, stats.texUploads,
+		        stats.uploadBytes, stats.texAllocs, stats.bufUploads,
+		        stats.bufBytes, stats.issued, stats.elided);
+	}
+
+	uint64_t ticksToUs(uint64_t ticks) const
+	{
+		return (double) ticks * 1000000.0 / freq;
+	}
+
+	double ticksToMs(uint64_t ticks) const
+	{
+		return (double) ticks * 1000.0 / freq;
+	}
+
+	uint64_t timestampUs(uint64_t ticks) const
+	{
+		return ticksToUs(ticks - origin);
+	}
+
+	const char *typeName(const std::type_info &type)
+	{
+		const char *key = type.name();
+		std::map<const char*, std::string>::iterator iter = typeNames.find(key);
+
+		if (iter != typeNames.end())
+			return iter->second.c_str();
+
+		/* Strip the Itanium length prefix ("6Sprite")
+		 * or MSVC's "class " */
+		const char *name = key;
+
+		while (isdigit(*name))
+			++name;
+
+		if (!strncmp(name, "class ", 6))
+			name += 6;
+
+		return (typeNames[key] = name).c_str();
+	}
+
+	GLuint genQuery()
+	{
+		GLuint query;
+
+		if (freeQueries.empty())
+		{
+			gl.GenQueries(1, &query);
+		}
+		else
+		{
+			query = freeQueries.back();
+			freeQueries.pop_back();
+		}
+
+		return query;
+	}
+
+	/* Collects GPU timings that have become available without
+	 * waiting on the ones that haven't */
+	void resolveGpuPasses()
+	{
+		while (!gpuPending.empty())
+		{
+			const GpuPass &pass = gpuPending.front();
+
+			GLint available = 0;
+			gl.GetQueryObjectiv(pass.end, GL_QUERY_RESULT_AVAILABLE, &available);
+
+			if (!available)
+				break;
+
+			uint64_t begin = 0, end = 0;
+			gl.GetQueryObjectui64v(pass.begin, GL_QUERY_RESULT, &begin);
+			gl.GetQueryObjectui64v(pass.end, GL_QUERY_RESULT, &end);
+
+			const uint64_t durNs = end > begin ? end - begin : 0;
+
+			/* GPU and CPU clocks aren't related; place the pass
+			 * where it was submitted */
+			writeComplete(pass.name, "gpu", TID_GPU, pass.cpuStartUs, durNs / 1000);
+
+			if (frame - pass.frame < HISTORY_FRAMES)
+				history[pass.frame % HISTORY_FRAMES].gpuMs += durNs / 1000000.0;
+
+			freeQueries.push_back(pass.begin);
+			freeQueries.push_back(pass.end);
+			gpuPending.pop_front();
+		}
+	}
+
+	void buildOverlay(double budgetMs)
+	{
+		ColorQuadArray &qa = *overlayQuads;
+		qa.resize(2 + HISTORY_FRAMES * (FrameProfiler::PhaseCount + 2));
+
+		size_t n = 0;
+
+		const float maxH = GRAPH_MAX_MS * GRAPH_PX_PER_MS;
+
+		addRect(n, FloatRect(GRAPH_X - 2, GRAPH_Y - 2,
+		                     HISTORY_FRAMES * GRAPH_STRIDE + 4, maxH + 4), backColor);
+
+		/* Oldest frame on the left, the one just finished on the right */
+		for (size_t i = 0; i < HISTORY_FRAMES; ++i)
+		{
+			const unsigned int f = frame - HISTORY_FRAMES + i;
+
+			if (f >= frame)
+				continue;
+
+			const FrameSample &s = history[f % HISTORY_FRAMES];
+			const float x = GRAPH_X + i * GRAPH_STRIDE;
+			float y = GRAPH_Y;
+			double accounted = 0;
+
+			for (int j = 0; j < FrameProfiler::PhaseCount; ++j)
+			{
+				addBar(n, x, y, GRAPH_CPU_W, s.phaseMs[j], phaseColors[j]);
+				accounted += s.phaseMs[j];
+			}
+
+			addBar(n, x, y, GRAPH_CPU_W, s.totalMs - accounted, otherColor);
+
+			y = GRAPH_Y;
+			addBar(n, x + GRAPH_CPU_W, y, 1, s.gpuMs, gpuColor);
+		}
+
+		const float budgetY = GRAPH_Y + std::min<double>(budgetMs, GRAPH_MAX_MS) * GRAPH_PX_PER_MS;
+		addRect(n, FloatRect(GRAPH_X - 2, budgetY, HISTORY_FRAMES * GRAPH_STRIDE + 4, 1), budgetColor);
+
+		qa.resize(n);
+	}
+
+	/* Stacks a bar of 'ms' height on top of 'y', clipped to the graph */
+	void addBar(size_t &n, float x, float &y, float w, double ms, const Vec4 &color)
+	{
+		const float top = GRAPH_Y + GRAPH_MAX_MS * GRAPH_PX_PER_MS;
+		const float h = std::min<float>(ms * GRAPH_PX_PER_MS, top - y);
+
+		if (h <= 0)
+			return;
+
+		addRect(n, FloatRect(x, y, w, h), color);
+		y += h;
+	}
+
+	void addRect(size_t &n, const FloatRect &rect, const Vec4 &color)
+	{
+		Vertex *vert = &overlayQuads->vertices[n++ * 4];
+
+		Quad::setPosRect(vert, rect);
+		Quad::setColor(vert, color);
+	}
+};
+
+FrameProfiler::FrameProfiler(const Config &conf)
+    : active(conf.frameProfiler || !conf.frameProfilerTrace.empty()),
+      p(0)
+{
+	if (active)
+		p = new FrameProfilerPrivate(conf);
+}
+
+FrameProfiler::~FrameProfiler()
+{
+	delete p;
+}
+
+void FrameProfiler::begin(const char *name, Phase phase, bool gpu)
+{
+	FrameProfilerPrivate::Scope scope;
+	scope.name = name;
+	scope.phase = phase;
+	scope.start = SDL_GetPerformanceCounter();
+	scope.childPhaseTicks = 0;
+	scope.gpuBegin = 0;
+
+	if (gpu && p->gpuTimers)
+	{
+		scope.gpuBegin = p->genQuery();
+		gl.QueryCounter(scope.gpuBegin, GL_TIMESTAMP);
+	}
+
+	p->stack.push_back(scope);
+}
+
+void FrameProfiler::begin(const std::type_info &type)
+{
+	begin(p->typeName(type));
+}
+
+void FrameProfiler::end()
+{
+	if (p->stack.empty())
+		return;
+
+	const uint64_t now = SDL_GetPerformanceCounter();
+	const FrameProfilerPrivate::Scope scope = p->stack.back();
+	p->stack.pop_back();
+
+	const uint64_t dur = now - scope.start;
+	const uint64_t startUs = p->timestampUs(scope.start);
+
+	p->writeComplete(scope.name, "cpu", TID_CPU, startUs, p->ticksToUs(dur));
+
+	if (scope.phase != NoPhase)
+	{
+		p->phaseTicks[scope.phase] += dur - std::min(dur, scope.childPhaseTicks);
+
+		for (size_t i = p->stack.size(); i-- > 0;)
+		{
+			if (p->stack[i].phase != NoPhase)
+			{
+				p->stack[i].childPhaseTicks += dur;
+				break;
+			}
+		}
+	}
+
+	if (scope.gpuBegin)
+	{
+		FrameProfilerPrivate::GpuPass pass;
+		pass.name = scope.name;
+		pass.cpuStartUs = startUs;
+		pass.begin = scope.gpuBegin;
+		pass.end = p->genQuery();
+		pass.frame = p->frame;
+
+		gl.QueryCounter(pass.end, GL_TIMESTAMP);
+		p->gpuPending.push_back(pass);
+	}
+}
+
+void FrameProfiler::scriptDone()
+{
+	const uint64_t now = SDL_GetPerformanceCounter();
+	const uint64_t dur = now - p->scriptStart;
+
+	p->writeComplete(phaseNames[Script], "cpu", TID_CPU,
+	                 p->timestampUs(p->scriptStart), p->ticksToUs(dur));
+	p->phaseTicks[Script] += dur;
+
+	p->scriptStart = now;
+}
+
+void FrameProfiler::endFrame()
+{
+	const uint64_t now = SDL_GetPerformanceCounter();
+
+	/* Scopes left open were cut short (eg. by a reset) */
+	p->stack.clear();
+
+	FrameSample &s = p->history[p->frame % HISTORY_FRAMES];
+
+	for (int i = 0; i < PhaseCount; ++i)
+		s.phaseMs[i] = p->ticksToMs(p->phaseTicks[i]);
+
+	s.totalMs = p->ticksToMs(now - p->frameStart);
+
+	p->writeComplete("frame", "frame", TID_CPU, p->timestampUs(p->frameStart),
+	                 p->ticksToUs(now - p->frameStart));
+	p->writeCounters(p->timestampUs(now), GLState::frameStats());
+
+	memset(p->phaseTicks, 0, sizeof(p->phaseTicks));
+	p->frameStart = now;
+	p->scriptStart = now;
+
+	++p->frame;
+	p->history[p->frame % HISTORY_FRAMES].clear();
+
+	if (p->gpuTimers)
+		p->resolveGpuPasses();
+}
+
+void FrameProfiler::drawOverlay(const Vec2i &winSize, double budgetMs)
+{
+	if (!p->overlay)
+		return;
+
+	if (!p->overlayQuads)
+		p->overlayQuads = new ColorQuadArray;
+
+	p->buildOverlay(budgetMs);
+	p->overlayQuads->commit();
+
+	glState.viewport.pushSet(IntRect(0, 0, winSize.x, winSize.y));
+	glState.scissorTest.pushSet(false);
+	glState.blend.pushSet(true);
+	glState.blendMode.pushSet(BlendNormal);
+
+	SimpleColorShader &shader = shState->shaders().simpleColor;
+	shader.bind();
+	shader.applyViewportProj();
+	shader.setTranslation(Vec2i());
+
+	p->overlayQuads->draw();
+
+	glState.blendMode.pop();
+	glState.blend.pop();
+	glState.scissorTest.pop();
+	glState.viewport.pop();
+}
@@ -26,6 +26,9 @@
 #include "sharedstate.h"
 #include "config.h"
 #include "glstate.h"
+#include "frameprofiler.h"
+#include "vertex-stream.h"
+#include "presentthread.h"
 #include "shader.h"
 #include "scene.h"
 #include "quad.h"
@@ -48,7 +51,11 @@
 #include <sys/time.h>
 #endif
 #include <errno.h>
+#include <stdio.h>
 #include <algorithm>
+#include <vector>
+#include <thread>
+#include <math.h>
 
 #define DEF_SCREEN_W  (rgssVer == 1 ? 640 : 544)
 #define DEF_SCREEN_H  (rgssVer == 1 ? 480 : 416)
@@ -157,7 +164,14 @@ public:
 		const int w = geometry.rect.w;
 		const int h = geometry.rect.h;
 
-		shState->prepareDraw();
+		FrameProfiler &prof = shState->profiler();
+
+		{
+			ProfileScope scope(prof, "prepareDraw", FrameProfiler::PrepareDraw);
+			shState->prepareDraw();
+		}
+
+		ProfileScope scope(prof, "composite", FrameProfiler::Composite, true);
 
 		pp.startRender();
 
@@ -180,6 +194,8 @@ public:
 
 	void requestViewportRender(const Vec4 &c, const Vec4 &f, const Vec4 &t, const bool s, const Vec4 rx, const Vec4 ry, const Vec2 z, const float cubic, const float water, const float binary)
 	{
+		ProfileScope scope(shState->profiler(), "postEffects", FrameProfiler::PostEffects, true);
+
 		const IntRect &viewpRect = glState.scissorBox.get();
 		const IntRect &screenRect = geometry.rect;
 
@@ -312,6 +328,9 @@ public:
 			shader.setiTime(water);
 			shader.applyViewportProj();
 			shader.setTexSize(screenRect.size());
+			/* Plane water draws leave a src_rect behind;
+			 * the screen effect must not wrap its coords */
+			shader.setSrcRect(Vec4());
 
 			TEX::bind(pp.backBuffer().tex);
 
@@ -524,6 +543,55 @@ private:
 /* Nanoseconds per second */
 #define NS_PER_S 1000000000
 
+/* Rolling window of recent frame times */
+struct FrameTimes
+{
+	/* Frames kept for the percentiles */
+	enum { Window = 600 };
+
+	std::vector<uint32_t> times;
+	size_t next;
+
+	/* For percentile queries */
+	mutable std::vector<uint32_t> scratch;
+
+	FrameTimes()
+	    : next(0)
+	{
+		times.reserve(Window);
+	}
+
+	void push(uint32_t us)
+	{
+		if (times.size() < Window)
+			times.push_back(us);
+		else
+			times[next] = us;
+
+		next = (next + 1) % Window;
+	}
+
+	/* In milliseconds. Zero until the first frame */
+	void percentiles(double &p50, double &p99, double &max) const
+	{
+		p50 = p99 = max = 0;
+
+		if (times.empty())
+			return;
+
+		scratch = times;
+		const size_t n = scratch.size();
+
+		std::nth_element(scratch.begin(), scratch.begin() + (n-1) / 2, scratch.end());
+		p50 = scratch[(n-1) / 2] / 1000.0;
+
+		std::nth_element(scratch.begin(), scratch.begin() + (n-1) * 99 / 100, scratch.end());
+		p99 = scratch[(n-1) * 99 / 100] / 1000.0;
+
+		max = *std::max_element(scratch.begin(), scratch.end()) / 1000.0;
+	}
+};
+
 struct FPSLimiter
 {
 	uint64_t lastTickCount;
@@ -554,6 +622,27 @@ struct FPSLimiter
 		bool resetFlag;
 	} adj;
 
+	/* Hybrid pacing: sleep until shortly before the deadline,
+	 * then yield / spin through the rest */
+	struct
+	{
+		bool enabled;
+
+		/* Never spin for less than this */
+		int64_t minSpin;
+
+		/* Recent worst case of sleeping longer than asked */
+		int64_t overshoot;
+
+		/* Snap the frame period to the display refresh */
+		bool alignRefresh;
+		int refreshRate;
+	} pacing;
+
+	uint16_t desiredFPS;
+
+	FrameTimes frameTimes;
+
 	FPSLimiter(uint16_t desiredFPS)
 	    : lastTickCount(SDL_GetPerformanceCounter()),
 	      tickFreq(SDL_GetPerformanceFrequency()),
@@ -561,6 +650,12 @@ struct FPSLimiter
 	      tickFreqNS((double) tickFreq / NS_PER_S),
 	      disabled(false)
 	{
+		pacing.enabled = false;
+		pacing.minSpin = 0;
+		pacing.overshoot = 0;
+		pacing.alignRefresh = false;
+		pacing.refreshRate = 0;
+
 		setDesiredFPS(desiredFPS);
 
 		adj.last = SDL_GetPerformanceCounter();
@@ -568,15 +663,42 @@ struct FPSLimiter
 		adj.resetFlag = false;
 	}
 
+	void setPacing(const Config &conf, int refreshRate)
+	{
+		pacing.enabled = conf.framePacing;
+		pacing.minSpin = (int64_t) std::max(conf.framePacingSpin, 0) * tickFreq / 1000000;
+		pacing.overshoot = pacing.minSpin;
+		pacing.alignRefresh = conf.framePacing && conf.framePacingAlignRefresh;
+		pacing.refreshRate = refreshRate;
+
+		setDesiredFPS(desiredFPS);
+	}
+
 	void setDesiredFPS(uint16_t value)
 	{
+		desiredFPS = value;
 		tpf = tickFreq / value;
+
+		if (!pacing.alignRefresh || pacing.refreshRate <= 0)
+			return;
+
+		/* If the frame rate is (close to) a whole fraction of
+		 * the refresh rate, run at exactly that fraction so
+		 * frames don't slowly drift across vblanks */
+		const double ratio = (double) pacing.refreshRate / value;
+		const int intervals = (int) (ratio + 0.5);
+
+		if (intervals >= 1 && fabs(ratio - intervals) < 0.02 * intervals)
+			tpf = tickFreq * intervals / pacing.refreshRate;
 	}
 
 	void delay()
 	{
 		if (disabled)
+		{
+			recordFrame(SDL_GetPerformanceCounter());
 			return;
+		}
 
 		int64_t tickDelta = SDL_GetPerformanceCounter() - lastTickCount;
 		int64_t toDelay = tpf - tickDelta;
@@ -588,11 +710,13 @@ struct FPSLimiter
 		if (toDelay < 0)
 			toDelay = 0;
 
-		delayTicks(toDelay);
+		if (pacing.enabled)
+			delayPrecise(toDelay);
+		else
+			delayTicks(toDelay);
 
 		uint64_t now = lastTickCount = SDL_GetPerformanceCounter();
-		int64_t diff = now - adj.last;
-		adj.last = now;
+		int64_t diff = recordFrame(now);
 
 		/* Recalculate our temporal position
 		 * relative to the ideal timestep */
@@ -623,6 +747,54 @@ struct FPSLimiter
 	}
 
 private:
+	/* Returns ticks since the previous frame */
+	int64_t recordFrame(uint64_t now)
+	{
+		int64_t diff = now - adj.last;
+		adj.last = now;
+
+		frameTimes.push(std::min<uint64_t>(diff * 1000000 / tickFreq, UINT32_MAX));
+
+		return diff;
+	}
+
+	void delayPrecise(int64_t ticks)
+	{
+		const uint64_t start = SDL_GetPerformanceCounter();
+		const uint64_t deadline = start + ticks;
+		const int64_t sleepFor = ticks - pacing.overshoot;
+
+		if (sleepFor > 0)
+		{
+			delayTicks(sleepFor);
+
+			/* Track how late the scheduler woke us up; rise
+			 * immediately, decay slowly back down */
+			int64_t late = (int64_t) (SDL_GetPerformanceCounter() - start) - sleepFor;
+			int64_t want = std::max(late + late / 4, pacing.minSpin);
+
+			if (want > pacing.overshoot)
+				pacing.overshoot = want;
+			else
+				pacing.overshoot -= (pacing.overshoot - want) / 16;
+		}
+
+		/* Yield while there's time for another thread to run,
+		 * busy wait for the final stretch */
+		const int64_t spinOnly = tickFreq / 20000;
+
+		while (true)
+		{
+			int64_t left = (int64_t) (deadline - SDL_GetPerformanceCounter());
+
+			if (left <= 0)
+				break;
+
+			if (left > spinOnly)
+				std::this_thread::yield();
+		}
+	}
+
 	void delayTicks(uint64_t ticks)
 	{
 #if defined(HAVE_NANOSLEEP)
@@ -690,6 +862,13 @@ struct GraphicsPrivate
 
 	TEX::ID obscuredTex;
 
+	/* Headless mode outputs */
+	FILE *frameHashes;
+	std::vector<uint8_t> framePixels;
+
+	/* Null unless presenting is pipelined */
+	PresentThread *presenter;
+
 	GraphicsPrivate(RGSSThreadData *rtData)
 	    : scRes(DEF_SCREEN_W, DEF_SCREEN_H),
 	      scSize(scRes),
@@ -701,7 +880,9 @@ struct GraphicsPrivate
 	      frameCount(0),
 	      brightness(255),
 	      fpsLimiter(frameRate),
-	      frozen(false)
+	      frozen(false),
+	      frameHashes(0),
+	      presenter(0)
 	{
 		recalculateScreenSize(rtData);
 		updateScreenResoRatio(rtData);
@@ -720,11 +901,29 @@ struct GraphicsPrivate
 		TEX::setRepeat(false);
 		TEX::setSmooth(false);
 		gl.TexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE8, 640, 480, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, 0);
+
+		const Config &conf = rtData->config;
+
+		if (conf.headless && !conf.headlessFrameHashes.empty())
+		{
+			frameHashes = fopen(conf.headlessFrameHashes.c_str(), "w");
+
+			if (!frameHashes)
+				Debug() << "Cannot open" << conf.headlessFrameHashes << "for writing";
+		}
+
+		if (conf.pipelinedPresent && !conf.headless)
+			presenter = PresentThread::create(rtData->window);
 	}
 
 	~GraphicsPrivate()
 	{
+		delete presenter;
+
 		TEXFBO::fini(frozenScene);
+
+		if (frameHashes)
+			fclose(frameHashes);
 	}
 
 	void updateScreenResoRatio(RGSSThreadData *rtData)
@@ -789,12 +988,53 @@ struct GraphicsPrivate
 
 	void swapGLBuffer()
 	{
-		fpsLimiter.delay();
-		FBO::unbind();
-		SDL_GL_SwapWindow(threadData->window);
+		FrameProfiler &prof = shState->profiler();
+
+		{
+			ProfileScope scope(prof, "limiterSleep", FrameProfiler::LimiterSleep);
+			fpsLimiter.delay();
+		}
+
+		if (presenter)
+		{
+			/* The overlay goes into the queued frame instead,
+			 * at game resolution */
+			if (prof.enabled())
+				prof.drawOverlay(scRes, 1000.0 / frameRate);
+
+			FBO::unbind();
+			queuePresent();
+		}
+		else
+		{
+			FBO::unbind();
+
+			if (prof.enabled())
+				prof.drawOverlay(winSize, 1000.0 / frameRate);
+
+			if (!threadData->config.headless)
+			{
+				ProfileScope scope(prof, "swap", FrameProfiler::Swap);
+				SDL_GL_SwapWindow(threadData->window);
+			}
+		}
+
+		GLState::endFrame();
+		shState->vertexStream().endFrame();
+
+		if (prof.enabled())
+			prof.endFrame();
 
 		++frameCount;
 
+		if (threadData->config.framePacing && frameCount % FrameTimes::Window == 0)
+		{
+			double p50, p99, max;
+			fpsLimiter.frameTimes.percentiles(p50, p99, max);
+
+			Debug() << "Frame times (ms): p50" << p50 << "p99" << p99 << "max" << max;
+		}
+
 		threadData->ethread->notifyFrame();
 	}
 
@@ -808,6 +1048,48 @@ struct GraphicsPrivate
 		GLMeta::blitEnd();
 	}
 
+	/* Shows 'frame' (at game resolution) on the next swap */
+	void presentFrame(TEXFBO &frame)
+	{
+		if (threadData->config.headless)
+		{
+			captureFrame(frame);
+			return;
+		}
+
+		if (presenter)
+		{
+			/* Leaves the slot bound for the overlay */
+			TEXFBO &slot = presenter->acquire(scRes);
+
+			GLMeta::blitBegin(slot);
+			GLMeta::blitSource(frame);
+			GLMeta::blitRectangle(IntRect(0, 0, scRes.x, scRes.y), Vec2i());
+			GLMeta::blitEnd();
+
+			FBO::bind(slot.fbo);
+
+			return;
+		}
+
+		ProfileScope scope(shState->profiler(), "present", FrameProfiler::NoPhase, true);
+
+		GLMeta::blitBeginScreen(winSize);
+		GLMeta::blitSource(frame);
+
+		FBO::clear();
+		metaBlitBufferFlippedScaled();
+
+		GLMeta::blitEnd();
+	}
+
+	void queuePresent()
+	{
+		presenter->queue(IntRect(0, 0, scRes.x, scRes.y),
+		                 IntRect(scOffset.x, scSize.y+scOffset.y, scSize.x, -scSize.y),
+		                 threadData->config.smoothScaling);
+	}
+
 	void metaBlitBufferFlippedScaled()
 	{
 		GLMeta::blitRectangle(IntRect(0, 0, scRes.x, scRes.y),
@@ -815,23 +1097,80 @@ struct GraphicsPrivate
 		                      threadData->config.smoothScaling);
 	}
 
+	/* Headless replacement for presenting 'frame':
+	 * hands it to the configured outputs instead */
+	void captureFrame(TEXFBO &frame)
+	{
+		const Config &conf = threadData->config;
+
+		if (frameHashes || !conf.headlessFrameDump.empty())
+		{
+			framePixels.resize(scRes.x * scRes.y * 4);
+
+			FBO::bind(frame.fbo);
+			gl.ReadPixels(0, 0, scRes.x, scRes.y, GL_RGBA, GL_UNSIGNED_BYTE, &framePixels[0]);
+
+			if (frameHashes)
+				writeFrameHash();
+
+			if (!conf.headlessFrameDump.empty())
+				dumpFramePNG(conf.headlessFrameDump);
+		}
+
+		if (conf.headlessFrameLimit > 0 && frameCount + 1 == conf.headlessFrameLimit)
+			threadData->ethread->requestTerminate();
+	}
+
+	void writeFrameHash()
+	{
+		/* FNV-1a */
+		uint64_t hash = 0xCBF29CE484222325ULL;
+
+		for (size_t i = 0; i < framePixels.size(); ++i)
+		{
+			hash ^= framePixels[i];
+			hash *= 0x100000001B3ULL;
+		}
+
+		fprintf(frameHashes, "%d %016llx\n", frameCount, (unsigned long long) hash);
+		fflush(frameHashes);
+	}
+
+	void dumpFramePNG(const std::string &dir)
+	{
+		char path[512];
+		snprintf(path, sizeof(path), "%s/%06d.png", dir.c_str(), frameCount);
+
+		SDL_Surface *surf =
+			SDL_CreateRGBSurfaceWithFormatFrom(&framePixels[0], scRes.x, scRes.y, 32,
+			                                   scRes.x * 4, SDL_PIXELFORMAT_ABGR8888);
+
+		if (!surf)
+			return;
+
+		if (IMG_SavePNG(surf, path) != 0)
+			Debug() << "Cannot save frame" << path << ":" << SDL_GetError();
+
+		SDL_FreeSurface(surf);
+	}
+
 	void redrawScreen()
 	{
-		if (shState->oneshot().obscuredDirty)
+		Oneshot &oneshot = shState->oneshot();
+
+		if (oneshot.obscuredDirty)
 		{
+			/* Only the rows that changed */
+			const int top = oneshot.obscuredDirtyTop;
+			const int rows = oneshot.obscuredDirtyBottom - top;
+
 			TEX::bind(obscuredTex);
-			TEX::uploadSubImage(0, 0, 640, 480, shState->oneshot().obscuredMap().data(), GL_LUMINANCE);
-			shState->oneshot().obscuredDirty = false;
+			TEX::uploadSubImage(0, top, 640, rows, &oneshot.obscuredMap()[top * 640], GL_LUMINANCE);
+			oneshot.obscuredDirty = false;
 		}
 		screen.composite();
 
-		GLMeta::blitBeginScreen(winSize);
-		GLMeta::blitSource(screen.getPP().frontBuffer());
-
-		FBO::clear();
-		metaBlitBufferFlippedScaled();
-
-		GLMeta::blitEnd();
+		presentFrame(screen.getPP().frontBuffer());
 
 		swapGLBuffer();
 	}
@@ -846,7 +1185,8 @@ struct GraphicsPrivate
 		 * when the app moves into the background on Android */
 		SDL_GL_MakeCurrent(threadData->window, 0);
 		threadData->syncPoint.waitMainSync();
-		SDL_GL_MakeCurrent(threadData->window, glCtx);
+		SDL_GL_MakeCurrent(presenter ? presenter->mainSurface()
+		                             : threadData->window, glCtx);
 
 		fpsLimiter.resetFrameAdjust();
 	}
@@ -856,6 +1196,8 @@ Graphics::Graphics(RGSSThreadData *data)
 {
 	p = new GraphicsPrivate(data);
 
+	p->fpsLimiter.setPacing(data->config, data->refreshRate);
+
 	if (data->config.syncToRefreshrate)
 	{
 		p->frameRate = data->refreshRate;
@@ -869,6 +1211,13 @@ Graphics::Graphics(RGSSThreadData *data)
 	{
 		p->fpsLimiter.disabled = true;
 	}
+
+	/* Headless runs render every frame as fast as possible */
+	if (data->config.headless)
+		p->fpsLimiter.disabled = true;
+
+	if (data->config.inputReplayUncapped && !data->config.inputReplay.empty())
+		p->fpsLimiter.disabled = true;
 }
 
 Graphics::~Graphics()
@@ -878,6 +1227,9 @@ Graphics::~Graphics()
 
 void Graphics::update(bool limitFps)
 {
+	if (shState->profiler().enabled())
+		shState->profiler().scriptDone();
+
 	p->checkShutDownReset();
 	p->checkSyncLock();
 
@@ -1030,13 +1382,7 @@ void Graphics::transition(int duration,
 		p->checkResize();
 
 		/* Then blit it flipped and scaled to the screen */
-		FBO::unbind();
-		FBO::clear();
-
-		GLMeta::blitBeginScreen(Vec2i(p->winSize));
-		GLMeta::blitSource(transBuffer);
-		p->metaBlitBufferFlippedScaled();
-		GLMeta::blitEnd();
+		p->presentFrame(transBuffer);
 
 		p->swapGLBuffer();
 	}
@@ -1046,6 +1392,10 @@ void Graphics::transition(int duration,
 	delete transMap;
 
 	p->frozen = false;
+
+	/* Programs first linked during the last scene are
+	 * persisted here, while nothing is being animated */
+	Shader::flushBinaryCache();
 }
 
 void Graphics::frameReset()
@@ -1094,14 +1444,7 @@ void Graphics::fadeout(int duration)
 
 		if (p->frozen)
 		{
-			GLMeta::blitBeginScreen(p->scSize);
-			GLMeta::blitSource(p->frozenScene);
-
-			FBO::clear();
-			p->metaBlitBufferFlippedScaled();
-
-			GLMeta::blitEnd();
-
+			p->presentFrame(p->frozenScene);
 			p->swapGLBuffer();
 		}
 		else
@@ -1124,14 +1467,7 @@ void Graphics::fadein(int duration)
 
 		if (p->frozen)
 		{
-			GLMeta::blitBeginScreen(p->scSize);
-			GLMeta::blitSource(p->frozenScene);
-
-			FBO::clear();
-			p->metaBlitBufferFlippedScaled();
-
-			GLMeta::blitEnd();
-
+			p->presentFrame(p->frozenScene);
 			p->swapGLBuffer();
 		}
 		else
@@ -1278,8 +1614,12 @@ void Graphics::repaintWait(const AtomicFlag &exitCond, bool checkReset)
 
 	/* Repaint the screen with the last good frame we drew */
 	TEXFBO &lastFrame = p->screen.getPP().frontBuffer();
-	GLMeta::blitBeginScreen(p->winSize);
-	GLMeta::blitSource(lastFrame);
+
+	if (!p->presenter)
+	{
+		GLMeta::blitBeginScreen(p->winSize);
+		GLMeta::blitSource(lastFrame);
+	}
 
 	while (!exitCond)
 	{
@@ -1288,15 +1628,25 @@ void Graphics::repaintWait(const AtomicFlag &exitCond, bool checkReset)
 		if (checkReset)
 			shState->checkReset();
 
-		FBO::clear();
-		p->metaBlitBufferFlippedScaled();
-		SDL_GL_SwapWindow(p->threadData->window);
+		if (p->presenter)
+		{
+			p->presentFrame(lastFrame);
+			p->queuePresent();
+		}
+		else
+		{
+			FBO::clear();
+			p->metaBlitBufferFlippedScaled();
+			SDL_GL_SwapWindow(p->threadData->window);
+		}
+
 		p->fpsLimiter.delay();
 
 		p->threadData->ethread->notifyFrame();
 	}
 
-	GLMeta::blitEnd();
+	if (!p->presenter)
+		GLMeta::blitEnd();
 }
 
 void Graphics::addDisposable(Disposable *d)
@@ -1309,6 +1659,11 @@ void Graphics::remDisposable(Disposable *d)
 	p->dispList.remove(d->link);
 }
 
+void Graphics::frameTimeStats(double &p50, double &p99, double &max) const
+{
+	p->fpsLimiter.frameTimes.percentiles(p50, p99, max);
+}
+
 const TEX::ID &Graphics::obscuredTex() const
 {
 	return p->obscuredTex;
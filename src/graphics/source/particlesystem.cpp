@@ -0,0 +1,575 @@
+/*
+** particlesystem.cpp
+**
+** This file is part of mkxp.
+**
+** Copyright (C) 2013 Jonas Kulla <Nyocurio@gmail.com>
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "particlesystem.h"
+
+#include "sharedstate.h"
+#include "bitmap.h"
+#include "etc.h"
+#include "etc-internal.h"
+#include "util.h"
+
+#include "gl-util.h"
+#include "quad.h"
+#include "quadarray.h"
+#include "shader.h"
+#include "glstate.h"
+
+#include <sigc++/connection.h>
+
+#include <vector>
+#include <math.h>
+#include <stdint.h>
+
+/* Keeps all indices addressable by the 16 bit global IBO */
+#define PARTICLES_MAX 10000
+
+static inline float lerp(float a, float b, float t)
+{
+	return a + (b - a) * t;
+}
+
+struct ParticleSystemPrivate
+{
+	Bitmap *bitmap;
+
+	NormValue opacity;
+	BlendType blendType;
+	Color *color;
+	Tone *tone;
+
+	/* Particle state, stored as one array per component
+	 * so the per-frame loops stay tight and vectorizable */
+	std::vector<float> posX, posY;
+	std::vector<float> velX, velY;
+	std::vector<float> age, life;
+	std::vector<float> scale;
+	std::vector<float> phase, period;
+	size_t count;
+	size_t capacity;
+
+	/* Emitter */
+	float emitRate;
+	float emitAccum;
+	IntRect emitArea;
+	float velMinX, velMaxX, velMinY, velMaxY;
+	bool randomSign;
+	float accelX, accelY;
+	int lifeMin, lifeMax;
+	float scaleMin, scaleMax;
+	int waveMin, waveMax;
+
+	/* Curves, evaluated over normalized lifetime */
+	float scaleStart, scaleEnd;
+	float opacityStart, opacityEnd;
+
+	bool wrap;
+	int wrapW, wrapH;
+
+	uint32_t rngState;
+
+	Vec2i sceneOffset;
+
+	ColorQuadArray qArray;
+	bool quadsDirty;
+
+	EtcTemps tmp;
+
+	sigc::connection prepareCon;
+
+	ParticleSystemPrivate()
+	    : bitmap(0),
+	      opacity(255),
+	      blendType(BlendNormal),
+	      color(&tmp.color),
+	      tone(&tmp.tone),
+	      count(0),
+	      capacity(0),
+	      emitRate(0),
+	      emitAccum(0),
+	      emitArea(0, 0, 640, 480),
+	      velMinX(0), velMaxX(0),
+	      velMinY(0), velMaxY(0),
+	      randomSign(false),
+	      accelX(0), accelY(0),
+	      lifeMin(0), lifeMax(0),
+	      scaleMin(1), scaleMax(1),
+	      waveMin(0), waveMax(0),
+	      scaleStart(1), scaleEnd(1),
+	      opacityStart(1), opacityEnd(1),
+	      wrap(true),
+	      wrapW(640), wrapH(480),
+	      rngState(0x9E3779B9),
+	      quadsDirty(false)
+	{
+		prepareCon = shState->prepareDraw.connect
+		        (sigc::mem_fun(this, &ParticleSystemPrivate::prepare));
+
+		setCapacity(1024);
+	}
+
+	~ParticleSystemPrivate()
+	{
+		prepareCon.disconnect();
+	}
+
+	/* xorshift32; returns [0, 1) */
+	float random()
+	{
+		rngState ^= rngState << 13;
+		rngState ^= rngState >> 17;
+		rngState ^= rngState << 5;
+
+		return (rngState >> 8) * (1.0f / 16777216.0f);
+	}
+
+	float randomRange(float min, float max)
+	{
+		return lerp(min, max, random());
+	}
+
+	void setCapacity(size_t value)
+	{
+		posX.resize(value);
+		posY.resize(value);
+		velX.resize(value);
+		velY.resize(value);
+		age.resize(value);
+		life.resize(value);
+		scale.resize(value);
+		phase.resize(value);
+		period.resize(value);
+
+		capacity = value;
+
+		if (count > capacity)
+			count = capacity;
+
+		quadsDirty = true;
+	}
+
+	void spawn(int n)
+	{
+		for (int k = 0; k < n && count < capacity; ++k)
+		{
+			const size_t i = count++;
+
+			posX[i] = emitArea.x + random() * emitArea.w;
+			posY[i] = emitArea.y + random() * emitArea.h;
+
+			float vx = randomRange(velMinX, velMaxX);
+			float vy = randomRange(velMinY, velMaxY);
+
+			if (randomSign)
+			{
+				if (random() < 0.5f)
+					vx = -vx;
+				if (random() < 0.5f)
+					vy = -vy;
+			}
+
+			velX[i] = vx;
+			velY[i] = vy;
+
+			age[i] = 0;
+			/* A lifetime of 0 means the particle never expires */
+			life[i] = floorf(randomRange(lifeMin, lifeMax + 1));
+			if (lifeMax <= 0)
+				life[i] = 0;
+
+			scale[i] = randomRange(scaleMin, scaleMax);
+
+			period[i] = waveMax > 0 ? floorf(randomRange(waveMin, waveMax + 1)) : 0;
+			phase[i] = random() * period[i];
+		}
+
+		quadsDirty = true;
+	}
+
+	void removeAt(size_t i)
+	{
+		const size_t last = --count;
+
+		posX[i]   = posX[last];
+		posY[i]   = posY[last];
+		velX[i]   = velX[last];
+		velY[i]   = velY[last];
+		age[i]    = age[last];
+		life[i]   = life[last];
+		scale[i]  = scale[last];
+		phase[i]  = phase[last];
+		period[i] = period[last];
+	}
+
+	float curveT(size_t i) const
+	{
+		return life[i] > 0 ? age[i] / life[i] : 0;
+	}
+
+	void step()
+	{
+		if (emitRate > 0)
+		{
+			emitAccum += emitRate;
+			int n = (int) emitAccum;
+			emitAccum -= n;
+
+			spawn(n);
+		}
+
+		const size_t n = count;
+		float *px = dataPtr(posX), *py = dataPtr(posY);
+		float *vx = dataPtr(velX), *vy = dataPtr(velY);
+		float *ag = dataPtr(age);
+
+		for (size_t i = 0; i < n; ++i)
+		{
+			vx[i] += accelX;
+			vy[i] += accelY;
+			px[i] += vx[i];
+			py[i] += vy[i];
+			ag[i] += 1;
+		}
+
+		for (size_t i = 0; i < count;)
+		{
+			if (life[i] > 0 && age[i] >= life[i])
+				removeAt(i);
+			else
+				++i;
+		}
+
+		if (wrap && !nullOrDisposed(bitmap))
+			wrapAround();
+
+		quadsDirty = true;
+	}
+
+	/* Particles leaving the wrap area by more than their
+	 * own size reappear on the opposite side */
+	void wrapAround()
+	{
+		const float bw = bitmap->width();
+		const float bh = bitmap->height();
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const float s = scale[i] * lerp(scaleStart, scaleEnd, curveT(i));
+			const float mw = bw * s;
+			const float mh = bh * s;
+
+			if (posX[i] < -mw)
+				posX[i] = wrapW + mw;
+			else if (posX[i] > wrapW + mw)
+				posX[i] = -mw;
+
+			if (posY[i] < -mh)
+				posY[i] = wrapH + mh;
+			else if (posY[i] > wrapH + mh)
+				posY[i] = -mh;
+		}
+	}
+
+	void rebuildQuads()
+	{
+		qArray.resize(count);
+
+		if (count == 0 || nullOrDisposed(bitmap))
+			return;
+
+		const float bw = bitmap->width();
+		const float bh = bitmap->height();
+		const FloatRect tex(0, 0, bw, bh);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const float t = curveT(i);
+			const float s = scale[i] * lerp(scaleStart, scaleEnd, t);
+			float alpha = lerp(opacityStart, opacityEnd, t) * opacity.norm;
+
+			if (period[i] > 0)
+				alpha *= sinf(fmodf(phase[i] + age[i], period[i]) / period[i] * (float) M_PI);
+
+			alpha = clamp(alpha, 0.0f, 1.0f);
+
+			const float w = bw * s;
+			const float h = bh * s;
+			const FloatRect pos(posX[i] - w / 2, posY[i] - h / 2, w, h);
+
+			Vertex *vert = &qArray.vertices[i*4];
+			Quad::setTexPosRect(vert, tex, pos);
+			Quad::setColor(vert, Vec4(1, 1, 1, alpha));
+		}
+
+		qArray.commit();
+	}
+
+	void prepare()
+	{
+		if (quadsDirty)
+		{
+			rebuildQuads();
+			quadsDirty = false;
+		}
+	}
+};
+
+ParticleSystem::ParticleSystem(Viewport *viewport)
+    : ViewportElement(viewport)
+{
+	p = new ParticleSystemPrivate();
+
+	onGeometryChange(scene->getGeometry());
+}
+
+ParticleSystem::~ParticleSystem()
+{
+	dispose();
+}
+
+DEF_ATTR_RD_SIMPLE(ParticleSystem, Bitmap,       Bitmap*, p->bitmap)
+DEF_ATTR_RD_SIMPLE(ParticleSystem, Opacity,      int,     p->opacity)
+DEF_ATTR_RD_SIMPLE(ParticleSystem, BlendType,    int,     p->blendType)
+DEF_ATTR_RD_SIMPLE(ParticleSystem, MaxParticles, int,     (int) p->capacity)
+
+DEF_ATTR_SIMPLE(ParticleSystem, EmitRate,   float, p->emitRate)
+DEF_ATTR_SIMPLE(ParticleSystem, RandomSign, bool,  p->randomSign)
+DEF_ATTR_SIMPLE(ParticleSystem, AccelX,     float, p->accelX)
+DEF_ATTR_SIMPLE(ParticleSystem, AccelY,     float, p->accelY)
+DEF_ATTR_SIMPLE(ParticleSystem, Wrap,       bool,  p->wrap)
+DEF_ATTR_SIMPLE(ParticleSystem, WrapWidth,  int,   p->wrapW)
+DEF_ATTR_SIMPLE(ParticleSystem, WrapHeight, int,   p->wrapH)
+DEF_ATTR_SIMPLE(ParticleSystem, Color,      Color&, *p->color)
+DEF_ATTR_SIMPLE(ParticleSystem, Tone,       Tone&,  *p->tone)
+
+int ParticleSystem::getCount() const
+{
+	guardDisposed();
+
+	return p->count;
+}
+
+void ParticleSystem::update()
+{
+	guardDisposed();
+
+	p->step();
+}
+
+void ParticleSystem::emit(int count)
+{
+	guardDisposed();
+
+	if (count > 0)
+		p->spawn(count);
+}
+
+void ParticleSystem::shift(float dx, float dy)
+{
+	guardDisposed();
+
+	for (size_t i = 0; i < p->count; ++i)
+	{
+		p->posX[i] += dx;
+		p->posY[i] += dy;
+	}
+
+	p->quadsDirty = true;
+}
+
+void ParticleSystem::clear()
+{
+	guardDisposed();
+
+	p->count = 0;
+	p->emitAccum = 0;
+	p->quadsDirty = true;
+}
+
+void ParticleSystem::setEmitArea(int x, int y, int width, int height)
+{
+	guardDisposed();
+
+	p->emitArea = IntRect(x, y, width, height);
+}
+
+void ParticleSystem::setVelocity(float minX, float maxX, float minY, float maxY)
+{
+	guardDisposed();
+
+	p->velMinX = minX;
+	p->velMaxX = maxX;
+	p->velMinY = minY;
+	p->velMaxY = maxY;
+}
+
+void ParticleSystem::setLifetime(int minFrames, int maxFrames)
+{
+	guardDisposed();
+
+	p->lifeMin = std::max(minFrames, 0);
+	p->lifeMax = std::max(maxFrames, p->lifeMin);
+}
+
+void ParticleSystem::setScale(float min, float max)
+{
+	guardDisposed();
+
+	p->scaleMin = min;
+	p->scaleMax = max;
+}
+
+void ParticleSystem::setScaleCurve(float start, float end)
+{
+	guardDisposed();
+
+	p->scaleStart = start;
+	p->scaleEnd = end;
+	p->quadsDirty = true;
+}
+
+void ParticleSystem::setOpacityCurve(float start, float end)
+{
+	guardDisposed();
+
+	p->opacityStart = start;
+	p->opacityEnd = end;
+	p->quadsDirty = true;
+}
+
+void ParticleSystem::setWave(int minPeriod, int maxPeriod)
+{
+	guardDisposed();
+
+	p->waveMin = std::max(minPeriod, 0);
+	p->waveMax = std::max(maxPeriod, p->waveMin);
+}
+
+void ParticleSystem::setBitmap(Bitmap *value)
+{
+	guardDisposed();
+
+	p->bitmap = value;
+	p->quadsDirty = true;
+
+	if (!value)
+		return;
+
+	value->ensureNonMega();
+}
+
+void ParticleSystem::setOpacity(int value)
+{
+	guardDisposed();
+
+	if (p->opacity == value)
+		return;
+
+	p->opacity = value;
+	p->quadsDirty = true;
+}
+
+void ParticleSystem::setBlendType(int value)
+{
+	guardDisposed();
+
+	switch (value)
+	{
+	default :
+	case BlendNormal :
+		p->blendType = BlendNormal;
+		return;
+	case BlendAddition :
+		p->blendType = BlendAddition;
+		return;
+	case BlendSubstraction :
+		p->blendType = BlendSubstraction;
+		return;
+	}
+}
+
+void ParticleSystem::setMaxParticles(int value)
+{
+	guardDisposed();
+
+	p->setCapacity(clamp(value, 0, PARTICLES_MAX));
+}
+
+void ParticleSystem::initDynAttribs()
+{
+	p->color = new Color;
+	p->tone = new Tone;
+}
+
+/* The containing viewport's tone, color and flash are not
+ * applied here; like for sprites, Viewport::composite() runs
+ * them over everything drawn inside it once its elements
+ * are done. 'color'/'tone' below are the system's own */
+void ParticleSystem::draw()
+{
+	if (nullOrDisposed(p->bitmap))
+		return;
+
+	if (!p->opacity || p->qArray.count() == 0)
+		return;
+
+	ShaderBase *base;
+
+	if (p->color->hasEffect() || p->tone->hasEffect())
+	{
+		ParticleShader &shader = shState->shaders().particle;
+		shader.bind();
+		shader.applyViewportProj();
+		shader.setTranslation(p->sceneOffset);
+		shader.setTone(p->tone->norm);
+		shader.setColor(p->color->norm);
+
+		base = &shader;
+	}
+	else
+	{
+		SimpleAlphaShader &shader = shState->shaders().simpleAlpha;
+		shader.bind();
+		shader.applyViewportProj();
+		shader.setTranslation(p->sceneOffset);
+
+		base = &shader;
+	}
+
+	glState.blendMode.pushSet(p->blendType);
+
+	p->bitmap->bindTex(*base);
+	p->qArray.draw();
+
+	glState.blendMode.pop();
+}
+
+void ParticleSystem::onGeometryChange(const Scene::Geometry &geo)
+{
+	p->sceneOffset = geo.offset();
+}
+
+void ParticleSystem::releaseResources()
+{
+	unlink();
+
+	delete p;
+}
@@ -37,8 +37,13 @@
 
 #include <sigc++/connection.h>
 
+#include <math.h>
+
 static float fwrap(float value, float range)
 {
+	if (range <= 0)
+		return 0;
+
 	float res = fmod(value, range);
 	return res < 0 ? res + range : res;
 }
@@ -65,6 +70,9 @@ struct PlanePrivate
 
 	SimpleQuadArray qArray;
 
+	/* src_rect normalized to the bound texture */
+	Vec4 texSrcRect;
+
 	EtcTemps tmp;
 
 	sigc::connection prepareCon;
@@ -114,50 +122,29 @@ struct PlanePrivate
 		if (nullOrDisposed(bitmap))
 			return;
 
-		if (gl.npot_repeat && srcRect->toIntRect() == bitmap->rect())
-		{
-			FloatRect srcRect;
-			srcRect.x = (sceneGeo.orig.x + ox) / zoomX;
-			srcRect.y = (sceneGeo.orig.y + oy) / zoomY;
-			srcRect.w = sceneGeo.rect.w / zoomX;
-			srcRect.h = sceneGeo.rect.h / zoomY;
-
-			Quad::setTexRect(&qArray.vertices[0], srcRect);
-			qArray.commit();
-
-			return;
-		}
-
-		/* Scaled (zoomed) bitmap dimensions */
-		float sw = srcRect->width  * zoomX;
-		float sh = srcRect->height * zoomY;
-
-		/* Plane offset wrapped by scaled bitmap dims */
-		float wox = fwrap(ox, sw);
-		float woy = fwrap(oy, sh);
-
-		/* Viewport dimensions */
-		int vpw = sceneGeo.rect.w;
-		int vph = sceneGeo.rect.h;
-
-		/* Amount the scaled bitmap is tiled (repeated) */
-		size_t tilesX = ceil((vpw - sw + wox) / sw) + 1;
-		size_t tilesY = ceil((vph - sh + woy) / sh) + 1;
-
-		FloatRect tex = srcRect->toFloatRect();
-
-		qArray.resize(tilesX * tilesY);
-
-		for (size_t y = 0; y < tilesY; ++y)
-			for (size_t x = 0; x < tilesX; ++x)
-			{
-				SVertex *vert = &qArray.vertices[(y*tilesX + x) * 4];
-				FloatRect pos(x*sw - wox, y*sh - woy, sw, sh);
-
-				Quad::setTexPosRect(vert, tex, pos);
-			}
-
+		/* Mega surfaces are drawn from a texture
+		 * holding only part of them */
+		const IntRect view = bitmap->viewRect(srcRect->toIntRect());
+
+		/* A single quad spans the viewport; the plane
+		 * shaders wrap its tex coords into the src_rect.
+		 * The offset is wrapped here first so the coords
+		 * stay small enough for mediump precision */
+		FloatRect tex;
+		tex.x = srcRect->x - view.x +
+		        fwrap((sceneGeo.orig.x + ox) / zoomX, srcRect->width);
+		tex.y = srcRect->y - view.y +
+		        fwrap((sceneGeo.orig.y + oy) / zoomY, srcRect->height);
+		tex.w = sceneGeo.rect.w / zoomX;
+		tex.h = sceneGeo.rect.h / zoomY;
+
+		Quad::setTexRect(&qArray.vertices[0], tex);
 		qArray.commit();
+
+		texSrcRect = Vec4((float) (srcRect->x - view.x) / view.w,
+		                  (float) (srcRect->y - view.y) / view.h,
+		                  (float) srcRect->width  / view.w,
+		                  (float) srcRect->height / view.h);
 	}
 
 	void prepare()
@@ -167,6 +154,9 @@ struct PlanePrivate
 			updateQuadSource();
 			quadSourceDirty = false;
 		}
+
+		if (!nullOrDisposed(bitmap))
+			bitmap->prepareView(srcRect->toIntRect());
 	}
 };
 
@@ -205,8 +195,6 @@ void Plane::setBitmap(Bitmap *value)
 	if (!value)
 		return;
 
-	value->ensureNonMega();
-
 	*p->srcRect = value->rect();
 	p->onSrcRectChange();
 }
@@ -291,6 +279,10 @@ void Plane::draw()
 	if (!p->opacity)
 		return;
 
+	/* Nothing to repeat */
+	if (p->srcRect->width <= 0 || p->srcRect->height <= 0)
+		return;
+
 	ShaderBase *base;
 
 	if (p->waterTime != 0)
@@ -300,10 +292,11 @@ void Plane::draw()
 		shader.applyViewportProj();
 		shader.setiTime(p->waterTime);
 		shader.setOpacity(p->opacity.norm);
+		shader.setSrcRect(p->texSrcRect);
 
 		base = &shader;
 	}
-	else if (p->color->hasEffect() || p->tone->hasEffect() || p->opacity != 255)
+	else
 	{
 		PlaneShader &shader = shState->shaders().plane;
 
@@ -313,39 +306,23 @@ void Plane::draw()
 		shader.setColor(p->color->norm);
 		shader.setFlash(Vec4());
 		shader.setOpacity(p->opacity.norm);
-
-		base = &shader;
-	}
-	else
-	{
-		SimpleShader &shader = shState->shaders().simple;
-
-		shader.bind();
-		shader.applyViewportProj();
-		shader.setTranslation(Vec2i());
+		shader.setSrcRect(p->texSrcRect);
 
 		base = &shader;
 	}
 
 	glState.blendMode.pushSet(p->blendType);
 
-	p->bitmap->bindTex(*base);
-
-	if (gl.npot_repeat)
-		TEX::setRepeat(true);
+	p->bitmap->bindTex(*base, p->srcRect->toIntRect());
 
 	p->qArray.draw();
 
-	if (gl.npot_repeat)
-		TEX::setRepeat(false);
-
 	glState.blendMode.pop();
 }
 
 void Plane::onGeometryChange(const Scene::Geometry &geo)
 {
-	if (gl.npot_repeat)
-		Quad::setPosRect(&p->qArray.vertices[0], FloatRect(geo.rect));
+	Quad::setPosRect(&p->qArray.vertices[0], FloatRect(geo.rect));
 
 	p->sceneGeo = geo;
 	p->quadSourceDirty = true;
@@ -0,0 +1,287 @@
+/*
+** presentthread.cpp
+**
+** This file is part of mkxp.
+**
+** Copyright (C) 2013 Jonas Kulla <Nyocurio@gmail.com>
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "presentthread.h"
+
+#include "gl-fun.h"
+#include "sdl-util.h"
+#include "debugwriter.h"
+
+#include <SDL2/SDL_mutex.h>
+#include <SDL2/SDL_thread.h>
+
+/* Give up on a fence after this long (ns) rather than
+ * hang on a lost context */
+#define FENCE_TIMEOUT 1000000000ULL
+
+PresentThread *PresentThread::create(SDL_Window *window)
+{
+	if (!gl.BlitFramebuffer)
+	{
+		Debug() << "Pipelined present needs framebuffer blits; presenting inline";
+		return 0;
+	}
+
+	SDL_GLContext mainCtx = SDL_GL_GetCurrentContext();
+	int swapInterval = SDL_GL_GetSwapInterval();
+
+	/* Creating the context also makes it current */
+	SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+	SDL_GLContext ctx = SDL_GL_CreateContext(window);
+	SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+
+	/* The RGSS thread only ever renders into FBOs from here on,
+	 * so it lets go of the window surface if the platform allows
+	 * surfaceless contexts. EGL won't bind one surface in two
+	 * threads at once; GLX and WGL don't mind */
+	const bool surfaceless = ctx && SDL_GL_MakeCurrent(0, mainCtx) == 0;
+
+	if (!surfaceless)
+		SDL_GL_MakeCurrent(window, mainCtx);
+
+	if (!ctx)
+	{
+		Debug() << "Cannot create shared context for presenting:" << SDL_GetError();
+		return 0;
+	}
+
+	PresentThread *presenter =
+		new PresentThread(window, mainCtx, ctx, swapInterval, surfaceless);
+
+	if (!presenter->waitStarted())
+	{
+		Debug() << "Presenting inline instead";
+		delete presenter;
+		return 0;
+	}
+
+	return presenter;
+}
+
+PresentThread::PresentThread(SDL_Window *window, SDL_GLContext mainCtx,
+                             SDL_GLContext ctx, int swapInterval, bool surfaceless)
+    : window(window),
+      mainCtx(mainCtx),
+      ctx(ctx),
+      swapInterval(swapInterval),
+      surfaceless(surfaceless),
+      writeSlot(0),
+      readSlot(0),
+      mutex(SDL_CreateMutex()),
+      cond(SDL_CreateCond()),
+      startup(Starting),
+      quit(false)
+{
+	for (int i = 0; i < 2; ++i)
+	{
+		slots[i].state = Free;
+		slots[i].fence = 0;
+		slots[i].smooth = false;
+	}
+
+	thread = createSDLThread<PresentThread, &PresentThread::run>(this, "present");
+}
+
+PresentThread::~PresentThread()
+{
+	SDL_LockMutex(mutex);
+	quit = true;
+	SDL_CondBroadcast(cond);
+	SDL_UnlockMutex(mutex);
+
+	SDL_WaitThread(thread, 0);
+
+	for (int i = 0; i < 2; ++i)
+	{
+		if (slots[i].fence)
+			gl.DeleteSync(slots[i].fence);
+
+		if (slots[i].frame.tex != TEX::ID(0))
+			TEXFBO::fini(slots[i].frame);
+	}
+
+	SDL_GL_DeleteContext(ctx);
+
+	/* Hand the window back to the RGSS thread */
+	if (surfaceless)
+		SDL_GL_MakeCurrent(window, mainCtx);
+
+	SDL_DestroyCond(cond);
+	SDL_DestroyMutex(mutex);
+}
+
+bool PresentThread::waitStarted()
+{
+	SDL_LockMutex(mutex);
+
+	while (startup == Starting)
+		SDL_CondWait(cond, mutex);
+
+	const bool running = (startup == Running);
+
+	SDL_UnlockMutex(mutex);
+
+	return running;
+}
+
+void PresentThread::setStartup(Startup value)
+{
+	SDL_LockMutex(mutex);
+
+	startup = value;
+
+	SDL_CondBroadcast(cond);
+	SDL_UnlockMutex(mutex);
+}
+
+TEXFBO &PresentThread::acquire(const Vec2i &size)
+{
+	Slot &slot = slots[writeSlot];
+
+	SDL_LockMutex(mutex);
+
+	while (slot.state != Free && slot.state != Acquired)
+		SDL_CondWait(cond, mutex);
+
+	slot.state = Acquired;
+
+	SDL_UnlockMutex(mutex);
+
+	TEXFBO &frame = slot.frame;
+
+	if (frame.width != size.x || frame.height != size.y)
+	{
+		if (frame.tex != TEX::ID(0))
+			TEXFBO::fini(frame);
+
+		TEXFBO::init(frame);
+		TEXFBO::allocEmpty(frame, size.x, size.y);
+		TEXFBO::linkFBO(frame);
+	}
+
+	return frame;
+}
+
+void PresentThread::queue(const IntRect &src, const IntRect &dst, bool smooth)
+{
+	Slot &slot = slots[writeSlot];
+
+	if (slot.state != Acquired)
+		return;
+
+	/* The presenting context must not read the slot before
+	 * our commands writing it have executed */
+	if (gl.FenceSync)
+		slot.fence = gl.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	if (slot.fence)
+		gl.Flush();
+	else
+		gl.Finish();
+
+	slot.src = src;
+	slot.dst = dst;
+	slot.smooth = smooth;
+
+	SDL_LockMutex(mutex);
+
+	slot.state = Queued;
+	writeSlot ^= 1;
+
+	SDL_CondBroadcast(cond);
+	SDL_UnlockMutex(mutex);
+}
+
+void PresentThread::run()
+{
+	/* Fails eg. on EGL when the RGSS thread couldn't go
+	 * surfaceless and still has the window bound */
+	if (SDL_GL_MakeCurrent(window, ctx) != 0)
+	{
+		Debug() << "Cannot bind the window for presenting:" << SDL_GetError();
+		setStartup(Failed);
+		return;
+	}
+
+	SDL_GL_SetSwapInterval(swapInterval);
+	setStartup(Running);
+
+	/* FBOs aren't shared between contexts */
+	GLuint readFBO;
+	gl.GenFramebuffers(1, &readFBO);
+
+	gl.ClearColor(0, 0, 0, 1);
+
+	while (true)
+	{
+		SDL_LockMutex(mutex);
+
+		while (!quit && slots[readSlot].state != Queued)
+			SDL_CondWait(cond, mutex);
+
+		if (quit)
+		{
+			SDL_UnlockMutex(mutex);
+			break;
+		}
+
+		Slot &slot = slots[readSlot];
+		slot.state = Showing;
+
+		SDL_UnlockMutex(mutex);
+
+		if (slot.fence)
+		{
+			gl.ClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+			gl.DeleteSync(slot.fence);
+			slot.fence = 0;
+		}
+
+		/* Texture names may be reused, so always reattach */
+		gl.BindFramebuffer(GL_READ_FRAMEBUFFER, readFBO);
+		gl.FramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+		                        GL_TEXTURE_2D, slot.frame.tex.gl, 0);
+		gl.BindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+
+		gl.Clear(GL_COLOR_BUFFER_BIT);
+
+		const IntRect &s = slot.src;
+		const IntRect &d = slot.dst;
+
+		gl.BlitFramebuffer(s.x, s.y, s.x+s.w, s.y+s.h,
+		                   d.x, d.y, d.x+d.w, d.y+d.h,
+		                   GL_COLOR_BUFFER_BIT, slot.smooth ? GL_LINEAR : GL_NEAREST);
+
+		SDL_GL_SwapWindow(window);
+
+		SDL_LockMutex(mutex);
+
+		slot.state = Free;
+		readSlot ^= 1;
+
+		SDL_CondBroadcast(cond);
+		SDL_UnlockMutex(mutex);
+	}
+
+	gl.DeleteFramebuffers(1, &readFBO);
+	SDL_GL_MakeCurrent(window, 0);
+}
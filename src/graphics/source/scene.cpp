@@ -21,6 +21,7 @@
 
 #include "scene.h"
 #include "sharedstate.h"
+#include "frameprofiler.h"
 
 Scene::Scene()
 {}
@@ -90,6 +91,7 @@ void Scene::notifyGeometryChange()
 
 void Scene::composite()
 {
+	FrameProfiler &prof = shState->profiler();
 	IntruListLink<SceneElement> *iter;
 
 	for (iter = elements.begin(); iter != elements.end(); iter = iter->next)
@@ -97,7 +99,10 @@ void Scene::composite()
 		SceneElement *e = iter->data;
 
 		if (e->visible)
+		{
+			ProfileScope scope(prof, typeid(*e));
 			e->draw();
+		}
 	}
 }
 
@@ -64,9 +64,18 @@ struct SpritePrivate
 	NormValue opacity;
 	BlendType blendType;
 
+	/* Hue rotation in degrees, applied by the sprite
+	 * shader so hue variants can share one texture */
+	int hue;
+
 	IntRect sceneRect;
 	Vec2i sceneOrig;
 
+	/* Clamped srcRect, and the area of the bitmap held by
+	 * the texture it's drawn from (see Bitmap::viewRect) */
+	IntRect texSrc;
+	IntRect view;
+
 	/* Would this sprite be visible on
 	 * the screen if drawn? */
 	bool isVisible;
@@ -105,6 +114,7 @@ struct SpritePrivate
 	      bushOpacity(128),
 	      opacity(255),
 	      blendType(BlendNormal),
+	      hue(0),
 	      isVisible(false),
 	      obscured(false),
 		  scanned(false),
@@ -139,10 +149,18 @@ struct SpritePrivate
 
 		/* Calculate effective (normalized) bush depth */
 		float texBushDepth = (bushDepth / trans.getScale().y) -
-		                     (srcRect->y + srcRect->height) +
-		                     bitmap->height();
+		                     (srcRect->y + srcRect->height - view.y) +
+		                     view.h;
 
-		efBushDepth = 1.0f - texBushDepth / bitmap->height();
+		efBushDepth = 1.0f - texBushDepth / view.h;
+	}
+
+	FloatRect toView(FloatRect texrect) const
+	{
+		texrect.x -= view.x;
+		texrect.y -= view.y;
+
+		return texrect;
 	}
 
 	FloatRect getMirroredTexRect(FloatRect texrect)
@@ -169,7 +187,12 @@ struct SpritePrivate
 		rect.w = clamp<int>(rect.w, 0, bmSize.x-rect.x);
 		rect.h = clamp<int>(rect.h, 0, bmSize.y-rect.y);
 
-		quad.setTexRect(getMirroredTexRect(rect));
+		texSrc = IntRect(rect.x, rect.y, rect.w, rect.h);
+
+		if (!nullOrDisposed(bitmap))
+			view = bitmap->viewRect(texSrc);
+
+		quad.setTexRect(getMirroredTexRect(toView(rect)));
 
 		quad.setPosRect(FloatRect(0, 0, rect.w, rect.h));
 		recomputeBushDepth();
@@ -229,7 +252,7 @@ struct SpritePrivate
 		float wavePos = phase + (chunkY / (float) wave.length) * (float) (M_PI * 2);
 		float chunkX = sin(wavePos) * wave.amp;
 
-		FloatRect tex = getMirroredTexRect(srcRect->toFloatRect());
+		FloatRect tex = getMirroredTexRect(toView(srcRect->toFloatRect()));
 		// note: width is ignored, we're using the mirrored srcRect (the original width is from srcRect anyway)
 		if (tex.h < 0) { // texture itself is vflipped
 			tex.y -= chunkY / zoomY;
@@ -279,7 +302,7 @@ struct SpritePrivate
 
 			FloatRect tex(x, srcRect->y, w, srcRect->height);
 
-			Quad::setTexPosRect(&wave.qArray.vertices[0], getMirroredTexRect(tex), tex);
+			Quad::setTexPosRect(&wave.qArray.vertices[0], getMirroredTexRect(toView(tex)), tex);
 			wave.qArray.commit();
 
 			return;
@@ -323,6 +346,9 @@ struct SpritePrivate
 		}
 
 		updateVisibility();
+
+		if (isVisible)
+			bitmap->prepareView(texSrc);
 	}
 };
 
@@ -350,6 +376,7 @@ DEF_ATTR_RD_SIMPLE(Sprite, Mirror,     bool,    p->mirrored)
 DEF_ATTR_RD_SIMPLE(Sprite, VMirror,     bool,    p->vmirrored)
 DEF_ATTR_RD_SIMPLE(Sprite, BushDepth,  int,     p->bushDepth)
 DEF_ATTR_RD_SIMPLE(Sprite, BlendType,  int,     p->blendType)
+DEF_ATTR_RD_SIMPLE(Sprite, Hue,        int,     p->hue)
 DEF_ATTR_RD_SIMPLE(Sprite, Width,      int,     p->srcRect->width)
 DEF_ATTR_RD_SIMPLE(Sprite, Height,     int,     p->srcRect->height)
 DEF_ATTR_RD_SIMPLE(Sprite, WaveAmp,    int,     p->wave.amp)
@@ -377,8 +404,6 @@ void Sprite::setBitmap(Bitmap *bitmap)
 	if (nullOrDisposed(bitmap))
 		return;
 
-	bitmap->ensureNonMega();
-
 	*p->srcRect = bitmap->rect();
 	p->onSrcRectChange();
 	p->quad.setPosRect(p->srcRect->toFloatRect());
@@ -512,6 +537,13 @@ void Sprite::setBlendType(int type)
 	}
 }
 
+void Sprite::setHue(int value)
+{
+	guardDisposed();
+
+	p->hue = value;
+}
+
 #define DEF_WAVE_SETTER(Name, name, type) \
 	void Sprite::setWave##Name(type value) \
 	{ \
@@ -563,7 +595,8 @@ void Sprite::draw()
 	bool renderEffect = p->color->hasEffect() ||
 	                    p->tone->hasEffect()  ||
 	                    flashing              ||
-	                    p->bushDepth != 0;
+	                    p->bushDepth != 0     ||
+	                    (p->hue % 360) != 0;
 
 	if (p->obscured)
 	{
@@ -571,6 +604,7 @@ void Sprite::draw()
 		shader.bind();
 		shader.applyViewportProj();
 		shader.setObscured(shState->graphics().obscuredTex());
+		shader.setHueAdjust(wrapRange(p->hue, 0, 359) / 360.0f);
 		base = &shader;
 	}
 	else if (p->scanned)
@@ -579,6 +613,7 @@ void Sprite::draw()
 		shader.bind();
 		shader.applyViewportProj();
 		shader.setSpriteMat(p->trans.getMatrix());
+		shader.setHueAdjust(wrapRange(p->hue, 0, 359) / 360.0f);
 
 		base = &shader;
 	}
@@ -594,6 +629,8 @@ void Sprite::draw()
 		shader.setOpacity(p->opacity.norm);
 		shader.setBushDepth(p->efBushDepth);
 		shader.setBushOpacity(p->bushOpacity.norm);
+		/* Shader expects normalized value */
+		shader.setHueAdjust(wrapRange(p->hue, 0, 359) / 360.0f);
 
 		/* When both flashing and effective color are set,
 		 * the one with higher alpha will be blended */
@@ -626,7 +663,7 @@ void Sprite::draw()
 
 	glState.blendMode.pushSet(p->blendType);
 
-	p->bitmap->bindTex(*base);
+	p->bitmap->bindTex(*base, p->texSrc);
 
 	if (p->wave.active)
 		p->wave.qArray.draw();
@@ -30,6 +30,7 @@
 #include "glstate.h"
 #include "gl-util.h"
 #include "gl-meta.h"
+#include "megatexture.h"
 #include "global-ibo.h"
 #include "etc-internal.h"
 #include "quadarray.h"
@@ -46,8 +47,6 @@
 #include <algorithm>
 #include <vector>
 
-#include <SDL2/SDL_surface.h>
-
 #include "debugwriter.h"
 
 extern const StaticRect autotileRects[];
@@ -260,6 +259,10 @@ struct TilemapPrivate
 
 		/* Indices of animated autotiles */
 		std::vector<uint8_t> animatedATs;
+
+		/* Contents 'gl' was requested for; empty
+		 * while no atlas is held */
+		TileAtlas::Key key;
 	} atlas;
 
 	/* Map viewport position */
@@ -390,7 +393,7 @@ struct TilemapPrivate
 		for (size_t i = 0; i < zlayersMax; ++i)
 			delete elem.zlayers[i];
 
-		shState->releaseAtlasTex(atlas.gl);
+		releaseAtlas();
 
 		/* Destroy tile buffers */
 		GLMeta::vaoFini(tiles.vao);
@@ -439,13 +442,14 @@ struct TilemapPrivate
 		std::vector<uint8_t> &animatedATs = atlas.animatedATs;
 
 		usableATs.clear();
+		animatedATs.clear();
 
 		for (int i = 0; i < autotileCount; ++i)
 		{
 			if (nullOrDisposed(autotiles[i]))
 				continue;
 
-			if (autotiles[i]->megaSurface())
+			if (autotiles[i]->megaTexture())
 				continue;
 
 			usableATs.push_back(i);
@@ -490,23 +494,58 @@ struct TilemapPrivate
 		return true;
 	}
 
-	/* Allocates correctly sized TexFBO for atlas */
+	/* Recomputes the atlas dimensions; the texture itself
+	 * is acquired along with its contents in buildAtlas() */
 	void allocateAtlas()
 	{
 		updateAtlasInfo();
 
-		/* Aquire atlas tex */
-		shState->releaseAtlasTex(atlas.gl);
-		shState->requestAtlasTex(atlas.size.x, atlas.size.y, atlas.gl);
-
 		atlasDirty = true;
 	}
 
-	/* Assembles atlas from tileset and autotile bitmaps */
+	void releaseAtlas()
+	{
+		if (atlas.key.stamps.empty())
+			return;
+
+		shState->releaseAtlasTex(atlas.key);
+		atlas.key = TileAtlas::Key();
+		atlas.gl = TEXFBO();
+	}
+
+	TileAtlas::Key atlasKey() const
+	{
+		TileAtlas::Key key;
+		key.size = atlas.size;
+		key.stamps.resize(1 + autotileCount, TileAtlas::Key::NoBitmap);
+		key.stamps[0] = tileset->contentStamp();
+
+		for (size_t i = 0; i < atlas.usableATs.size(); ++i)
+		{
+			const uint8_t atInd = atlas.usableATs[i];
+			key.stamps[1 + atInd] = autotiles[atInd]->contentStamp();
+		}
+
+		return key;
+	}
+
+	/* Assembles atlas from tileset and autotile bitmaps,
+	 * unless an atlas with the same contents already exists */
 	void buildAtlas()
 	{
 		updateAutotileInfo();
 
+		const TileAtlas::Key key = atlasKey();
+
+		if (key == atlas.key)
+			return;
+
+		releaseAtlas();
+		atlas.key = key;
+
+		if (!shState->requestAtlasTex(key, atlas.gl))
+			return;
+
 		TileAtlas::BlitVec blits = TileAtlas::calcBlits(atlas.efTilesetH, atlas.size);
 
 		/* Clear atlas */
@@ -550,62 +589,16 @@ struct TilemapPrivate
 		GLMeta::blitEnd();
 
 		/* Blit tileset */
-		if (tileset->megaSurface())
+		if (MegaTexture *mega = tileset->megaTexture())
 		{
 			/* Mega surface tileset */
-			SDL_Surface *tsSurf = tileset->megaSurface();
-
-			if (shState->config().subImageFix)
-			{
-				/* Implementation for broken GL drivers */
-				FBO::bind(atlas.gl.fbo);
-				glState.blend.pushSet(false);
-				glState.viewport.pushSet(IntRect(0, 0, atlas.size.x, atlas.size.y));
-
-				SimpleShader &shader = shState->shaders().simple;
-				shader.bind();
-				shader.applyViewportProj();
-				shader.setTranslation(Vec2i());
-
-				Quad &quad = shState->gpQuad();
-
-				for (size_t i = 0; i < blits.size(); ++i)
-				{
-					const TileAtlas::Blit &blitOp = blits[i];
-
-					Vec2i texSize;
-					shState->ensureTexSize(tsLaneW, blitOp.h, texSize);
-					shState->bindTex();
-					GLMeta::subRectImageUpload(tsSurf->w, blitOp.src.x, blitOp.src.y,
-					                           0, 0, tsLaneW, blitOp.h, tsSurf, GL_RGBA);
-
-					shader.setTexSize(texSize);
-					quad.setTexRect(FloatRect(0, 0, tsLaneW, blitOp.h));
-					quad.setPosRect(FloatRect(blitOp.dst.x, blitOp.dst.y, tsLaneW, blitOp.h));
-
-					quad.draw();
-				}
-
-				GLMeta::subRectImageEnd();
-				glState.viewport.pop();
-				glState.blend.pop();
-			}
-			else
+			for (size_t i = 0; i < blits.size(); ++i)
 			{
-				/* Clean implementation */
-				TEX::bind(atlas.gl.tex);
-
-				for (size_t i = 0; i < blits.size(); ++i)
-				{
-					const TileAtlas::Blit &blitOp = blits[i];
-
-					GLMeta::subRectImageUpload(tsSurf->w, blitOp.src.x, blitOp.src.y,
-					                           blitOp.dst.x, blitOp.dst.y, tsLaneW, blitOp.h, tsSurf, GL_RGBA);
-				}
+				const TileAtlas::Blit &blitOp = blits[i];
+				const IntRect dst(blitOp.dst.x, blitOp.dst.y, tsLaneW, blitOp.h);
 
-				GLMeta::subRectImageEnd();
+				mega->blit(atlas.gl, IntRect(blitOp.src.x, blitOp.src.y, tsLaneW, blitOp.h), dst);
 			}
-
 		}
 		else
 		{
@@ -798,7 +791,7 @@ struct TilemapPrivate
 		}
 		else
 		{
-			shaderVar = &shState->shaders().simple;
+			shaderVar = &shState->shaders().simple.get();
 			shaderVar->bind();
 		}
 
@@ -1015,6 +1008,7 @@ void GroundLayer::draw()
 void GroundLayer::drawInt()
 {
 	gl.DrawElements(GL_TRIANGLES, vboCount, _GL_INDEX_TYPE, (GLvoid*) 0);
+	++glCallStats.draws;
 }
 
 void GroundLayer::onGeometryChange(const Scene::Geometry &geo)
@@ -1063,6 +1057,7 @@ void ZLayer::draw()
 void ZLayer::drawInt()
 {
 	gl.DrawElements(GL_TRIANGLES, vboBatchCount, _GL_INDEX_TYPE, (GLvoid*) vboOffset);
+	++glCallStats.draws;
 }
 
 int ZLayer::calculateZ(TilemapPrivate *p, int index)
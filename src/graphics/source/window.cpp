@@ -27,11 +27,12 @@
 #include "etc.h"
 #include "etc-internal.h"
 #include "tilequad.h"
+#include "windowframe.h"
 
 #include "gl-util.h"
 #include "quad.h"
 #include "quadarray.h"
-#include "texpool.h"
+#include "shader.h"
 #include "glstate.h"
 
 #include <sigc++/connection.h>
@@ -42,14 +43,8 @@ struct Sides
 	T l, r, t, b;
 };
 
-template<typename T>
-struct Corners
-{
-	T tl, tr, bl, br;
-};
-
-static const IntRect backgroundSrc(0, 0, 128, 128);
-
+/* Background and border source rects
+ * live in windowFrame.frag */
 static const IntRect cursorSrc(128, 64, 32, 32);
 
 static const IntRect pauseAniSrc[] =
@@ -60,22 +55,6 @@ static const IntRect pauseAniSrc[] =
 	IntRect(176, 80, 16, 16)
 };
 
-static const Sides<IntRect> bordersSrc =
-{
-	IntRect(128, 16, 16, 32),
-	IntRect(176, 16, 16, 32),
-	IntRect(144,  0, 32, 16),
-	IntRect(144, 48, 32, 16)
-};
-
-static const Corners<IntRect> cornersSrc =
-{
-	IntRect(128,  0, 16, 16),
-	IntRect(176,  0, 16, 16),
-	IntRect(128, 48, 16, 16),
-	IntRect(176, 48, 16, 16)
-};
-
 static const Sides<IntRect> scrollArrowSrc =
 {
 	IntRect(144, 24,  8, 16),
@@ -161,9 +140,9 @@ struct QuadChunk
  *   clipped to a 16 pixel smaller rectangle. Position is adjusted
  *   with OX/OY.
  *
- * BaseTex: If the window has an opacity <255, we have to prerender
- *   the base to a texture and draw that. Otherwise, we can draw the
- *   quad array directly to the screen.
+ * Frame: The base prerendered to a texture in one pass (see
+ *   WindowFrameShader). Frames are shared between all windows
+ *   using the same skin, size, back opacity and stretch mode.
  */
 
 struct WindowPrivate
@@ -189,19 +168,13 @@ struct WindowPrivate
 	NormValue backOpacity;
 	NormValue contentsOpacity;
 
-	bool baseVertDirty;
-	bool opacityDirty;
-	bool baseTexDirty;
-
-	ColorQuadArray baseQuadArray;
-
-	/* Used when opacity < 255 */
-	TEXFBO baseTex;
-	bool useBaseTex;
-
-	QuadChunk backgroundVert;
+	struct
+	{
+		WindowFrame::Key key;
+		TEXFBO gl;
+	} frame;
 
-	Quad baseTexQuad;
+	Quad frameQuad;
 
 	struct WindowControls : public ViewportElement
 	{
@@ -258,9 +231,6 @@ struct WindowPrivate
 	      opacity(255),
 	      backOpacity(255),
 	      contentsOpacity(255),
-	      baseVertDirty(true),
-	      opacityDirty(true),
-	      baseTexDirty(true),
 	      controlsElement(this, viewport),
 	      cursorAniAlphaIdx(0),
 	      pauseAniAlphaIdx(0),
@@ -279,7 +249,7 @@ struct WindowPrivate
 
 	~WindowPrivate()
 	{
-		shState->texPool().release(baseTex);
+		releaseFrame();
 		cursorRectCon.disconnect();
 		prepareCon.disconnect();
 	}
@@ -296,161 +266,72 @@ struct WindowPrivate
 		        (sigc::mem_fun(this, &WindowPrivate::markControlVertDirty));
 	}
 
-	void buildBaseVert()
+	void releaseFrame()
 	{
-		int w = size.x;
-		int h = size.y;
-
-		IntRect bgRect(2, 2, w - 4, h - 4);
-
-		Sides<IntRect> borderRects;
-		borderRects.l = IntRect(0,    8,    16,   h-16);
-		borderRects.r = IntRect(w-16, 8,    16,   h-16);
-		borderRects.t = IntRect(8,    0,    w-16, 16  );
-		borderRects.b = IntRect(8,    h-16, w-16, 16  );
-
-		Corners<IntRect> cornerRects;
-		cornerRects.tl = IntRect(0,    0,    16, 16);
-		cornerRects.tr = IntRect(w-16, 0,    16, 16);
-		cornerRects.bl = IntRect(0,    h-16, 16, 16);
-		cornerRects.br = IntRect(w-16, h-16, 16, 16);
-
-		/* Required quad count */
-		int count = 0;
-
-		/* Background */
-		if (bgStretch)
-			backgroundVert.count = 1;
-		else
-			backgroundVert.count =
-			        TileQuads::twoDimCount(128, 128, bgRect.w, bgRect.h);
-
-		count += backgroundVert.count;
-
-		/* Borders (sides) */
-		count += TileQuads::oneDimCount(32, w-16) * 2;
-		count += TileQuads::oneDimCount(32, h-16) * 2;
-
-		/* Corners */
-		count += 4;
-
-		/* Our vertex array */
-		baseQuadArray.resize(count);
-		Vertex *vert = baseQuadArray.vertices.data();
-
-		int i = 0;
-		backgroundVert.vert = &vert[i];
-
-		/* Background */
-		if (bgStretch)
-		{
-			Quad::setTexRect(&vert[i*4], backgroundSrc);
-			Quad::setPosRect(&vert[i*4], bgRect);
-			i += 1;
-		}
-		else
-		{
-			i += TileQuads::build(backgroundSrc, bgRect, &vert[i*4]);
-		}
-
-		/* Borders */
-		i += TileQuads::buildH(bordersSrc.t, w-16, 8,    0,    &vert[i*4]);
-		i += TileQuads::buildH(bordersSrc.b, w-16, 8,    h-16, &vert[i*4]);
-		i += TileQuads::buildV(bordersSrc.l, h-16, 0,    8,    &vert[i*4]);
-		i += TileQuads::buildV(bordersSrc.r, h-16, w-16, 8,    &vert[i*4]);
-
-		/* Corners */
-		i += Quad::setTexPosRect(&vert[i*4], cornersSrc.tl, cornerRects.tl);
-		i += Quad::setTexPosRect(&vert[i*4], cornersSrc.tr, cornerRects.tr);
-		i += Quad::setTexPosRect(&vert[i*4], cornersSrc.bl, cornerRects.bl);
-		i += Quad::setTexPosRect(&vert[i*4], cornersSrc.br, cornerRects.br);
-
-		for (int j = 0; j < count*4; ++j)
-			vert[j].color = Vec4(1, 1, 1, 1);
-
-
-		FloatRect texRect = FloatRect(0, 0, size.x, size.y);
-		baseTexQuad.setTexPosRect(texRect, texRect);
+		if (frame.key.size == Vec2i())
+			return;
 
-		opacityDirty = true;
-		baseTexDirty = true;
+		shState->releaseWindowFrame(frame.key);
+		frame.key = WindowFrame::Key();
+		frame.gl = TEXFBO();
 	}
 
-	void updateBaseAlpha()
+	WindowFrame::Key frameKey() const
 	{
-		/* This is always applied unconditionally */
-		backgroundVert.setAlpha(backOpacity.norm);
+		WindowFrame::Key key;
+		key.skinStamp = windowskin->contentStamp();
+		key.size = size;
+		key.backOpacity = backOpacity;
+		key.bgStretch = bgStretch;
 
-		baseTexQuad.setColor(Vec4(1, 1, 1, opacity.norm));
-
-		baseTexDirty = true;
+		return key;
 	}
 
-	void ensureBaseTexReady()
+	/* Renders the frame, unless one with
+	 * the same look already exists */
+	void updateFrame()
 	{
-		/* Make sure texture is big enough */
-		int newW = baseTex.width;
-		int newH = baseTex.height;
-		bool resizeNeeded = false;
-
-		if (size.x > baseTex.width)
-		{
-			newW = findNextPow2(size.x);
-			resizeNeeded = true;
-		}
-		if (size.y > baseTex.height)
-		{
-			newH = findNextPow2(size.y);
-			resizeNeeded = true;
-		}
+		const WindowFrame::Key key = frameKey();
 
-		if (!resizeNeeded)
+		if (key == frame.key)
 			return;
 
-		shState->texPool().release(baseTex);
-		baseTex = shState->texPool().request(newW, newH);
+		/* An animated window (fading back opacity, say) keeps
+		 * re-rendering into the frame it already holds */
+		const bool fresh = (frame.key.size == Vec2i())
+			? shState->requestWindowFrame(key, frame.gl)
+			: shState->replaceWindowFrame(frame.key, key, frame.gl);
 
-		baseTexDirty = true;
-	}
+		frame.key = key;
 
-	void redrawBaseTex()
-	{
-		/* Discard old buffer */
-		TEX::bind(baseTex.tex);
-		TEX::allocEmpty(baseTex.width, baseTex.height);
-		TEX::unbind();
+		FloatRect frameRect(0, 0, size.x, size.y);
+		frameQuad.setTexPosRect(frameRect, frameRect);
 
-		FBO::bind(baseTex.fbo);
-		glState.viewport.pushSet(IntRect(0, 0, baseTex.width, baseTex.height));
-		glState.clearColor.pushSet(Vec4());
+		if (!fresh)
+			return;
 
-		SimpleAlphaShader &shader = shState->shaders().simpleAlpha;
+		FBO::bind(frame.gl.fbo);
+		glState.viewport.pushSet(IntRect(0, 0, size.x, size.y));
+
+		WindowFrameShader &shader = shState->shaders().windowFrame;
 		shader.bind();
 		shader.applyViewportProj();
 		shader.setTranslation(Vec2i());
+		shader.setFrameSize(size);
+		shader.setBackOpacity(backOpacity.norm);
+		shader.setBgStretch(bgStretch);
 
-		/* Clear texture */
-		FBO::clear();
-
-		/* Repaint base */
 		windowskin->bindTex(shader);
+		shader.setSkinSize(Vec2i(windowskin->width(), windowskin->height()));
 		TEX::setSmooth(true);
 
-		/* We need to blit the background without blending,
-		 * because we want to retain its correct alpha value.
-		 * Otherwise it would be mutliplied by the backgrounds 0 alpha */
+		/* The shader does its own compositing and
+		 * writes every pixel, including transparent ones */
 		glState.blend.pushSet(false);
 
-		baseQuadArray.draw(0, backgroundVert.count);
+		frameQuad.draw();
 
-		/* Now draw the rest (ie. the frame) with blending */
 		glState.blend.pop();
-		glState.blendMode.pushSet(BlendNormal);
-
-		baseQuadArray.draw(backgroundVert.count, baseQuadArray.count()-backgroundVert.count);
-
-		glState.clearColor.pop();
-		glState.blendMode.pop();
 		glState.viewport.pop();
 		TEX::setSmooth(false);
 	}
@@ -510,42 +391,13 @@ struct WindowPrivate
 
 	void prepare()
 	{
-		if (size.x <= 0 || size.y <= 0)
-			return;
-
-		bool updateBaseQuadArray = false;
-
-		if (baseVertDirty)
+		if (size.x <= 0 || size.y <= 0 || nullOrDisposed(windowskin))
 		{
-			buildBaseVert();
-			baseVertDirty = false;
-			updateBaseQuadArray = true;
-		}
-
-		if (opacityDirty)
-		{
-			updateBaseAlpha();
-			opacityDirty = false;
-			updateBaseQuadArray = true;
+			releaseFrame();
+			return;
 		}
 
-		if (updateBaseQuadArray)
-			baseQuadArray.commit();
-
-		/* If opacity has effect, we must prerender to a texture
-		 * and then draw this texture instead of the quad array */
-		useBaseTex = opacity < 255;
-
-		if (useBaseTex)
-		{
-			ensureBaseTexReady();
-
-			if (baseTexDirty)
-			{
-				redrawBaseTex();
-				baseTexDirty = false;
-			}
-		}
+		updateFrame();
 	}
 
 	void drawBase()
@@ -553,30 +405,17 @@ struct WindowPrivate
 		if (nullOrDisposed(windowskin))
 			return;
 
-		if (size == Vec2i(0, 0))
+		if (frame.key.size == Vec2i())
 			return;
 
 		SimpleAlphaShader &shader = shState->shaders().simpleAlpha;
 		shader.bind();
 		shader.applyViewportProj();
 		shader.setTranslation(position + sceneOffset);
+		shader.setTexSize(frame.key.size);
 
-		if (useBaseTex)
-		{
-			shader.setTexSize(Vec2i(baseTex.width, baseTex.height));
-
-			TEX::bind(baseTex.tex);
-			baseTexQuad.draw();
-		}
-		else
-		{
-			windowskin->bindTex(shader);
-			TEX::setSmooth(true);
-
-			baseQuadArray.draw();
-
-			TEX::setSmooth(false);
-		}
+		TEX::bind(frame.gl.tex);
+		frameQuad.draw();
 	}
 
 	void drawControls()
@@ -751,7 +590,6 @@ void Window::setStretch(bool value)
 		return;
 
 	p->bgStretch = value;
-	p->baseVertDirty = true;
 }
 
 void Window::setActive(bool value)
@@ -786,7 +624,6 @@ void Window::setWidth(int value)
 		return;
 
 	p->size.x = value;
-	p->baseVertDirty = true;
 }
 
 void Window::setHeight(int value)
@@ -797,7 +634,6 @@ void Window::setHeight(int value)
 		return;
 
 	p->size.y = value;
-	p->baseVertDirty = true;
 }
 
 void Window::setOX(int value)
@@ -830,7 +666,7 @@ void Window::setOpacity(int value)
 		return;
 
 	p->opacity = value;
-	p->opacityDirty = true;
+	p->frameQuad.setColor(Vec4(1, 1, 1, p->opacity.norm));
 }
 
 void Window::setBackOpacity(int value)
@@ -841,7 +677,6 @@ void Window::setBackOpacity(int value)
 		return;
 
 	p->backOpacity = value;
-	p->opacityDirty = true;
 }
 
 void Window::setContentsOpacity(int value)
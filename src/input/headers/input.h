@@ -24,8 +24,11 @@
 
 #include <SDL2/SDL_keycode.h>
 
+#include <vector>
+
 struct InputPrivate;
 struct RGSSThreadData;
+struct InputEvent;
 
 #define BUTTONCODE_SDLK_OFFSET 60
 #define BUTTONCODE_SDLK_COUNT 0x180
@@ -319,6 +322,10 @@ public:
 
 	bool hasQuit();
 
+	/* Button transitions consumed by the last update,
+	 * oldest first */
+	const std::vector<InputEvent> &rawEvents() const;
+
 	Uint16 modkeys;
 
 	void setKey(int button);
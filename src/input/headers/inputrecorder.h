@@ -0,0 +1,92 @@
+/*
+** inputrecorder.h
+**
+** This file is part of mkxp.
+**
+** Copyright (C) 2014 Jonas Kulla <Nyocurio@gmail.com>
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef INPUTRECORDER_H
+#define INPUTRECORDER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+struct Config;
+struct InputEvent;
+
+/* Records the raw input state the event thread publishes
+ * (keys, modifiers, controller, joystick and mouse) and the
+ * button transitions drained that frame once per
+ * Input::update, or feeds a previous recording back in its
+ * place, keyed by Graphics.frame_count.
+ *
+ * File layout (host byte order):
+ *   "MKXPINP2", u32 snapshot size
+ *   per changed frame: u32 frame, u16 run count, u16 event count,
+ *                      runs of (u16 offset, u16 length, bytes),
+ *                      events of (u8 type, u16 code, u16 key slot,
+ *                                 u64 time) */
+class InputRecorder
+{
+public:
+	/* 'extra' is recorded and replayed along with
+	 * the event thread's state */
+	InputRecorder(const Config &conf, void *extra, size_t extraSize);
+	~InputRecorder();
+
+	/* Called at the start of every Input::update, before
+	 * bindings are polled. 'events' are the transitions
+	 * drained from the event thread; they are logged, or
+	 * replaced by the recorded ones during replay */
+	void update(int frame, std::vector<InputEvent> &events);
+
+	bool recording() const { return file != 0; }
+	bool replaying() const { return replayActive; }
+
+private:
+	void readSnapshot(std::vector<uint8_t> &snap) const;
+	void writeSnapshot(const std::vector<uint8_t> &snap) const;
+
+	void openRecord(const char *path);
+	void openReplay(const char *path);
+
+	void record(int frame, const std::vector<InputEvent> &events);
+	void replay(int frame, std::vector<InputEvent> &events);
+	void finishReplay(int frame);
+
+	struct Part
+	{
+		void *data;
+		size_t size;
+	};
+
+	std::vector<Part> parts;
+
+	FILE *file;
+
+	/* Last recorded / replayed state */
+	std::vector<uint8_t> snapshot;
+	std::vector<uint8_t> scratch;
+
+	std::vector<uint8_t> replayData;
+	size_t replayPos;
+	bool replayActive;
+};
+
+#endif // INPUTRECORDER_H
@@ -23,6 +23,8 @@
 #include "sharedstate.h"
 #include "eventthread.h"
 #include "keybindings.h"
+#include "inputrecorder.h"
+#include "graphics.h"
 #include "exception.h"
 #include "util.h"
 
@@ -56,6 +58,23 @@ struct ButtonState
 	{}
 };
 
+/* Buttons that went down since the previous Input::update,
+ * even if they were released again before it got to poll */
+struct FrameTaps
+{
+	uint8_t keys[SDL_NUM_SCANCODES + BUTTONCODE_SDLK_COUNT];
+	bool mouse[32];
+	bool gc[SDL_CONTROLLER_BUTTON_MAX];
+	bool joy[256];
+};
+
+static FrameTaps frameTaps;
+
+static inline bool keyActive(int slot)
+{
+	return EventThread::keyStates[slot] || frameTaps.keys[slot];
+}
+
 struct KbBindingData
 {
 	SDL_Scancode source;
@@ -71,6 +90,9 @@ struct Binding
 	virtual bool sourceActive() const = 0;
 	virtual bool sourceRepeatable() const = 0;
 
+	/* Pressed anew since the last update */
+	virtual bool sourceTapped() const { return false; }
+
 	Input::ButtonCode target;
 };
 
@@ -88,14 +110,23 @@ struct KbBinding : public Binding
 	{
 		/* Special case aliases */
 		if (source == SDL_SCANCODE_LSHIFT)
-			return EventThread::keyStates[source]
-			    || EventThread::keyStates[SDL_SCANCODE_RSHIFT];
+			return keyActive(source) || keyActive(SDL_SCANCODE_RSHIFT);
 
 		if (source == SDL_SCANCODE_RETURN)
-			return EventThread::keyStates[source]
-			    || EventThread::keyStates[SDL_SCANCODE_KP_ENTER];
+			return keyActive(source) || keyActive(SDL_SCANCODE_KP_ENTER);
 
-		return EventThread::keyStates[source];
+		return keyActive(source);
+	}
+
+	bool sourceTapped() const
+	{
+		if (source == SDL_SCANCODE_LSHIFT)
+			return frameTaps.keys[source] || frameTaps.keys[SDL_SCANCODE_RSHIFT];
+
+		if (source == SDL_SCANCODE_RETURN)
+			return frameTaps.keys[source] || frameTaps.keys[SDL_SCANCODE_KP_ENTER];
+
+		return frameTaps.keys[source];
 	}
 
 	bool sourceRepeatable() const
@@ -115,7 +146,12 @@ struct GcButtonBinding : public Binding
 
 	bool sourceActive() const
 	{
-		return EventThread::gcState.buttons[source];
+		return EventThread::gcState.buttons[source] || frameTaps.gc[source];
+	}
+
+	bool sourceTapped() const
+	{
+		return frameTaps.gc[source];
 	}
 
 	bool sourceRepeatable() const
@@ -165,7 +201,12 @@ struct JsButtonBinding : public Binding
 
 	bool sourceActive() const
 	{
-		return EventThread::joyState.buttons[source];
+		return EventThread::joyState.buttons[source] || frameTaps.joy[source];
+	}
+
+	bool sourceTapped() const
+	{
+		return frameTaps.joy[source];
 	}
 
 	bool sourceRepeatable() const
@@ -249,7 +290,12 @@ struct MsBinding : public Binding
 
 	bool sourceActive() const
 	{
-		return EventThread::mouseState.buttons[index];
+		return EventThread::mouseState.buttons[index] || frameTaps.mouse[index];
+	}
+
+	bool sourceTapped() const
+	{
+		return frameTaps.mouse[index];
 	}
 
 	bool sourceRepeatable() const
@@ -368,6 +414,11 @@ struct InputPrivate
 
 	bool triedExit;
 
+	/* Button transitions consumed by the last update */
+	std::vector<InputEvent> events;
+
+	InputRecorder recorder;
+
 	struct
 	{
 		int active;
@@ -381,6 +432,7 @@ struct InputPrivate
 
 
 	InputPrivate(const RGSSThreadData &rtData)
+	    : recorder(rtData.config, &frameTaps, sizeof(frameTaps))
 	{
 		initStaticKbBindings();
 		initMsBindings();
@@ -442,6 +494,42 @@ struct InputPrivate
 		memset(states, 0, size);
 	}
 
+	void drainEvents()
+	{
+		memset(&frameTaps, 0, sizeof(frameTaps));
+		events.clear();
+
+		InputEvent e;
+
+		while (EventThread::inputEvents.pop(e))
+		{
+			events.push_back(e);
+
+			switch (e.type)
+			{
+			case InputEvent::KeyDown :
+				frameTaps.keys[e.code] = true;
+				frameTaps.keys[e.keySlot] = true;
+				break;
+
+			case InputEvent::MouseDown :
+				if (e.code < ARRAY_SIZE(frameTaps.mouse))
+					frameTaps.mouse[e.code] = true;
+				break;
+
+			case InputEvent::GcButtonDown :
+				if (e.code < ARRAY_SIZE(frameTaps.gc))
+					frameTaps.gc[e.code] = true;
+				break;
+
+			case InputEvent::JoyButtonDown :
+				if (e.code < ARRAY_SIZE(frameTaps.joy))
+					frameTaps.joy[e.code] = true;
+				break;
+			}
+		}
+	}
+
 	void checkBindingChange(const RGSSThreadData &rtData)
 	{
 		BDescVec d;
@@ -600,7 +688,7 @@ struct InputPrivate
 		state.pressed = true;
 
 		/* Must have been released before to trigger */
-		if (!oldState.pressed)
+		if (!oldState.pressed || b.sourceTapped())
 			state.triggered = true;
 
 		/* Unbound keys don't create/break repeat */
@@ -619,12 +707,12 @@ struct InputPrivate
 	}
 
 	void pollKeyboardCode(int i) {
-		if (!EventThread::keyStates[SDL_NUM_SCANCODES + i])
+		if (!keyActive(SDL_NUM_SCANCODES + i))
 			return;
 		ButtonState & state = getState((Input::ButtonCode) (BUTTONCODE_SDLK_OFFSET + i));
 		ButtonState & oldState = getOldState((Input::ButtonCode) (BUTTONCODE_SDLK_OFFSET + i));
 		state.pressed = true;
-		state.triggered = !oldState.pressed;
+		state.triggered = !oldState.pressed || frameTaps.keys[SDL_NUM_SCANCODES + i];
 	}
 
 	void updateDir4()
@@ -712,6 +800,9 @@ struct InputPrivate
 
 Input::Input(const RGSSThreadData &rtData)
 {
+	/* SDL is up by now; raw event times count from here */
+	EventThread::initInputClock();
+
 	p = new InputPrivate(rtData);
 }
 
@@ -720,6 +811,11 @@ void Input::update()
 	shState->checkShutdown();
 	p->checkBindingChange(shState->rtData());
 
+	p->drainEvents();
+
+	/* Log or substitute this frame's device state */
+	p->recorder.update(shState->graphics().getFrameCount(), p->events);
+
 	p->swapBuffers();
 	p->clearBuffer();
 
@@ -762,6 +858,11 @@ void Input::update()
 	rtData.triedExit.clear();
 }
 
+const std::vector<InputEvent> &Input::rawEvents() const
+{
+	return p->events;
+}
+
 bool Input::isPressed(int button)
 {
 	return p->getStateCheck(button).pressed;
@@ -0,0 +1,341 @@
+/*
+** inputrecorder.cpp
+**
+** This file is part of mkxp.
+**
+** Copyright (C) 2014 Jonas Kulla <Nyocurio@gmail.com>
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "inputrecorder.h"
+
+#include "eventthread.h"
+#include "config.h"
+#include "debugwriter.h"
+#include "exception.h"
+#include "util.h"
+
+#include <SDL2/SDL_mutex.h>
+
+#include <string.h>
+#include <algorithm>
+
+#define RECORD_MAGIC "MKXPINP2"
+
+/* Unchanged stretches shorter than this are folded
+ * into the surrounding run to save on run headers */
+#define RUN_MERGE_GAP 4
+
+template<typename T>
+static void writeValue(FILE *f, T value)
+{
+	fwrite(&value, sizeof(value), 1, f);
+}
+
+template<typename T>
+static bool readValue(const std::vector<uint8_t> &data, size_t &pos, T &value)
+{
+	if (pos + sizeof(value) > data.size())
+		return false;
+
+	memcpy(&value, &data[pos], sizeof(value));
+	pos += sizeof(value);
+
+	return true;
+}
+
+InputRecorder::InputRecorder(const Config &conf, void *extra, size_t extraSize)
+    : file(0),
+      replayPos(0),
+      replayActive(false)
+{
+	const Part state[] =
+	{
+		{ EventThread::keyStates,   sizeof(EventThread::keyStates)  },
+		{ &EventThread::modkeys,    sizeof(EventThread::modkeys)    },
+		{ &EventThread::gcState,    sizeof(EventThread::gcState)    },
+		{ &EventThread::joyState,   sizeof(EventThread::joyState)   },
+		{ &EventThread::mouseState, sizeof(EventThread::mouseState) },
+		{ extra,                    extraSize                       }
+	};
+
+	size_t size = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(state); ++i)
+	{
+		parts.push_back(state[i]);
+		size += state[i].size;
+	}
+
+	snapshot.assign(size, 0);
+	scratch.assign(size, 0);
+
+	if (!conf.inputReplay.empty())
+		openReplay(conf.inputReplay.c_str());
+	else if (!conf.inputRecord.empty())
+		openRecord(conf.inputRecord.c_str());
+}
+
+InputRecorder::~InputRecorder()
+{
+	if (file)
+		fclose(file);
+}
+
+void InputRecorder::readSnapshot(std::vector<uint8_t> &snap) const
+{
+	size_t off = 0;
+
+	SDL_LockMutex(EventThread::inputMut);
+
+	for (size_t i = 0; i < parts.size(); ++i)
+	{
+		memcpy(&snap[off], parts[i].data, parts[i].size);
+		off += parts[i].size;
+	}
+
+	SDL_UnlockMutex(EventThread::inputMut);
+}
+
+void InputRecorder::writeSnapshot(const std::vector<uint8_t> &snap) const
+{
+	size_t off = 0;
+
+	SDL_LockMutex(EventThread::inputMut);
+
+	for (size_t i = 0; i < parts.size(); ++i)
+	{
+		memcpy(parts[i].data, &snap[off], parts[i].size);
+		off += parts[i].size;
+	}
+
+	SDL_UnlockMutex(EventThread::inputMut);
+}
+
+void InputRecorder::openRecord(const char *path)
+{
+	file = fopen(path, "wb");
+
+	if (!file)
+	{
+		Debug() << "Cannot open" << path << "for input recording";
+		return;
+	}
+
+	fwrite(RECORD_MAGIC, 1, 8, file);
+	writeValue<uint32_t>(file, snapshot.size());
+	fflush(file);
+
+	Debug() << "Recording input to" << path;
+}
+
+void InputRecorder::openReplay(const char *path)
+{
+	FILE *f = fopen(path, "rb");
+
+	if (!f)
+		throw Exception(Exception::MKXPError,
+		                "Cannot open input recording '%s'", path);
+
+	char magic[8];
+	uint32_t size = 0;
+
+	bool valid = fread(magic, 1, 8, f) == 8
+	          && memcmp(magic, RECORD_MAGIC, 8) == 0
+	          && fread(&size, sizeof(size), 1, f) == 1;
+
+	if (!valid || size != snapshot.size())
+	{
+		fclose(f);
+		throw Exception(Exception::MKXPError,
+		                "Input recording '%s' is invalid or was made by "
+		                "an incompatible build", path);
+	}
+
+	uint8_t buf[4096];
+	size_t n;
+
+	while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+		replayData.insert(replayData.end(), buf, buf + n);
+
+	fclose(f);
+
+	/* Keep the event thread from touching input state
+	 * for as long as we're feeding it */
+	EventThread::inputReplay.set();
+	replayActive = true;
+
+	Debug() << "Replaying input from" << path;
+}
+
+void InputRecorder::update(int frame, std::vector<InputEvent> &events)
+{
+	if (replaying())
+		replay(frame, events);
+	else if (recording())
+		record(frame, events);
+}
+
+void InputRecorder::record(int frame, const std::vector<InputEvent> &events)
+{
+	readSnapshot(scratch);
+
+	std::vector<uint16_t> runs;
+	const size_t size = scratch.size();
+
+	for (size_t i = 0; i < size;)
+	{
+		if (scratch[i] == snapshot[i])
+		{
+			++i;
+			continue;
+		}
+
+		size_t end = i + 1;
+		size_t gap = 0;
+
+		for (; end < size && gap < RUN_MERGE_GAP; ++end)
+			gap = (scratch[end] == snapshot[end]) ? gap + 1 : 0;
+
+		end -= gap;
+
+		runs.push_back(i);
+		runs.push_back(end - i);
+
+		i = end;
+	}
+
+	if (runs.empty() && events.empty())
+		return;
+
+	/* The ring holds far fewer than this */
+	const size_t eventCount = std::min<size_t>(events.size(), UINT16_MAX);
+
+	writeValue<uint32_t>(file, frame);
+	writeValue<uint16_t>(file, runs.size() / 2);
+	writeValue<uint16_t>(file, eventCount);
+
+	for (size_t i = 0; i < runs.size(); i += 2)
+	{
+		writeValue<uint16_t>(file, runs[i]);
+		writeValue<uint16_t>(file, runs[i+1]);
+		fwrite(&scratch[runs[i]], 1, runs[i+1], file);
+	}
+
+	for (size_t i = 0; i < eventCount; ++i)
+	{
+		writeValue<uint8_t>(file, events[i].type);
+		writeValue<uint16_t>(file, events[i].code);
+		writeValue<uint16_t>(file, events[i].keySlot);
+		writeValue<uint64_t>(file, events[i].time);
+	}
+
+	/* Only frames with changes get here, so this is cheap, and
+	 * a crash loses at most the record being written (which
+	 * replay() already treats as the end of the recording) */
+	fflush(file);
+
+	snapshot.swap(scratch);
+}
+
+void InputRecorder::replay(int frame, std::vector<InputEvent> &events)
+{
+	/* The event thread drops device input while we
+	 * replay, so the recorded transitions stand in */
+	events.clear();
+
+	/* The last record stays in effect for its own frame */
+	if (replayPos == replayData.size())
+	{
+		finishReplay(frame);
+		return;
+	}
+
+	while (replayPos < replayData.size())
+	{
+		size_t pos = replayPos;
+		uint32_t recFrame;
+		uint16_t runCount, eventCount;
+
+		if (!readValue(replayData, pos, recFrame)
+		||  !readValue(replayData, pos, runCount)
+		||  !readValue(replayData, pos, eventCount))
+		{
+			finishReplay(frame);
+			return;
+		}
+
+		if ((int) recFrame > frame)
+			break;
+
+		for (uint16_t i = 0; i < runCount; ++i)
+		{
+			uint16_t off, len;
+
+			if (!readValue(replayData, pos, off)
+			||  !readValue(replayData, pos, len)
+			||  off + len > snapshot.size()
+			||  pos + len > replayData.size())
+			{
+				Debug() << "Input recording is truncated";
+				finishReplay(frame);
+				return;
+			}
+
+			memcpy(&snapshot[off], &replayData[pos], len);
+			pos += len;
+		}
+
+		for (uint16_t i = 0; i < eventCount; ++i)
+		{
+			InputEvent e;
+
+			if (!readValue(replayData, pos, e.type)
+			||  !readValue(replayData, pos, e.code)
+			||  !readValue(replayData, pos, e.keySlot)
+			||  !readValue(replayData, pos, e.time))
+			{
+				Debug() << "Input recording is truncated";
+				finishReplay(frame);
+				return;
+			}
+
+			events.push_back(e);
+		}
+
+		replayPos = pos;
+	}
+
+	/* Rewritten every frame, so nothing else can
+	 * leave a mark on the replayed state */
+	writeSnapshot(snapshot);
+}
+
+void InputRecorder::finishReplay(int frame)
+{
+	Debug() << "Input replay finished at frame" << frame;
+
+	std::vector<uint8_t>().swap(replayData);
+	replayPos = 0;
+	replayActive = false;
+
+	/* Release anything the recording left held down
+	 * and hand control back to the event thread */
+	std::fill(snapshot.begin(), snapshot.end(), 0);
+	writeSnapshot(snapshot);
+
+	EventThread::inputReplay.clear();
+}
@@ -126,7 +126,9 @@ int rgssThreadFun(void *userdata)
 
 	printGLInfo();
 
-	bool vsync = conf.vsync || conf.syncToRefreshrate;
+	bool uncapped = conf.headless
+	             || (conf.inputReplayUncapped && !conf.inputReplay.empty());
+	bool vsync = (conf.vsync || conf.syncToRefreshrate) && !uncapped;
 	SDL_GL_SetSwapInterval(vsync ? 1 : 0);
 
 #ifndef NDEBUG
@@ -252,8 +254,8 @@ int main(int argc, char *argv[]) {
 	SDL_SetHint(SDL_HINT_VIDEO_HIGHDPI_DISABLED, "1");
 	SDL_SetHint(SDL_HINT_VIDEO_X11_NET_WM_BYPASS_COMPOSITOR, "0");
 
-	/* initialize SDL first */
-	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_JOYSTICK | SDL_INIT_GAMECONTROLLER) < 0)
+	/* initialize SDL first (video follows once the config is known) */
+	if (SDL_Init(SDL_INIT_JOYSTICK | SDL_INIT_GAMECONTROLLER) < 0)
 	{
 		showInitError(std::string("Error initializing SDL: ") + SDL_GetError());
 		return 0;
@@ -317,6 +319,21 @@ int main(int argc, char *argv[]) {
 #endif
 
 
+	if (conf.headless)
+	{
+		/* Renders through EGL pbuffers, no display needed */
+		SDL_setenv("SDL_VIDEODRIVER", "offscreen", 1);
+
+		/* Likely no sound hardware either */
+		SDL_setenv("ALSOFT_DRIVERS", "null", 0);
+	}
+
+	if (SDL_InitSubSystem(SDL_INIT_VIDEO) < 0)
+	{
+		showInitError(std::string("Error initializing SDL video: ") + SDL_GetError());
+		return 0;
+	}
+
 	extern int screenMain(Config &conf);
 	if (conf.screenMode)
 		return screenMain(conf);
@@ -359,7 +376,9 @@ int main(int argc, char *argv[]) {
 	// 	winFlags |= SDL_WINDOW_RESIZABLE;
 	// #endif
 
-	if (conf.fullscreen)
+	if (conf.headless)
+		winFlags |= SDL_WINDOW_HIDDEN;
+	else if (conf.fullscreen)
 		winFlags |= SDL_WINDOW_FULLSCREEN_DESKTOP;
 
 	win = SDL_CreateWindow(conf.windowTitle.c_str(),
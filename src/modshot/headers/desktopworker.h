@@ -0,0 +1,46 @@
+#pragma once
+
+#include <SDL2/SDL_thread.h>
+#include <SDL2/SDL_mutex.h>
+
+#include <deque>
+#include <functional>
+
+// Runs desktop integration work (wallpaper changes, notifications)
+// on a background thread, in the order it was posted. These can block
+// on external processes or D-Bus for a long time, so they shouldn't
+// run on the RGSS thread.
+class DesktopWorker {
+public:
+	typedef std::function<void()> Job;
+
+	static DesktopWorker &instance();
+
+	~DesktopWorker();
+
+	// Queues a job, returning a ticket for it
+	unsigned int post(const Job &job);
+
+	// Whether the job with this ticket has run
+	bool finished(unsigned int ticket);
+	// Whether everything posted so far has run
+	bool idle();
+	// Blocks until everything posted so far has run
+	void wait();
+
+private:
+	DesktopWorker();
+
+	static int threadFunc(void *data);
+	void run();
+
+	SDL_Thread *thread;
+	SDL_mutex *mutex;
+	SDL_cond *workCond;
+	SDL_cond *doneCond;
+
+	std::deque<Job> queue;
+	unsigned int posted;
+	unsigned int completed;
+	bool quit;
+};
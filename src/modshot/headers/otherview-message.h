@@ -1,5 +1,7 @@
 #include "etc.h"
+#include "shm-ring.h"
 #include <string>
+#include <vector>
 #include <zmqpp/zmqpp.hpp>
 
 struct Config;
@@ -10,6 +12,17 @@ class OtherViewMessager {
     std::string otherViewEndpoint;
     std::string normalEndpoint;
 
+    // Shared memory transport (with "otherViewShm"); zmq is
+    // used when it's off, the block couldn't be set up, or
+    // until both sides shook hands over it
+    bool useShm;
+    SharedMemory shm;
+    ShmHandshake handshake;
+    ShmRing sendRing;
+    ShmRing recvRing;
+    // When the OtherView instance last (re)mapped the block
+    uint32_t shmOpenTicks;
+
     zmqpp::context otherview_context;
     zmqpp::context normal_context;
     zmqpp::socket_type otherview_socket_type;
@@ -17,10 +30,21 @@ class OtherViewMessager {
 
     zmqpp::socket *otherview_socket;
     zmqpp::socket *normal_socket;
+    bool shmReady();
+    void attachRings();
+    bool receive(int &type, std::string &data);
 public:
+    struct Message {
+        int type;
+        std::string data;
+    };
+
     OtherViewMessager(const Config &c);
     ~OtherViewMessager();
     bool sendMsg(const char* message);
+    bool sendMsg(const char *data, size_t size, int type);
     std::string getMsg();
+    // Appends every message that arrived so far to 'out'
+    void drain(std::vector<Message> &out);
     void close();
 };
\ No newline at end of file
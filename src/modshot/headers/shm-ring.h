@@ -0,0 +1,119 @@
+#pragma once
+
+#include <SDL2/SDL_atomic.h>
+
+#include <string>
+#include <stdint.h>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#endif
+
+// Named block of memory shared with another process on this machine
+class SharedMemory {
+public:
+	SharedMemory();
+	~SharedMemory();
+
+	// Creates a block, dropping any stale one of the same name where the
+	// platform allows. On Windows an existing mapping may be reused as is,
+	// possibly still mapped by a peer, so owners reset it through
+	// ShmHandshake rather than relying on it being zeroed
+	bool create(const std::string &name, size_t size);
+	// Maps a block some other process created
+	bool open(const std::string &name, size_t size);
+	void close();
+
+	void *data() const { return mem; }
+
+private:
+	std::string name;
+	size_t size;
+	void *mem;
+	bool owner;
+#ifdef _WIN32
+	HANDLE mapping;
+#endif
+};
+
+// Single producer, single consumer queue of typed binary messages,
+// living in shared memory. Zeroed memory is a valid empty ring, so
+// neither side has to wait for the other to set it up.
+class ShmRing {
+public:
+	// Size of the ring's bookkeeping in front of the message data
+	static const size_t HeaderSize = 64;
+
+	ShmRing();
+
+	// 'capacity' must be a power of two
+	void attach(void *mem, uint32_t capacity);
+	bool attached() const { return header != 0; }
+
+	// Producer side; fails if the message doesn't fit right now
+	bool push(int type, const char *data, uint32_t size);
+	// Consumer side; fails if there is nothing to read
+	bool pop(int &type, std::string &data);
+
+private:
+	struct Header {
+		// Consumer position, in bytes
+		SDL_atomic_t head;
+		// Producer position, in bytes
+		SDL_atomic_t tail;
+	};
+
+	void write(uint32_t pos, const void *src, uint32_t size);
+	void read(uint32_t pos, void *dst, uint32_t size);
+
+	Header *header;
+	char *ring;
+	uint32_t capacity;
+};
+
+// Handshake word block in front of a shared block's rings, so both sides
+// know they mapped the same, current block before using it. The owner
+// bumps the generation after resetting the block; the peer announces
+// itself with a nonce that the owner echoes back. A peer that mapped a
+// block nobody owns anymore (left by a crashed run) never gets its echo.
+// The peer re-checks before every use, as the owner may reset the block
+// under it.
+class ShmHandshake {
+public:
+	// Bytes reserved for the handshake in front of the rings
+	static const size_t Size = 64;
+
+	enum PeerState {
+		// Not acknowledged (yet); keep using the fallback transport
+		Waiting,
+		// Acknowledged by the owner of this generation
+		Linked,
+		// The owner reset the block; detach from the rings
+		Reset
+	};
+
+	ShmHandshake();
+
+	// Owner side: zeroes 'size' bytes of 'block' (handshake included)
+	// and publishes a new generation
+	void reset(void *block, size_t size);
+	// Owner side: acknowledges peers; true once one announced itself
+	bool ownerPoll();
+
+	// Peer side
+	void attach(void *block);
+	PeerState peerPoll();
+
+private:
+	struct Control {
+		SDL_atomic_t magic;
+		SDL_atomic_t generation;
+		SDL_atomic_t peerNonce;
+		SDL_atomic_t ownerAck;
+	};
+
+	Control *control;
+	int generation;
+	int nonce;
+};
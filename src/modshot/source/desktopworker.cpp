@@ -0,0 +1,113 @@
+#include "desktopworker.h"
+
+DesktopWorker &DesktopWorker::instance()
+{
+	static DesktopWorker worker;
+	return worker;
+}
+
+DesktopWorker::DesktopWorker()
+	: thread(0),
+	  mutex(SDL_CreateMutex()),
+	  workCond(SDL_CreateCond()),
+	  doneCond(SDL_CreateCond()),
+	  posted(0),
+	  completed(0),
+	  quit(false)
+{
+}
+
+DesktopWorker::~DesktopWorker()
+{
+	if (thread)
+	{
+		// Let queued work (eg. a wallpaper reset) finish first
+		SDL_LockMutex(mutex);
+		quit = true;
+		SDL_CondSignal(workCond);
+		SDL_UnlockMutex(mutex);
+
+		SDL_WaitThread(thread, 0);
+	}
+
+	SDL_DestroyCond(doneCond);
+	SDL_DestroyCond(workCond);
+	SDL_DestroyMutex(mutex);
+}
+
+unsigned int DesktopWorker::post(const Job &job)
+{
+	SDL_LockMutex(mutex);
+
+	// Started on first use, most games never need it
+	if (!thread)
+		thread = SDL_CreateThread(threadFunc, "desktop", this);
+
+	queue.push_back(job);
+	unsigned int ticket = ++posted;
+
+	SDL_CondSignal(workCond);
+	SDL_UnlockMutex(mutex);
+
+	return ticket;
+}
+
+bool DesktopWorker::finished(unsigned int ticket)
+{
+	SDL_LockMutex(mutex);
+	bool result = completed >= ticket;
+	SDL_UnlockMutex(mutex);
+
+	return result;
+}
+
+bool DesktopWorker::idle()
+{
+	SDL_LockMutex(mutex);
+	bool result = completed == posted;
+	SDL_UnlockMutex(mutex);
+
+	return result;
+}
+
+void DesktopWorker::wait()
+{
+	SDL_LockMutex(mutex);
+
+	while (completed != posted)
+		SDL_CondWait(doneCond, mutex);
+
+	SDL_UnlockMutex(mutex);
+}
+
+int DesktopWorker::threadFunc(void *data)
+{
+	static_cast<DesktopWorker*>(data)->run();
+	return 0;
+}
+
+void DesktopWorker::run()
+{
+	SDL_LockMutex(mutex);
+
+	for (;;)
+	{
+		while (queue.empty() && !quit)
+			SDL_CondWait(workCond, mutex);
+
+		if (queue.empty())
+			break;
+
+		Job job = queue.front();
+		queue.pop_front();
+
+		SDL_UnlockMutex(mutex);
+		job();
+		SDL_LockMutex(mutex);
+
+		++completed;
+		SDL_CondBroadcast(doneCond);
+	}
+
+	SDL_UnlockMutex(mutex);
+}
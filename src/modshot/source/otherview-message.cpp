@@ -2,9 +2,23 @@
 #include <zmqpp/zmqpp.hpp>
 #include "config.h"
 #include "debugwriter.h"
+#include <SDL2/SDL_timer.h>
+#include <string.h>
+
+#define SHM_NAME "modshot-otherview"
+// Per direction; must be a power of two
+#define SHM_RING_CAPACITY (1 << 20)
+#define SHM_RING_STRIDE (ShmRing::HeaderSize + SHM_RING_CAPACITY)
+#define SHM_SIZE (ShmHandshake::Size + SHM_RING_STRIDE * 2)
+// How long the OtherView instance waits for the normal one to answer
+// its handshake before mapping the block again; a block left over by
+// a crashed run never answers
+#define SHM_HANDSHAKE_TIMEOUT_MS 1000
 
 OtherViewMessager::OtherViewMessager(const Config &c):
-    conf(c)
+    conf(c),
+    useShm(c.otherViewShm),
+    shmOpenTicks(0)
 {
     Debug() << "Setting up otheview";
     isOtherView = c.isOtherView;
@@ -32,6 +46,79 @@ OtherViewMessager::OtherViewMessager(const Config &c):
         otherview_socket->bind(otherViewEndpoint);
         normal_socket->bind(normalEndpoint);
     }
+
+    // The normal instance owns the shared block; the OtherView
+    // instance maps it once it exists (see shmReady)
+    if (useShm && !isOtherView) {
+        if (shm.create(SHM_NAME, SHM_SIZE)) {
+            handshake.reset(shm.data(), SHM_SIZE);
+            Debug() << "Using shared memory for otherview";
+        } else {
+            Debug() << "Failed to create otherview shared memory, using zmq";
+            useShm = false;
+        }
+    }
+}
+
+void OtherViewMessager::attachRings()
+{
+    // First ring carries normal -> otherview, second the reverse
+    char *base = static_cast<char*>(shm.data()) + ShmHandshake::Size;
+    ShmRing &toOther = isOtherView ? recvRing : sendRing;
+    ShmRing &toNormal = isOtherView ? sendRing : recvRing;
+    toOther.attach(base, SHM_RING_CAPACITY);
+    toNormal.attach(base + SHM_RING_STRIDE, SHM_RING_CAPACITY);
+}
+
+bool OtherViewMessager::shmReady()
+{
+    if (!useShm)
+        return false;
+
+    // The normal instance owns the block; it answers every
+    // handshake, including ones from a restarted OtherView
+    if (!isOtherView) {
+        if (!handshake.ownerPoll())
+            return false;
+
+        if (!sendRing.attached())
+            attachRings();
+
+        return true;
+    }
+
+    const uint32_t now = SDL_GetTicks();
+
+    if (!shm.data()) {
+        if (!shm.open(SHM_NAME, SHM_SIZE))
+            return false;
+
+        handshake.attach(shm.data());
+        shmOpenTicks = now;
+    }
+
+    switch (handshake.peerPoll()) {
+    case ShmHandshake::Linked:
+        if (!sendRing.attached())
+            attachRings();
+        return true;
+
+    case ShmHandshake::Reset:
+        sendRing = ShmRing();
+        recvRing = ShmRing();
+        shmOpenTicks = now;
+        return false;
+
+    case ShmHandshake::Waiting:
+        if (now - shmOpenTicks > SHM_HANDSHAKE_TIMEOUT_MS) {
+            sendRing = ShmRing();
+            recvRing = ShmRing();
+            shm.close();
+        }
+        return false;
+    }
+
+    return false;
 }
 
 OtherViewMessager::~OtherViewMessager()
@@ -41,8 +128,19 @@ OtherViewMessager::~OtherViewMessager()
 
 bool OtherViewMessager::sendMsg(const char* string)
 {
+    return sendMsg(string, strlen(string), 0);
+}
+
+bool OtherViewMessager::sendMsg(const char *data, size_t size, int type)
+{
+    if (shmReady())
+        return sendRing.push(type, data, size);
+
+    // The type goes in a second frame, so peers that only
+    // read the first one still get the payload
     zmqpp::message message;
-    message << string;
+    message << std::string(data, size);
+    message << type;
     bool ret;
     if (isOtherView) {
         ret = otherview_socket->send(message, true);
@@ -53,29 +151,51 @@ bool OtherViewMessager::sendMsg(const char* string)
     return ret;
 }
 
-std::string OtherViewMessager::getMsg()
+bool OtherViewMessager::receive(int &type, std::string &data)
 {
+    // zmq is always read first: the other side sends over it until
+    // the handshake went through (or after a reset), and those
+    // messages come before anything in the ring
     zmqpp::message message;
-    std::string response;
     bool ret;
     if (isOtherView) {
         ret = normal_socket->receive(message, true);
     } else {
         ret = otherview_socket->receive(message, true);
     }
-    if (ret) {
-        message >> response;
-    } else {
+    if (!ret)
+        return shmReady() && recvRing.pop(type, data);
+
+    message >> data;
+    type = 0;
+    if (message.parts() > 1)
+        message >> type;
+    return true;
+}
+
+std::string OtherViewMessager::getMsg()
+{
+    int type;
+    std::string response;
+    if (!receive(type, response))
         response = "";
-    }
     //Debug() << "Received message: ";
     //Debug() << response;
-    //Debug() << ret;
     return response;
 }
 
+void OtherViewMessager::drain(std::vector<Message> &out)
+{
+    Message msg;
+    while (receive(msg.type, msg.data))
+        out.push_back(msg);
+}
+
 void OtherViewMessager::close() 
 {
+    useShm = false;
+    shm.close();
+
     Debug() << "Closing sockets";
     otherview_socket->close();
     normal_socket->close();
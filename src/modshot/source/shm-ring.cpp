@@ -0,0 +1,346 @@
+#include "shm-ring.h"
+#include "debugwriter.h"
+
+#include <SDL2/SDL_timer.h>
+
+#include <string.h>
+
+#ifndef _WIN32
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+// Each record is a size and type word, then the payload padded to 4 bytes
+#define RECORD_HEADER 8
+#define RECORD_ALIGN(size) (((size) + 3) & ~3u)
+
+SharedMemory::SharedMemory()
+	: size(0),
+	  mem(0),
+	  owner(false)
+#ifdef _WIN32
+	  , mapping(NULL)
+#endif
+{
+}
+
+SharedMemory::~SharedMemory()
+{
+	close();
+}
+
+#ifdef _WIN32
+bool SharedMemory::create(const std::string &name_, size_t size_)
+{
+	close();
+
+	std::string path = "Local\\" + name_;
+	mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+	                             0, (DWORD) size_, path.c_str());
+
+	if (!mapping)
+		return false;
+
+	mem = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size_);
+
+	if (!mem) {
+		close();
+		return false;
+	}
+
+	// An existing mapping (left open by a previous run, or still held
+	// by a peer) is left alone; the owner resets it (ShmHandshake)
+
+	name = name_;
+	size = size_;
+	owner = true;
+
+	return true;
+}
+
+bool SharedMemory::open(const std::string &name_, size_t size_)
+{
+	close();
+
+	std::string path = "Local\\" + name_;
+	mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, path.c_str());
+
+	if (!mapping)
+		return false;
+
+	mem = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size_);
+
+	if (!mem) {
+		close();
+		return false;
+	}
+
+	name = name_;
+	size = size_;
+
+	return true;
+}
+
+void SharedMemory::close()
+{
+	if (mem)
+		UnmapViewOfFile(mem);
+
+	if (mapping)
+		CloseHandle(mapping);
+
+	mem = 0;
+	mapping = NULL;
+	owner = false;
+}
+#else
+bool SharedMemory::create(const std::string &name_, size_t size_)
+{
+	close();
+
+	std::string path = "/" + name_;
+	shm_unlink(path.c_str());
+
+	int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+
+	if (fd < 0)
+		return false;
+
+	// Fresh pages read as zero
+	if (ftruncate(fd, size_) != 0) {
+		::close(fd);
+		shm_unlink(path.c_str());
+		return false;
+	}
+
+	void *m = mmap(NULL, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+
+	if (m == MAP_FAILED) {
+		shm_unlink(path.c_str());
+		return false;
+	}
+
+	name = name_;
+	size = size_;
+	mem = m;
+	owner = true;
+
+	return true;
+}
+
+bool SharedMemory::open(const std::string &name_, size_t size_)
+{
+	close();
+
+	std::string path = "/" + name_;
+	int fd = shm_open(path.c_str(), O_RDWR, 0600);
+
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+
+	// Not sized yet by the creator
+	if (fstat(fd, &st) != 0 || (size_t) st.st_size < size_) {
+		::close(fd);
+		return false;
+	}
+
+	void *m = mmap(NULL, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+
+	if (m == MAP_FAILED)
+		return false;
+
+	name = name_;
+	size = size_;
+	mem = m;
+
+	return true;
+}
+
+void SharedMemory::close()
+{
+	if (mem)
+		munmap(mem, size);
+
+	if (owner)
+		shm_unlink(("/" + name).c_str());
+
+	mem = 0;
+	owner = false;
+}
+#endif
+
+ShmRing::ShmRing()
+	: header(0),
+	  ring(0),
+	  capacity(0)
+{
+}
+
+void ShmRing::attach(void *mem, uint32_t capacity_)
+{
+	header = static_cast<Header*>(mem);
+	ring = static_cast<char*>(mem) + HeaderSize;
+	capacity = capacity_;
+}
+
+void ShmRing::write(uint32_t pos, const void *src, uint32_t size)
+{
+	uint32_t off = pos & (capacity - 1);
+	uint32_t first = capacity - off < size ? capacity - off : size;
+
+	memcpy(ring + off, src, first);
+	memcpy(ring, static_cast<const char*>(src) + first, size - first);
+}
+
+void ShmRing::read(uint32_t pos, void *dst, uint32_t size)
+{
+	uint32_t off = pos & (capacity - 1);
+	uint32_t first = capacity - off < size ? capacity - off : size;
+
+	memcpy(dst, ring + off, first);
+	memcpy(static_cast<char*>(dst) + first, ring, size - first);
+}
+
+bool ShmRing::push(int type, const char *data, uint32_t size)
+{
+	if (!header)
+		return false;
+
+	const uint32_t record = RECORD_HEADER + RECORD_ALIGN(size);
+
+	if (record > capacity / 2)
+		return false;
+
+	const uint32_t tail = SDL_AtomicGet(&header->tail);
+	const uint32_t head = SDL_AtomicGet(&header->head);
+
+	if (capacity - (tail - head) < record)
+		return false;
+
+	int32_t words[2] = { (int32_t) size, (int32_t) type };
+	write(tail, words, RECORD_HEADER);
+	write(tail + RECORD_HEADER, data, size);
+
+	// Publish the whole record at once
+	SDL_AtomicSet(&header->tail, tail + record);
+
+	return true;
+}
+
+bool ShmRing::pop(int &type, std::string &data)
+{
+	if (!header)
+		return false;
+
+	const uint32_t head = SDL_AtomicGet(&header->head);
+	const uint32_t tail = SDL_AtomicGet(&header->tail);
+
+	if (head == tail)
+		return false;
+
+	int32_t words[2];
+	read(head, words, RECORD_HEADER);
+
+	const uint32_t size = words[0];
+
+	// Garbage from a peer that went away mid-write; drop everything
+	if (RECORD_HEADER + RECORD_ALIGN(size) > tail - head) {
+		Debug() << "OtherView: corrupt shared memory message, resetting";
+		SDL_AtomicSet(&header->head, tail);
+		return false;
+	}
+
+	type = words[1];
+	data.resize(size);
+
+	if (size > 0)
+		read(head + RECORD_HEADER, &data[0], size);
+
+	SDL_AtomicSet(&header->head, head + RECORD_HEADER + RECORD_ALIGN(size));
+
+	return true;
+}
+
+#define HANDSHAKE_MAGIC 0x4d4b5852 // "MKXR"
+
+ShmHandshake::ShmHandshake()
+	: control(0),
+	  generation(0),
+	  nonce(0)
+{
+}
+
+void ShmHandshake::reset(void *block, size_t size)
+{
+	control = static_cast<Control*>(block);
+
+	// Take the block out of service first, so attached
+	// peers let go before anything is cleared
+	SDL_AtomicSet(&control->magic, 0);
+
+	const int previous = SDL_AtomicGet(&control->generation);
+
+	memset(static_cast<char*>(block) + sizeof(Control), 0, size - sizeof(Control));
+	SDL_AtomicSet(&control->peerNonce, 0);
+	SDL_AtomicSet(&control->ownerAck, 0);
+
+	generation = previous + 1 != 0 ? previous + 1 : 1;
+	SDL_AtomicSet(&control->generation, generation);
+	SDL_AtomicSet(&control->magic, HANDSHAKE_MAGIC);
+}
+
+bool ShmHandshake::ownerPoll()
+{
+	if (!control)
+		return false;
+
+	const int peer = SDL_AtomicGet(&control->peerNonce);
+
+	if (peer != 0 && SDL_AtomicGet(&control->ownerAck) != peer)
+		SDL_AtomicSet(&control->ownerAck, peer);
+
+	return peer != 0;
+}
+
+void ShmHandshake::attach(void *block)
+{
+	control = static_cast<Control*>(block);
+	generation = 0;
+	nonce = 0;
+}
+
+ShmHandshake::PeerState ShmHandshake::peerPoll()
+{
+	if (!control)
+		return Waiting;
+
+	if (SDL_AtomicGet(&control->magic) != HANDSHAKE_MAGIC) {
+		// Being reset; announce again once that's done
+		const bool wasAnnounced = nonce != 0;
+		nonce = 0;
+		return wasAnnounced ? Reset : Waiting;
+	}
+
+	const int current = SDL_AtomicGet(&control->generation);
+
+	if (nonce == 0) {
+		// Any nonzero value that differs between attempts will do
+		nonce = (int) (SDL_GetPerformanceCounter() | 1);
+		generation = current;
+		SDL_AtomicSet(&control->peerNonce, nonce);
+		return Waiting;
+	}
+
+	if (current != generation) {
+		nonce = 0;
+		return Reset;
+	}
+
+	return SDL_AtomicGet(&control->ownerAck) == nonce ? Linked : Waiting;
+}
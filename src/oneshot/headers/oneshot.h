@@ -72,14 +72,19 @@ public:
 	bool msgbox(int type, const char *body, const char *title);
 	std::string textinput(const char* prompt, int char_limit, const char* fontName);
 
-	//Dirty flag for obscured texture
+	//Dirty flag for obscured texture, and the
+	//range of rows [top, bottom) that changed
 	bool obscuredDirty;
+	int obscuredDirtyTop;
+	int obscuredDirtyBottom;
 
 #ifdef __linux__
 	std::string desktopEnv;
 #endif
 
 private:
+	void markObscuredDirty(int top, int bottom);
+
 	OneshotPrivate *p;
 	RGSSThreadData &threadData;
 };
@@ -5,11 +5,21 @@
 #include <windows.h>
 #else
 #include <fcntl.h>
+#include <poll.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 #endif
 
+#include <string>
+#include <vector>
+#include <string.h>
+#include <stdint.h>
+
+/* Messages are sent as a 32 bit length (host order,
+ * both ends run on the same machine) plus payload */
+#define PIPE_MAX_MESSAGE (1 << 16)
+
 class Pipe
 {
 public:
@@ -19,6 +29,8 @@ public:
 	} Mode;
 
 	Pipe()
+	    : received(false),
+	      eof(false)
 	{
 #ifdef _WIN32
 		handle = NULL;
@@ -28,6 +40,8 @@ public:
 	}
 
 	Pipe(const char *name_, Mode mode_)
+	    : received(false),
+	      eof(false)
 	{
 		open(name_, mode_);
 	}
@@ -99,23 +113,73 @@ public:
 #endif
 	}
 
-	bool read(char *buf)
-	{
-#ifdef _WIN32
-	OVERLAPPED overlapped;
-	memset(&overlapped, 0, sizeof(overlapped));
-	if (!ReadFile(handle, buf, 1, NULL, &overlapped))
+	/* Pulls in whatever is available without blocking, and
+	 * returns the next complete message, if there is one */
+	bool readMessage(std::string &msg)
 	{
-		if (GetLastError() == ERROR_IO_PENDING)
-			CancelIo(handle);
-		return false;
+		if (takeMessage(msg))
+			return true;
+
+		fill();
+
+		return takeMessage(msg);
 	}
-	return true;
+
+	/* Blocks until there is something to read (or the
+	 * writer went away), or 'timeoutMs' passed. A negative
+	 * timeout waits indefinitely */
+	bool wait(int timeoutMs)
+	{
+		if (hasMessage())
+			return true;
+
+#ifdef _WIN32
+		DWORD start = GetTickCount();
+
+		for (;;)
+		{
+			DWORD avail = 0;
+
+			if (!PeekNamedPipe(handle, NULL, 0, NULL, &avail, NULL) || avail > 0)
+				return true;
+
+			if (timeoutMs >= 0 && GetTickCount() - start >= (DWORD) timeoutMs)
+				return false;
+
+			Sleep(1);
+		}
 #else
-	return ::read(fd, buf, 1) == 1;
+		pollfd pfd;
+		pfd.fd = fd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+
+		return ::poll(&pfd, 1, timeoutMs) > 0;
 #endif
 	}
 
+	/* The writing end closed the pipe */
+	bool closed() const
+	{
+		return eof;
+	}
+
+	void writeMessage(const char *data, uint32_t size)
+	{
+		/* One write, so a message never arrives half done
+		 * as long as it fits the pipe buffer */
+		std::vector<char> frame(sizeof(size) + size);
+		memcpy(&frame[0], &size, sizeof(size));
+		memcpy(&frame[sizeof(size)], data, size);
+
+		write(&frame[0], frame.size());
+	}
+
+	void writeMessage(const std::string &msg)
+	{
+		writeMessage(msg.c_str(), msg.size());
+	}
+
 	void write(const char *buf, size_t size)
 	{
 #ifdef _WIN32
@@ -135,9 +199,101 @@ public:
 	}
 
 private:
+	bool hasMessage() const
+	{
+		uint32_t size;
+
+		if (inBuf.size() < sizeof(size))
+			return false;
+
+		memcpy(&size, &inBuf[0], sizeof(size));
+
+		return inBuf.size() >= sizeof(size) + size;
+	}
+
+	bool takeMessage(std::string &msg)
+	{
+		if (!hasMessage())
+			return false;
+
+		uint32_t size;
+		memcpy(&size, &inBuf[0], sizeof(size));
+
+		msg.assign(&inBuf[sizeof(size)], size);
+		inBuf.erase(inBuf.begin(), inBuf.begin() + sizeof(size) + size);
+
+		return true;
+	}
+
+	void fill()
+	{
+		char chunk[4096];
+
+		for (;;)
+		{
+#ifdef _WIN32
+			DWORD avail = 0;
+
+			if (!PeekNamedPipe(handle, NULL, 0, NULL, &avail, NULL))
+			{
+				eof = true;
+				return;
+			}
+
+			if (avail == 0)
+				return;
+
+			OVERLAPPED overlapped;
+			memset(&overlapped, 0, sizeof(overlapped));
+
+			DWORD got = 0;
+			DWORD toRead = avail < sizeof(chunk) ? avail : sizeof(chunk);
+
+			if (!ReadFile(handle, chunk, toRead, NULL, &overlapped)
+			&&  GetLastError() != ERROR_IO_PENDING)
+				return;
+
+			if (!GetOverlappedResult(handle, &overlapped, &got, TRUE) || got == 0)
+				return;
+#else
+			ssize_t got = ::read(fd, chunk, sizeof(chunk));
+
+			/* A FIFO nobody opened for writing yet reads
+			 * as empty too; only count it once connected */
+			if (got == 0 && received)
+				eof = true;
+
+			if (got <= 0)
+				return;
+#endif
+
+			inBuf.insert(inBuf.end(), chunk, chunk + got);
+			received = true;
+
+			/* A bogus length would have us buffer forever */
+			uint32_t size;
+
+			if (inBuf.size() < sizeof(size))
+				continue;
+
+			memcpy(&size, &inBuf[0], sizeof(size));
+
+			if (size > PIPE_MAX_MESSAGE)
+			{
+				inBuf.clear();
+				return;
+			}
+		}
+	}
+
 	std::string name;
 	std::string filename;
 	Mode mode;
+
+	/* Received bytes not yet returned as messages */
+	std::vector<char> inBuf;
+	bool received;
+	bool eof;
 #ifdef _WIN32
 	HANDLE handle;
 #else
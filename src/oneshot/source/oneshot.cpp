@@ -13,6 +13,11 @@
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_ttf.h>
 
+#include <pixman.h>
+
+#include <algorithm>
+#include <string.h>
+
 // OS-Specific code
 #if defined _WIN32
 	#define OS_W32
@@ -72,7 +77,8 @@ struct OneshotPrivate
 	SDL_mutex *winMutex;
 	bool winPosChanged;
 	std::vector<uint8_t> obscuredMap;
-	bool obscuredCleared;
+	// Pixels in obscuredMap that were never obscured yet
+	int obscuredRemaining;
 
 	OneshotPrivate()
 		: window(0),
@@ -181,7 +187,10 @@ Oneshot::Oneshot(RGSSThreadData &threadData) :
 	p->window = threadData.window;
 	p->savePath = threadData.config.commonDataPath.substr(0, threadData.config.commonDataPath.size() - 1);
 	p->obscuredMap.resize(640 * 480, 255);
+	p->obscuredRemaining = 640 * 480;
 	obscuredDirty = true;
+	obscuredDirtyTop = 0;
+	obscuredDirtyBottom = 480;
 	p->winX = 0;
 	p->winY = 0;
 	p->winPosChanged = false;
@@ -333,11 +342,6 @@ void Oneshot::update()
 	{
 		p->winPosChanged = false;
 
-		//Map of unobscured pixels in this frame
-		static std::vector<bool> obscuredFrame;
-		obscuredFrame.resize(p->obscuredMap.size());
-		std::fill(obscuredFrame.begin(), obscuredFrame.end(), true);
-
 		SDL_Rect screenRect;
 		SDL_LockMutex(p->winMutex);
 		screenRect.x = p->winX;
@@ -346,6 +350,11 @@ void Oneshot::update()
 		screenRect.w = 640;
 		screenRect.h = 480;
 
+		//Window area that is offscreen in this frame; starts out as
+		//the whole window, and has every display's area cut out of it
+		pixman_region16_t obscuredFrame;
+		pixman_region_init_rect(&obscuredFrame, 0, 0, 640, 480);
+
 		//Update obscured map and texture for window portion offscreen
 		for (int i = 0, max = SDL_GetNumVideoDisplays(); i < max; ++i)
 		{
@@ -362,36 +371,61 @@ void Oneshot::update()
 			//If it's entirely within the bounds of the screen, we don't need to check out
 			//any other monitors
 			if (intersect.x == 0 && intersect.y == 0 && intersect.w == 640 && intersect.h == 480)
-				return;
-
-			for (int y = intersect.y; y < intersect.y + intersect.h; ++y)
 			{
-				int start = y * 640 + intersect.x;
-				std::fill(obscuredFrame.begin() + start, obscuredFrame.begin() + (start + intersect.w), false);
+				pixman_region_fini(&obscuredFrame);
+				return;
 			}
+
+			pixman_region16_t onscreen;
+			pixman_region_init_rect(&onscreen, intersect.x, intersect.y, intersect.w, intersect.h);
+			pixman_region_subtract(&obscuredFrame, &obscuredFrame, &onscreen);
+			pixman_region_fini(&onscreen);
 		}
 
-		//Update the obscured map, and return prematurely if we don't have any changes
-		//to make to the texture
-		bool needsUpdate = false;
-		bool cleared = true;
-		for (size_t i = 0; i < obscuredFrame.size(); ++i)
+		//Clear the obscured rows in the map, only touching the texture
+		//for rows that actually had pixels revealed
+		int nRects;
+		const pixman_box16_t *rects = pixman_region_rectangles(&obscuredFrame, &nRects);
+
+		for (int i = 0; i < nRects; ++i)
 		{
-			if (obscuredFrame[i])
+			const pixman_box16_t &box = rects[i];
+
+			for (int y = box.y1; y < box.y2; ++y)
 			{
-				p->obscuredMap[i] = 0;
-				needsUpdate = true;
+				uint8_t *row = &p->obscuredMap[y * 640];
+
+				//Both of these vectorize; rows that were
+				//cleared before are skipped without writing
+				int fresh = std::count(row + box.x1, row + box.x2, 255);
+
+				if (fresh == 0)
+					continue;
+
+				memset(row + box.x1, 0, box.x2 - box.x1);
+				p->obscuredRemaining -= fresh;
+
+				markObscuredDirty(y, y + 1);
 			}
-			if (p->obscuredMap[i] == 255)
-				cleared = false;
 		}
-		p->obscuredCleared = cleared;
-		if (!needsUpdate)
-			return;
 
-		//Flag as dirty
+		pixman_region_fini(&obscuredFrame);
+	}
+}
+
+void Oneshot::markObscuredDirty(int top, int bottom)
+{
+	if (!obscuredDirty)
+	{
+		obscuredDirtyTop = top;
+		obscuredDirtyBottom = bottom;
 		obscuredDirty = true;
+
+		return;
 	}
+
+	obscuredDirtyTop = std::min(obscuredDirtyTop, top);
+	obscuredDirtyBottom = std::max(obscuredDirtyBottom, bottom);
 }
 
 const std::string &Oneshot::os() const
@@ -436,7 +470,7 @@ const std::vector<uint8_t> &Oneshot::obscuredMap() const
 
 bool Oneshot::obscuredCleared() const
 {
-	return p->obscuredCleared;
+	return p->obscuredRemaining == 0;
 }
 
 bool Oneshot::exiting() const
@@ -618,6 +652,6 @@ void Oneshot::setWindowPos(int x, int y)
 void Oneshot::resetObscured()
 {
 	std::fill(p->obscuredMap.begin(), p->obscuredMap.end(), 255);
-	obscuredDirty = true;
-	p->obscuredCleared = false;
+	p->obscuredRemaining = 640 * 480;
+	markObscuredDirty(0, 480);
 }
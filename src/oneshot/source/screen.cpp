@@ -2,36 +2,117 @@
 #include <SDL2/SDL_shape.h>
 #include <SDL2/SDL_image.h>
 
-#define FPS 60
 #define DEFAULT_WIDTH 320
 #define DEFAULT_HEIGHT 240
 
+/* Decoded shapes kept around for switching back and forth */
+#define SHAPE_CACHE_SIZE 16
+
+/* How often the reader thread checks whether it should quit */
+#define READER_POLL_MS 100
+
 #include "config.h"
 #include "debugwriter.h"
 #include "pipe.h"
 #include "sharedstate.h"
 
+#include <map>
+
 static void showInitError(const std::string &msg)
 {
 	Debug() << msg;
 	SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "OneShot", msg.c_str(), 0);
 }
 
-static bool readMessage(Pipe &ipc, char *buf, size_t size)
+static Uint32 messageEvent;
+static SDL_atomic_t readerQuit;
+
+/* Forwards pipe messages into the SDL event queue, so the
+ * main loop can sleep until either has something for it.
+ * Joined before the pipe goes out of scope */
+static int readerThread(void *data)
 {
-	size_t index = 0;
-	while (index < size - 1) {
-		if (ipc.read(buf + index)) {
-			++index;
-		} else {
-			break;
+	Pipe &ipc = *static_cast<Pipe*>(data);
+	std::string msg;
+
+	while (!SDL_AtomicGet(&readerQuit))
+	{
+		bool ready = ipc.wait(READER_POLL_MS);
+		bool any = false;
+
+		while (ipc.readMessage(msg))
+		{
+			SDL_Event e;
+			SDL_zero(e);
+			e.type = messageEvent;
+			e.user.data1 = new std::string(msg);
+			SDL_PushEvent(&e);
+
+			any = true;
+
+			if (msg == "END")
+				return 0;
+		}
+
+		if (ipc.closed())
+		{
+			SDL_Event e;
+			SDL_zero(e);
+			e.type = messageEvent;
+			e.user.data1 = new std::string("END");
+			SDL_PushEvent(&e);
+
+			return 0;
 		}
+
+		/* Nothing connected to the pipe yet */
+		if (ready && !any)
+			SDL_Delay(10);
 	}
-	buf[index] = 0;
 
-	return index > 0;
+	return 0;
 }
 
+struct ShapeCache
+{
+	std::map<std::string, SDL_Surface*> shapes;
+
+	~ShapeCache()
+	{
+		clear();
+	}
+
+	SDL_Surface *get(const std::string &path)
+	{
+		std::map<std::string, SDL_Surface*>::iterator iter = shapes.find(path);
+
+		if (iter != shapes.end())
+			return iter->second;
+
+		SDL_Surface *surf = IMG_Load(path.c_str());
+
+		if (!surf)
+			return 0;
+
+		if (shapes.size() >= SHAPE_CACHE_SIZE)
+			clear();
+
+		shapes[path] = surf;
+
+		return surf;
+	}
+
+	void clear()
+	{
+		std::map<std::string, SDL_Surface*>::iterator iter;
+
+		for (iter = shapes.begin(); iter != shapes.end(); ++iter)
+			SDL_FreeSurface(iter->second);
+
+		shapes.clear();
+	}
+};
+
 int screenMain(Config &conf)
 {
 	const SDL_Color colorKey = {0x00, 0xFF, 0x00, 0xFF};
@@ -63,50 +144,76 @@ int screenMain(Config &conf)
 	shapeMode.mode = ShapeModeColorKey;
 	shapeMode.parameters.colorKey = colorKey;
 
-	SDL_Surface *shape = SDL_CreateRGBSurface(0, DEFAULT_WIDTH, DEFAULT_HEIGHT, 8, 0, 0, 0, 0);
-	SDL_SetPaletteColors(shape->format->palette, &black, 0, 1);
+	SDL_Surface *blank = SDL_CreateRGBSurface(0, DEFAULT_WIDTH, DEFAULT_HEIGHT, 8, 0, 0, 0, 0);
+	SDL_SetPaletteColors(blank->format->palette, &black, 0, 1);
 
-	char messageBuf[256];
+	SDL_Surface *shape = blank;
+	ShapeCache cache;
 
 	std::string filePath =  "./Graphics/Journal/";
 
-	unsigned int ticks = SDL_GetTicks();
-	for (;;) {
-		// Handle events
-		SDL_Event e;
-		while (SDL_PollEvent(&e)) {
-			switch (e.type) {
-			case SDL_QUIT:
-				return 0;
-			}
+	messageEvent = SDL_RegisterEvents(1);
+	SDL_AtomicSet(&readerQuit, 0);
+	SDL_Thread *reader = SDL_CreateThread(readerThread, "screenipc", &ipc);
+
+	bool running = true;
+	bool dirty = true;
+
+	while (running) {
+		// Redraw, only if something changed
+		if (dirty) {
+			SDL_BlitSurface(shape, NULL, SDL_GetWindowSurface(win), NULL);
+			SDL_UpdateWindowSurface(win);
+			dirty = false;
 		}
 
-		// Change shape
-		if (readMessage(ipc, messageBuf, sizeof(messageBuf))) {
-			if (strcmp(messageBuf, "END") == 0)
-				break;
-			std::string imgname = filePath + messageBuf + ".png";
-			SDL_FreeSurface(shape);
-			if ((shape = IMG_Load(imgname.c_str())) == NULL) {
-				std::string error = "Unable to find image ";
-				SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "OneShot", (error + imgname).c_str(), 0);
-				break;
+		SDL_Event e;
+		if (!SDL_WaitEvent(&e))
+			continue;
+
+		do {
+			if (e.type == SDL_QUIT) {
+				running = false;
+			} else if (e.type == SDL_WINDOWEVENT) {
+				if (e.window.event == SDL_WINDOWEVENT_EXPOSED)
+					dirty = true;
+			} else if (e.type == messageEvent) {
+				std::string *msg = static_cast<std::string*>(e.user.data1);
+
+				// Change shape
+				if (*msg == "END") {
+					running = false;
+				} else if (running) {
+					std::string imgname = filePath + *msg + ".png";
+					SDL_Surface *next = cache.get(imgname);
+
+					if (!next) {
+						std::string error = "Unable to find image ";
+						SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "OneShot", (error + imgname).c_str(), 0);
+						running = false;
+					} else if (next != shape) {
+						shape = next;
+						SDL_SetWindowSize(win, shape->w, shape->h);
+						SDL_SetWindowShape(win, shape, &shapeMode);
+						dirty = true;
+					}
+				}
+
+				delete msg;
 			}
-			SDL_SetWindowSize(win, shape->w, shape->h);
-			SDL_SetWindowShape(win, shape, &shapeMode);
-		}
+		} while (SDL_PollEvent(&e));
+	}
 
-		// Redraw
-		SDL_BlitSurface(shape, NULL, SDL_GetWindowSurface(win), NULL);
-		SDL_UpdateWindowSurface(win);
+	/* The reader uses 'ipc', which lives on our stack */
+	SDL_AtomicSet(&readerQuit, 1);
+	SDL_WaitThread(reader, 0);
 
-		// Regulate framerate
-	    unsigned int ticksDelta = SDL_GetTicks() - ticks;
-	    if (ticksDelta < 1000 / FPS)
-	        SDL_Delay(1000 / FPS - ticksDelta);
-	    ticks = SDL_GetTicks();
-	}
+	/* Messages that arrived after we stopped listening */
+	SDL_Event e;
+	while (SDL_PollEvent(&e))
+		if (e.type == messageEvent)
+			delete static_cast<std::string*>(e.user.data1);
 
-	SDL_FreeSurface(shape);
+	SDL_FreeSurface(blank);
 	return 0;
 }
@@ -47,8 +47,16 @@ struct VAO
 	VBO::ID vbo;
 	IBO::ID ibo;
 
+	/* Where in 'vbo' the vertices start */
+	GLintptr vboOffset;
+
 	/* Don't touch */
 	GLuint nativeVAO;
+
+	VAO()
+	    : attr(0), attrCount(0), vertSize(0),
+	      vboOffset(0), nativeVAO(0)
+	{}
 };
 
 template<class VertexType>
@@ -64,6 +72,9 @@ void vaoFini(VAO &vao);
 void vaoBind(VAO &vao);
 void vaoUnbind(VAO &vao);
 
+/* Points an initialized VAO at different vertex storage */
+void vaoSetSource(VAO &vao, VBO::ID vbo, GLintptr offset);
+
 /* EXT_framebuffer_blit */
 void blitBegin(TEXFBO &target);
 void blitBeginScreen(const Vec2i &size);
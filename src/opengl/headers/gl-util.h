@@ -23,6 +23,7 @@
 #define GLUTIL_H
 
 #include "gl-fun.h"
+#include "glstate.h"
 #include "etc-internal.h"
 
 /* Struct wrapping GLuint for some light type safety */
@@ -63,12 +64,13 @@ namespace TEX
 
 	static inline void del(ID id)
 	{
+		GLState::forgetTexture(id.gl);
 		gl.DeleteTextures(1, &id.gl);
 	}
 
 	static inline void bind(ID id)
 	{
-		gl.BindTexture(GL_TEXTURE_2D, id.gl);
+		GLState::bindTexture(id.gl);
 	}
 
 	static inline void unbind()
@@ -76,19 +78,28 @@ namespace TEX
 		bind(ID(0));
 	}
 
+	static inline void countUpload(GLsizei width, GLsizei height, GLenum format)
+	{
+		++glCallStats.texUploads;
+		glCallStats.uploadBytes += width * height * (format == GL_LUMINANCE ? 1 : 4);
+	}
+
 	static inline void uploadImage(GLsizei width, GLsizei height, const void *data, GLenum format)
 	{
 		gl.TexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+		countUpload(width, height, format);
 	}
 
 	static inline void uploadSubImage(GLint x, GLint y, GLsizei width, GLsizei height, const void *data, GLenum format)
 	{
 		gl.TexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format, GL_UNSIGNED_BYTE, data);
+		countUpload(width, height, format);
 	}
 
 	static inline void allocEmpty(GLsizei width, GLsizei height)
 	{
 		gl.TexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+		++glCallStats.texAllocs;
 	}
 
 	static inline void setRepeat(bool mode)
@@ -174,11 +185,19 @@ struct GenericBO
 	static inline void uploadData(GLsizeiptr size, const GLvoid *data, GLenum usage = GL_STATIC_DRAW)
 	{
 		gl.BufferData(target, size, data, usage);
+		countUpload(data ? size : 0);
 	}
 
 	static inline void uploadSubData(GLintptr offset, GLsizeiptr size, const GLvoid *data)
 	{
 		gl.BufferSubData(target, offset, size, data);
+		countUpload(size);
+	}
+
+	static inline void countUpload(GLsizeiptr size)
+	{
+		++glCallStats.bufUploads;
+		glCallStats.bufBytes += size;
 	}
 
 	static inline void allocEmpty(GLsizeiptr size, GLenum usage = GL_STATIC_DRAW)
@@ -29,6 +29,36 @@
 
 struct Config;
 
+/* GL calls (state changes, uniform uploads) actually sent to
+ * the driver vs. skipped because the value was already current */
+struct GLCallStats
+{
+	unsigned int issued;
+	unsigned int elided;
+
+	/* Draw calls and texture data sent */
+	unsigned int draws;
+	unsigned int texUploads;
+	unsigned int uploadBytes;
+
+	/* Texture storage (re)allocated */
+	unsigned int texAllocs;
+
+	/* Buffer object data sent, and how many GL
+	 * calls it took */
+	unsigned int bufUploads;
+	unsigned int bufBytes;
+
+	GLCallStats()
+	    : issued(0), elided(0),
+	      draws(0), texUploads(0), uploadBytes(0), texAllocs(0),
+	      bufUploads(0), bufBytes(0)
+	{}
+};
+
+/* Running tally for the frame in progress */
+extern GLCallStats glCallStats;
+
 template<typename T>
 struct GLProperty
 {
@@ -49,8 +79,12 @@ struct GLProperty
 	void set(const T &value)
 	{
 		if (value == current)
+		{
+			++glCallStats.elided;
 			return;
+		}
 
+		++glCallStats.issued;
 		init(value);
 	}
 
@@ -133,6 +167,20 @@ public:
 	} caps;
 
 	GLState(const Config &conf);
+
+	/* GL_TEXTURE_2D binding per texture unit. These are static
+	 * as textures are already created (and bound) while
+	 * SharedState is still being constructed */
+	static void bindTexture(unsigned int tex /* GLuint */);
+	static void activeTexture(unsigned int unit);
+
+	/* Must be called when 'tex' is deleted, as GL will
+	 * hand out the same name again */
+	static void forgetTexture(unsigned int tex);
+
+	/* Counters of the last completed frame */
+	static const GLCallStats &frameStats();
+	static void endFrame();
 };
 
 #endif // GLSTATE_H
@@ -0,0 +1,117 @@
+/*
+** megatexture.h
+**
+** This file is part of mkxp.
+**
+** Copyright (C) 2013 Jonas Kulla <Nyocurio@gmail.com>
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef MEGATEXTURE_H
+#define MEGATEXTURE_H
+
+#include "gl-util.h"
+#include "etc-internal.h"
+
+#include <list>
+#include <vector>
+
+struct SDL_Surface;
+class ShaderBase;
+
+/* Image too large for a single texture, split into a grid of
+ * texture pages. Pages are uploaded on first use and share one
+ * global LRU budget ("megaTexBudget") across all MegaTextures.
+ *
+ * If the whole image fits into the budget on creation, every
+ * page is uploaded right away and the CPU copy is dropped;
+ * otherwise the surface is kept around to page from.
+ *
+ * The image is immutable once created */
+class MegaTexture
+{
+public:
+	/* Takes ownership of 'surface' (ABGR8888) */
+	MegaTexture(SDL_Surface *surface);
+	~MegaTexture();
+
+	int width() const { return w; }
+	int height() const { return h; }
+
+	/* Copy (and scale) 'src' of the image into 'dst' of 'target' */
+	void blit(TEXFBO &target, const IntRect &src, const IntRect &dst);
+
+	/* A "view" is a texture holding all of 'rect': either the page
+	 * containing it, or a copy assembled from several pages.
+	 * viewRect() gives the image area that texture covers, for
+	 * offsetting tex coords. Views are clamped to the maximum
+	 * texture size.
+	 *
+	 * Assembling binds framebuffers, so it has to happen in
+	 * prepareView() ahead of drawing; bindView() then only binds
+	 * the texture and sets the shader's texture size */
+	IntRect viewRect(const IntRect &rect) const;
+	void prepareView(const IntRect &rect);
+	void bindView(ShaderBase &shader, const IntRect &rect);
+
+private:
+	struct Page
+	{
+		IntRect rect;
+		TEXFBO gl;
+		bool resident;
+		std::list<Page*>::iterator lruIter;
+	};
+
+	struct View
+	{
+		IntRect rect;
+		TEXFBO gl;
+		unsigned int lastUse;
+	};
+
+	int pageIndex(int x, int y) const;
+	/* Page fully containing 'rect', or -1 */
+	int pageFor(const IntRect &rect) const;
+	Page &page(int index);
+
+	void upload(Page &pg);
+	void evict(Page &pg);
+	static void makeRoom(size_t bytes);
+
+	View *findView(const IntRect &rect);
+	IntRect clampedView(const IntRect &rect) const;
+
+	SDL_Surface *surface;
+	int w, h;
+	int pageSize;
+	int pagesX, pagesY;
+	std::vector<Page> pages;
+
+	/* All pages uploaded and never evicted */
+	bool pinned;
+
+	std::vector<View> views;
+	unsigned int viewCounter;
+
+	/* Resident pages of non-pinned textures,
+	 * least recently used first */
+	static std::list<Page*> lru;
+	static size_t residentBytes;
+	static size_t pinnedBytes;
+};
+
+#endif // MEGATEXTURE_H
@@ -136,6 +136,7 @@ struct Quad
 
 		GLMeta::vaoBind(vao);
 		gl.DrawElements(GL_TRIANGLES, 6, _GL_INDEX_TYPE, 0);
+		++glCallStats.draws;
 		GLMeta::vaoUnbind(vao);
 	}
 };
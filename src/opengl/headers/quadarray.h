@@ -27,6 +27,7 @@
 #include "gl-meta.h"
 #include "sharedstate.h"
 #include "global-ibo.h"
+#include "vertex-stream.h"
 #include "shader.h"
 
 #include <vector>
@@ -43,9 +44,19 @@ struct QuadArray
 	size_t quadCount;
 	GLsizeiptr vboSize;
 
+	/* Data committed on consecutive frames is streamed
+	 * through the shared ring instead of 'vbo' */
+	bool streamed;
+	VertexStream::Alloc streamAlloc;
+	bool committed;
+	uint32_t lastCommit;
+
 	QuadArray()
 	    : quadCount(0),
-	      vboSize(-1)
+	      vboSize(-1),
+	      streamed(false),
+	      committed(false),
+	      lastCommit(0)
 	{
 		vbo = VBO::gen();
 
@@ -78,18 +89,42 @@ struct QuadArray
 	 * and previous to the first 'draw()' call. */
 	void commit()
 	{
-		VBO::bind(vbo);
+		VertexStream &stream = shState->vertexStream();
 
 		GLsizeiptr size = vertices.size() * sizeof(VertexType);
 
+		const uint32_t frame = stream.frame();
+		const bool dynamic = committed && (frame - lastCommit <= 1);
+		committed = true;
+		lastCommit = frame;
+
+		shState->ensureQuadIBO(quadCount);
+
+		if (dynamic && stream.fits(size)
+		&&  stream.write(dataPtr(vertices), size, streamAlloc))
+		{
+			streamed = true;
+			GLMeta::vaoSetSource(vao, stream.vbo, streamAlloc.offset);
+		}
+		else
+		{
+			uploadOwn(size);
+		}
+	}
+
+	void uploadOwn(GLsizeiptr size)
+	{
+		streamed = false;
+		GLMeta::vaoSetSource(vao, vbo, 0);
+
+		VBO::bind(vbo);
+
 		if (size > vboSize)
 		{
 			/* New data exceeds already allocated size.
 			 * Reallocate VBO. */
 			VBO::uploadData(size, dataPtr(vertices), GL_DYNAMIC_DRAW);
 			vboSize = size;
-
-			shState->ensureQuadIBO(quadCount);
 		}
 		else
 		{
@@ -102,10 +137,17 @@ struct QuadArray
 
 	void draw(size_t offset, size_t count)
 	{
+		/* Streamed data only lasts for the frame it was
+		 * written in; if it's still being drawn after that
+		 * without changing, it's better off in our own VBO */
+		if (streamed && !shState->vertexStream().valid(streamAlloc))
+			uploadOwn(vertices.size() * sizeof(VertexType));
+
 		GLMeta::vaoBind(vao);
 
 		const char *_offset = (const char*) 0 + offset * 6 * sizeof(index_t);
 		gl.DrawElements(GL_TRIANGLES, count * 6, _GL_INDEX_TYPE, _offset);
+		++glCallStats.draws;
 
 		GLMeta::vaoUnbind(vao);
 	}
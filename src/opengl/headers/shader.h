@@ -26,6 +26,10 @@
 #include "gl-util.h"
 #include "glstate.h"
 
+#include <stdint.h>
+#include <string>
+#include <vector>
+
 class Shader
 {
 public:
@@ -39,6 +43,14 @@ public:
 		Color = 2
 	};
 
+	/* Where linked program binaries are persisted between runs.
+	 * Empty (the default) disables the cache */
+	static void setBinaryCachePath(const std::string &path);
+
+	/* Writes out binaries linked since the last flush, if any.
+	 * Called at shutdown and between scenes */
+	static void flushBinaryCache();
+
 protected:
 	Shader();
 	~Shader();
@@ -50,12 +62,41 @@ protected:
 	void initFromFile(const char *vertFile, const char *fragFile,
 	                  const char *programName);
 
-	static void setVec4Uniform(GLint location, const Vec4 &vec);
-	static void setVec2Uniform(GLint location, const Vec2i &vec);
-	static void setTexUniform(GLint location, unsigned unitIndex, TEX::ID texture);
+private:
+	void compile(const unsigned char *vert, int vertSize,
+	             const unsigned char *frag, int fragSize,
+	             const char *vertName, const char *fragName,
+	             const char *programName);
+	bool initFromBinary(const char *programName, uint64_t key);
+	static void logInitTime(const char *programName, uint64_t startTicks, bool cached);
+
+protected:
+
+	/* Uniform setters skip the upload if the program already
+	 * holds the value (uniforms are per-program state) */
+	void setFloatUniform(GLint location, float value);
+	void setIntUniform(GLint location, int value);
+	void setVec2fUniform(GLint location, float x, float y);
+	void setVec4Uniform(GLint location, const Vec4 &vec);
+	void setVec2Uniform(GLint location, const Vec2i &vec);
+	void setMat4Uniform(GLint location, const float value[16]);
+	void setTexUniform(GLint location, unsigned unitIndex, TEX::ID texture);
 
 	GLuint vertShader, fragShader;
 	GLuint program;
+
+private:
+	struct UniformShadow
+	{
+		GLint location;
+		int size;
+		float value[16];
+	};
+
+	/* Returns false if 'location' already holds 'value' */
+	bool updateShadow(GLint location, const float *value, int size);
+
+	std::vector<UniformShadow> uniformShadows;
 };
 
 class ShaderBase : public Shader
@@ -184,9 +225,11 @@ public:
 	void setOpacity(float value);
 	void setBushDepth(float value);
 	void setBushOpacity(float value);
+	void setHueAdjust(float value);
 
 private:
 	GLint u_spriteMat, u_tone, u_opacity, u_color, u_bushDepth, u_bushOpacity;
+	GLint u_hueAdjust;
 };
 
 class PlaneShader : public ShaderBase
@@ -198,9 +241,22 @@ public:
 	void setColor(const Vec4 &value);
 	void setFlash(const Vec4 &value);
 	void setOpacity(float value);
+	void setSrcRect(const Vec4 &value);
+
+private:
+	GLint u_tone, u_color, u_flash, u_opacity, u_srcRect;
+};
+
+class ParticleShader : public ShaderBase
+{
+public:
+	ParticleShader();
+
+	void setTone(const Vec4 &value);
+	void setColor(const Vec4 &value);
 
 private:
-	GLint u_tone, u_color, u_flash, u_opacity;
+	GLint u_tone, u_color;
 };
 
 class GrayShader : public ShaderBase
@@ -311,9 +367,10 @@ public:
 	ObscuredShader();
 
 	void setObscured(const TEX::ID value);
+	void setHueAdjust(float value);
 
 private:
-	GLint u_obscured;
+	GLint u_obscured, u_hueAdjust;
 };
 
 class MaskShader : public ShaderBase
@@ -343,9 +400,10 @@ public:
 	ScannedShaderSprite();
 
 	void setSpriteMat(const float value[16]);
+	void setHueAdjust(float value);
 
 private:
-	GLint u_spriteMat;
+	GLint u_spriteMat, u_hueAdjust;
 };
 
 class ChronosShader : public ShaderBase
@@ -389,9 +447,26 @@ public:
 
 	void setiTime(const float value);
 	void setOpacity(const float opacity);
+	void setSrcRect(const Vec4 &value);
+
+private:
+	GLint u_iTime, u_opacity, u_srcRect;
+};
+
+/* Draws a window's background and borders straight
+ * from the windowskin in a single pass */
+class WindowFrameShader : public ShaderBase
+{
+public:
+	WindowFrameShader();
+
+	void setSkinSize(const Vec2i &value);
+	void setFrameSize(const Vec2i &value);
+	void setBackOpacity(float value);
+	void setBgStretch(bool value);
 
 private:
-	GLint u_iTime, u_opacity;
+	GLint u_skinSize, u_frameSize, u_backOpacity, u_bgStretch;
 };
 
 class BinaryShader : public ShaderBase
@@ -405,35 +480,72 @@ private:
 };
 
 
+/* Compiles and links its shader the first time it is accessed,
+ * so programs a session never uses cost nothing */
+template<class S>
+class LazyShader
+{
+public:
+	LazyShader()
+	    : s(0)
+	{}
+
+	~LazyShader()
+	{
+		delete s;
+	}
+
+	S &get()
+	{
+		if (!s)
+			s = new S;
+
+		return *s;
+	}
+
+	operator S&()
+	{
+		return get();
+	}
+
+private:
+	LazyShader(const LazyShader&);
+	LazyShader &operator=(const LazyShader&);
+
+	S *s;
+};
+
 /* Global object containing all available shaders */
 struct ShaderSet
 {
-	FlatColorShader flatColor;
-	SimpleShader simple;
-	SimpleColorShader simpleColor;
-	SimpleAlphaShader simpleAlpha;
-	SimpleSpriteShader simpleSprite;
-	AlphaSpriteShader alphaSprite;
-	SpriteShader sprite;
-	PlaneShader plane;
-	GrayShader gray;
-	TilemapShader tilemap;
-	FlashMapShader flashMap;
-	TransShader trans;
-	SimpleTransShader simpleTrans;
-	HueShader hue;
-	BltShader blt;
-	SimpleMatrixShader simpleMatrix;
-	BlurShader blur;
-	ObscuredShader obscured;
-	MaskShader mask;
-	ScannedShader scanned;
-	ScannedShaderSprite scanned_sprite;
-	ChronosShader chronos;
-	ZoomShader zoom;
-	CubicShader cubic;
-	WaterShader water;
-	BinaryShader binary;
+	LazyShader<FlatColorShader> flatColor;
+	LazyShader<SimpleShader> simple;
+	LazyShader<SimpleColorShader> simpleColor;
+	LazyShader<SimpleAlphaShader> simpleAlpha;
+	LazyShader<SimpleSpriteShader> simpleSprite;
+	LazyShader<AlphaSpriteShader> alphaSprite;
+	LazyShader<SpriteShader> sprite;
+	LazyShader<PlaneShader> plane;
+	LazyShader<ParticleShader> particle;
+	LazyShader<GrayShader> gray;
+	LazyShader<TilemapShader> tilemap;
+	LazyShader<FlashMapShader> flashMap;
+	LazyShader<TransShader> trans;
+	LazyShader<SimpleTransShader> simpleTrans;
+	LazyShader<HueShader> hue;
+	LazyShader<BltShader> blt;
+	LazyShader<SimpleMatrixShader> simpleMatrix;
+	LazyShader<BlurShader> blur;
+	LazyShader<ObscuredShader> obscured;
+	LazyShader<MaskShader> mask;
+	LazyShader<ScannedShader> scanned;
+	LazyShader<ScannedShaderSprite> scanned_sprite;
+	LazyShader<ChronosShader> chronos;
+	LazyShader<ZoomShader> zoom;
+	LazyShader<CubicShader> cubic;
+	LazyShader<WaterShader> water;
+	LazyShader<WindowFrameShader> windowFrame;
+	LazyShader<BinaryShader> binary;
 };
 
 #endif // SHADER_H
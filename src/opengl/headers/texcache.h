@@ -0,0 +1,165 @@
+/*
+** texcache.h
+**
+** This file is part of mkxp.
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TEXCACHE_H
+#define TEXCACHE_H
+
+#include "gl-util.h"
+#include "texpool.h"
+
+#include <list>
+#include <stddef.h>
+
+/* Rendered textures shared by what was rendered into them.
+ * 'Key' must be equality comparable and carry the texture
+ * dimensions as 'Vec2i size'. Entries are reference counted;
+ * ones no longer referenced are kept around up to 'maxIdleBytes',
+ * least recently released handed back to the TexPool first.
+ * New entries take their texture from the pool as well */
+template <typename Key>
+class TexCache
+{
+	struct Entry
+	{
+		Key key;
+		TEXFBO gl;
+		int refCount;
+	};
+
+	typedef typename std::list<Entry>::iterator EntryIter;
+
+	/* Idle entries are kept in release order */
+	std::list<Entry> entries;
+	TexPool &pool;
+	size_t idleBytes;
+	size_t maxIdleBytes;
+
+public:
+	TexCache(TexPool &pool, size_t maxIdleBytes)
+	    : pool(pool),
+	      idleBytes(0),
+	      maxIdleBytes(maxIdleBytes)
+	{}
+
+	~TexCache()
+	{
+		for (EntryIter iter = entries.begin(); iter != entries.end(); ++iter)
+			TEXFBO::fini(iter->gl);
+	}
+
+	/* Returns true if 'out' is new and still has to be rendered */
+	bool request(const Key &key, TEXFBO &out)
+	{
+		EntryIter iter = find(key);
+
+		if (iter != entries.end())
+		{
+			if (iter->refCount++ == 0)
+				idleBytes -= byteCount(key.size);
+
+			out = iter->gl;
+
+			return false;
+		}
+
+		Entry entry;
+		entry.key = key;
+		entry.gl = pool.request(key.size.x, key.size.y);
+		entry.refCount = 1;
+
+		entries.push_back(entry);
+		out = entry.gl;
+
+		return true;
+	}
+
+	void release(const Key &key)
+	{
+		EntryIter iter = find(key);
+
+		if (iter == entries.end() || --iter->refCount > 0)
+			return;
+
+		/* Most recently released goes last */
+		entries.splice(entries.end(), entries, iter);
+		idleBytes += byteCount(key.size);
+		trim();
+	}
+
+	/* Swaps a reference to 'prev' for one to 'key'. If the caller
+	 * held the only reference to a same sized 'prev', its texture
+	 * is handed over to be rendered again in place, so something
+	 * changing every frame (eg. a fading window) doesn't go
+	 * through a texture per frame. Returns true like request() */
+	bool replace(const Key &prev, const Key &key, TEXFBO &out)
+	{
+		EntryIter iter = find(prev);
+
+		if (iter != entries.end() && iter->refCount == 1 &&
+		    prev.size == key.size && find(key) == entries.end())
+		{
+			iter->key = key;
+			out = iter->gl;
+
+			return true;
+		}
+
+		bool fresh = request(key, out);
+		release(prev);
+
+		return fresh;
+	}
+
+private:
+	static size_t byteCount(const Vec2i &size)
+	{
+		return (size_t) size.x * size.y * 4;
+	}
+
+	EntryIter find(const Key &key)
+	{
+		EntryIter iter;
+
+		for (iter = entries.begin(); iter != entries.end(); ++iter)
+			if (iter->key == key)
+				break;
+
+		return iter;
+	}
+
+	void trim()
+	{
+		EntryIter iter = entries.begin();
+
+		while (idleBytes > maxIdleBytes && iter != entries.end())
+		{
+			if (iter->refCount > 0)
+			{
+				++iter;
+				continue;
+			}
+
+			idleBytes -= byteCount(iter->key.size);
+			pool.release(iter->gl);
+			iter = entries.erase(iter);
+		}
+	}
+};
+
+#endif // TEXCACHE_H
@@ -0,0 +1,108 @@
+/*
+** vertex-stream.h
+**
+** This file is part of mkxp.
+**
+** Copyright (C) 2013 Jonas Kulla <Nyocurio@gmail.com>
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef VERTEXSTREAM_H
+#define VERTEXSTREAM_H
+
+#include "gl-util.h"
+
+#include <deque>
+#include <stdint.h>
+
+/* Shared ring buffer that dynamic vertex data (QuadArrays
+ * rewritten every frame) is streamed into, instead of each
+ * owner re-specifying its own VBO.
+ *
+ * With ARB_buffer_storage, the ring is persistently mapped and
+ * written directly; each finished frame is fenced, and space is
+ * only reused after its fence has signaled. Otherwise, the ring
+ * is orphaned whenever it wraps around.
+ *
+ * An allocation is only good for the frame it was made in;
+ * after that it may be overwritten and has to be streamed again.
+ * Space written in the current frame is never reclaimed before
+ * endFrame(), since its owners may still be about to draw it. */
+class VertexStream
+{
+public:
+	struct Alloc
+	{
+		GLintptr offset;
+		uint32_t generation;
+
+		Alloc()
+		    : offset(0), generation(0)
+		{}
+	};
+
+	/* A capacity of 0 disables streaming */
+	VertexStream(GLsizeiptr capacity);
+	~VertexStream();
+
+	bool enabled() const { return capacity > 0; }
+
+	/* Whether 'size' bytes are worth putting in the ring */
+	bool fits(GLsizeiptr size) const;
+
+	/* False if the ring has no room left for 'size' bytes
+	 * this frame; the caller has to use its own buffer */
+	bool write(const void *data, GLsizeiptr size, Alloc &out);
+	bool valid(const Alloc &alloc) const;
+
+	/* Counts presented frames, for telling dynamic
+	 * from mostly static data */
+	uint32_t frame() const { return frameCount; }
+
+	/* Called once per presented frame */
+	void endFrame();
+
+	VBO::ID vbo;
+
+private:
+	void retireOldest();
+
+	struct Pending
+	{
+		GLsync fence;
+		uint64_t end;
+	};
+
+	GLsizeiptr capacity;
+	bool persistent;
+	char *mapped;
+
+	/* Monotonic write positions; the physical offset
+	 * is the position modulo 'capacity' */
+	uint64_t head;
+	uint64_t fencedHead;
+	/* Where the current frame's writes begin */
+	uint64_t frameStart;
+	/* Everything before this is no longer read by the GPU */
+	uint64_t safe;
+
+	std::deque<Pending> pending;
+
+	uint32_t generation;
+	uint32_t frameCount;
+};
+
+#endif // VERTEXSTREAM_H
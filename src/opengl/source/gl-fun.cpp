@@ -97,6 +97,7 @@ void initGLFunctions()
 
 	/* Assume single digit */
 	int glMajor = *ver - '0';
+	int glMinor = ver[1] == '.' ? ver[2] - '0' : 0;
 
 	if (glMajor < 2)
 		throw EXC("At least OpenGL (ES) 2.0 is required");
@@ -163,6 +164,57 @@ void initGLFunctions()
 		GL_VAO_FUN;
 	}
 
+	/* Program binary entrypoints */
+	if (HAVE_EXT(ARB_get_program_binary) || (gles && glMajor >= 3))
+	{
+#undef EXT_SUFFIX
+#define EXT_SUFFIX ""
+		GL_PROGRAM_BINARY_FUN;
+		GL_PROGRAM_PARAMETER_FUN;
+	}
+	else if (HAVE_EXT(OES_get_program_binary))
+	{
+#undef EXT_SUFFIX
+#define EXT_SUFFIX "OES"
+		GL_PROGRAM_BINARY_FUN;
+	}
+
+	/* Timer query entrypoints */
+	if (HAVE_EXT(ARB_timer_query) || (!gles && glMajor >= 4))
+	{
+#undef EXT_SUFFIX
+#define EXT_SUFFIX ""
+		GL_TIMER_QUERY_FUN;
+	}
+	else if (HAVE_EXT(EXT_disjoint_timer_query))
+	{
+#undef EXT_SUFFIX
+#define EXT_SUFFIX "EXT"
+		GL_TIMER_QUERY_FUN;
+	}
+
+	/* Sync object entrypoints */
+	if (HAVE_EXT(ARB_sync) || glMajor > 3 || (glMajor == 3 && (gles || glMinor >= 2)))
+	{
+#undef EXT_SUFFIX
+#define EXT_SUFFIX ""
+		GL_SYNC_FUN;
+	}
+	else if (HAVE_EXT(APPLE_sync))
+	{
+#undef EXT_SUFFIX
+#define EXT_SUFFIX "APPLE"
+		GL_SYNC_FUN;
+	}
+
+	/* Buffer storage entrypoints */
+	if (HAVE_EXT(ARB_buffer_storage) || (!gles && (glMajor > 4 || (glMajor == 4 && glMinor >= 4))))
+	{
+#undef EXT_SUFFIX
+#define EXT_SUFFIX ""
+		GL_BUFFER_STORAGE_FUN;
+	}
+
 	/* Debug callback entrypoints */
 	if (HAVE_EXT(KHR_debug))
 	{
@@ -77,7 +77,8 @@ static void vaoBindRes(VAO &vao)
 		const VertexAttribute &va = vao.attr[i];
 
 		gl.EnableVertexAttribArray(va.index);
-		gl.VertexAttribPointer(va.index, va.size, va.type, GL_FALSE, vao.vertSize, va.offset);
+		gl.VertexAttribPointer(va.index, va.size, va.type, GL_FALSE, vao.vertSize,
+		                       (const char*) va.offset + vao.vboOffset);
 	}
 }
 
@@ -115,6 +116,23 @@ void vaoBind(VAO &vao)
 		vaoBindRes(vao);
 }
 
+void vaoSetSource(VAO &vao, VBO::ID vbo, GLintptr offset)
+{
+	if (vao.vbo == vbo && vao.vboOffset == offset)
+		return;
+
+	vao.vbo = vbo;
+	vao.vboOffset = offset;
+
+	/* Native VAOs have the pointers baked in */
+	if (HAVE_NATIVE_VAO)
+	{
+		gl.BindVertexArray(vao.nativeVAO);
+		vaoBindRes(vao);
+		gl.BindVertexArray(0);
+	}
+}
+
 void vaoUnbind(VAO &vao)
 {
 	if (HAVE_NATIVE_VAO)
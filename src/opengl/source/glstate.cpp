@@ -27,6 +27,15 @@
 
 #include <SDL2/SDL_rect.h>
 
+#define TEX_UNITS 8
+
+GLCallStats glCallStats;
+
+static GLCallStats lastFrameStats;
+
+static GLuint boundTex[TEX_UNITS];
+static unsigned int activeTexUnit;
+
 static void applyBool(GLenum state, bool mode)
 {
 	mode ? gl.Enable(state) : gl.Disable(state);
@@ -126,3 +135,49 @@ GLState::GLState(const Config &conf)
 	if (conf.maxTextureSize > 0)
 		caps.maxTexSize = conf.maxTextureSize;
 }
+
+void GLState::bindTexture(GLuint tex)
+{
+	if (activeTexUnit < TEX_UNITS && boundTex[activeTexUnit] == tex)
+	{
+		++glCallStats.elided;
+		return;
+	}
+
+	++glCallStats.issued;
+	gl.BindTexture(GL_TEXTURE_2D, tex);
+
+	if (activeTexUnit < TEX_UNITS)
+		boundTex[activeTexUnit] = tex;
+}
+
+void GLState::activeTexture(unsigned int unit)
+{
+	if (unit == activeTexUnit)
+	{
+		++glCallStats.elided;
+		return;
+	}
+
+	++glCallStats.issued;
+	gl.ActiveTexture(GL_TEXTURE0 + unit);
+	activeTexUnit = unit;
+}
+
+void GLState::forgetTexture(GLuint tex)
+{
+	for (size_t i = 0; i < TEX_UNITS; ++i)
+		if (boundTex[i] == tex)
+			boundTex[i] = 0;
+}
+
+const GLCallStats &GLState::frameStats()
+{
+	return lastFrameStats;
+}
+
+void GLState::endFrame()
+{
+	lastFrameStats = glCallStats;
+	glCallStats = GLCallStats();
+}
@@ -0,0 +1,363 @@
+/*
+** megatexture.cpp
+**
+** This file is part of mkxp.
+**
+** Copyright (C) 2014 Jonas Kulla <Nyocurio@gmail.com>
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "megatexture.h"
+
+#include "sharedstate.h"
+#include "glstate.h"
+#include "gl-meta.h"
+#include "texpool.h"
+#include "shader.h"
+#include "config.h"
+#include "util.h"
+
+#include <SDL2/SDL_surface.h>
+
+#include <algorithm>
+#include <math.h>
+
+/* Upper bound on page dimensions; smaller pages mean less
+ * wasted memory at the image edges and finer grained paging */
+#define PAGE_SIZE_MAX 2048
+
+/* Assembled views kept per MegaTexture */
+#define MAX_VIEWS 4
+
+std::list<MegaTexture::Page*> MegaTexture::lru;
+size_t MegaTexture::residentBytes = 0;
+size_t MegaTexture::pinnedBytes = 0;
+
+static size_t byteCount(const IntRect &rect)
+{
+	return (size_t) rect.w * rect.h * 4;
+}
+
+static size_t pageBudget()
+{
+	return (size_t) shState->config().megaTexBudget * 1024 * 1024;
+}
+
+static IntRect normalized(IntRect rect)
+{
+	if (rect.w < 0)
+	{
+		rect.w = -rect.w;
+		rect.x -= rect.w;
+	}
+
+	if (rect.h < 0)
+	{
+		rect.h = -rect.h;
+		rect.y -= rect.h;
+	}
+
+	return rect;
+}
+
+MegaTexture::MegaTexture(SDL_Surface *surface)
+    : surface(surface),
+      w(surface->w),
+      h(surface->h),
+      pageSize(std::min(glState.caps.maxTexSize, PAGE_SIZE_MAX)),
+      pinned(false),
+      viewCounter(0)
+{
+	SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+
+	pagesX = (w + pageSize - 1) / pageSize;
+	pagesY = (h + pageSize - 1) / pageSize;
+	pages.resize(pagesX * pagesY);
+
+	for (int y = 0; y < pagesY; ++y)
+		for (int x = 0; x < pagesX; ++x)
+		{
+			Page &pg = pages[y*pagesX + x];
+			pg.rect = IntRect(x*pageSize, y*pageSize,
+			                  std::min(pageSize, w - x*pageSize),
+			                  std::min(pageSize, h - y*pageSize));
+			pg.resident = false;
+		}
+
+	const size_t total = byteCount(IntRect(0, 0, w, h));
+
+	/* Pinned pages can't be evicted, so only pin if the
+	 * image fits next to everything pinned so far */
+	if (total > pageBudget() - pinnedBytes)
+		return;
+
+	pinned = true;
+	pinnedBytes += total;
+	makeRoom(total);
+
+	for (size_t i = 0; i < pages.size(); ++i)
+		upload(pages[i]);
+
+	SDL_FreeSurface(surface);
+	this->surface = 0;
+}
+
+MegaTexture::~MegaTexture()
+{
+	for (size_t i = 0; i < pages.size(); ++i)
+		if (pages[i].resident)
+			evict(pages[i]);
+
+	for (size_t i = 0; i < views.size(); ++i)
+		shState->texPool().release(views[i].gl);
+
+	if (pinned)
+		pinnedBytes -= byteCount(IntRect(0, 0, w, h));
+
+	if (surface)
+		SDL_FreeSurface(surface);
+}
+
+int MegaTexture::pageIndex(int x, int y) const
+{
+	x = clamp(x, 0, w-1);
+	y = clamp(y, 0, h-1);
+
+	return (y / pageSize) * pagesX + (x / pageSize);
+}
+
+int MegaTexture::pageFor(const IntRect &rect) const
+{
+	const IntRect n = normalized(rect);
+
+	if (n.x < 0 || n.y < 0 || n.x+n.w > w || n.y+n.h > h)
+		return -1;
+
+	const int last = pageIndex(n.x + std::max(n.w-1, 0), n.y + std::max(n.h-1, 0));
+	const int first = pageIndex(n.x, n.y);
+
+	return first == last ? first : -1;
+}
+
+MegaTexture::Page &MegaTexture::page(int index)
+{
+	Page &pg = pages[index];
+
+	if (!pg.resident)
+		upload(pg);
+	else if (!pinned)
+		lru.splice(lru.end(), lru, pg.lruIter);
+
+	return pg;
+}
+
+void MegaTexture::makeRoom(size_t bytes)
+{
+	const size_t budget = pageBudget();
+
+	while (residentBytes + bytes > budget && !lru.empty())
+	{
+		Page *victim = lru.front();
+
+		/* Everything in 'lru' belongs to a non-pinned
+		 * texture, so this is all evict() would do */
+		shState->texPool().release(victim->gl);
+		victim->resident = false;
+		residentBytes -= byteCount(victim->rect);
+		lru.pop_front();
+	}
+}
+
+void MegaTexture::upload(Page &pg)
+{
+	if (!pinned)
+		makeRoom(byteCount(pg.rect));
+
+	pg.gl = shState->texPool().request(pg.rect.w, pg.rect.h);
+	TEX::bind(pg.gl.tex);
+
+	if (pg.rect.w == w && surface->pitch == w*4)
+	{
+		/* Full rows are contiguous in the surface */
+		const uint8_t *rows = static_cast<const uint8_t*>(surface->pixels)
+		                    + pg.rect.y * surface->pitch;
+
+		TEX::uploadImage(pg.rect.w, pg.rect.h, rows, GL_RGBA);
+	}
+	else
+	{
+		SDL_Surface *tmp =
+			SDL_CreateRGBSurface(0, pg.rect.w, pg.rect.h, 32,
+			                     surface->format->Rmask, surface->format->Gmask,
+			                     surface->format->Bmask, surface->format->Amask);
+
+		SDL_Rect srcRect = pg.rect;
+		SDL_BlitSurface(surface, &srcRect, tmp, 0);
+
+		TEX::uploadImage(pg.rect.w, pg.rect.h, tmp->pixels, GL_RGBA);
+
+		SDL_FreeSurface(tmp);
+	}
+
+	pg.resident = true;
+	residentBytes += byteCount(pg.rect);
+
+	if (!pinned)
+		pg.lruIter = lru.insert(lru.end(), &pg);
+}
+
+void MegaTexture::evict(Page &pg)
+{
+	shState->texPool().release(pg.gl);
+	pg.resident = false;
+	residentBytes -= byteCount(pg.rect);
+
+	if (!pinned)
+		lru.erase(pg.lruIter);
+}
+
+void MegaTexture::blit(TEXFBO &target, const IntRect &src, const IntRect &dst)
+{
+	if (src.w <= 0 || src.h <= 0)
+		return;
+
+	const float sx = (float) dst.w / src.w;
+	const float sy = (float) dst.h / src.h;
+
+	const int x1 = std::min(src.x + src.w, w);
+	const int y1 = std::min(src.y + src.h, h);
+
+	/* Pages first touched here get uploaded (and others
+	 * possibly evicted) mid blit; GL orders the upload
+	 * after any blits already reading the old contents */
+	GLMeta::blitBegin(target);
+
+	for (int py = std::max(src.y, 0) / pageSize; py*pageSize < y1; ++py)
+		for (int px = std::max(src.x, 0) / pageSize; px*pageSize < x1; ++px)
+		{
+			Page &pg = page(py*pagesX + px);
+
+			IntRect piece;
+			if (!SDL_IntersectRect(&src, &pg.rect, &piece))
+				continue;
+
+			/* Map the piece into 'dst' the same way for all
+			 * pages, so neighbouring pieces meet exactly */
+			const int dx0 = dst.x + lroundf((piece.x - src.x) * sx);
+			const int dy0 = dst.y + lroundf((piece.y - src.y) * sy);
+			const int dx1 = dst.x + lroundf((piece.x + piece.w - src.x) * sx);
+			const int dy1 = dst.y + lroundf((piece.y + piece.h - src.y) * sy);
+
+			GLMeta::blitSource(pg.gl);
+			GLMeta::blitRectangle(IntRect(piece.x - pg.rect.x, piece.y - pg.rect.y,
+			                              piece.w, piece.h),
+			                      IntRect(dx0, dy0, dx1 - dx0, dy1 - dy0), false);
+		}
+
+	GLMeta::blitEnd();
+}
+
+IntRect MegaTexture::clampedView(const IntRect &rect) const
+{
+	const IntRect n = normalized(rect);
+	const int maxSize = glState.caps.maxTexSize;
+
+	return IntRect(n.x, n.y,
+	               clamp(n.w, 1, maxSize),
+	               clamp(n.h, 1, maxSize));
+}
+
+MegaTexture::View *MegaTexture::findView(const IntRect &rect)
+{
+	for (size_t i = 0; i < views.size(); ++i)
+		if (views[i].rect == rect)
+			return &views[i];
+
+	return 0;
+}
+
+IntRect MegaTexture::viewRect(const IntRect &rect) const
+{
+	const int index = pageFor(rect);
+
+	if (index >= 0)
+		return pages[index].rect;
+
+	return clampedView(rect);
+}
+
+void MegaTexture::prepareView(const IntRect &rect)
+{
+	if (pageFor(rect) >= 0)
+		return;
+
+	const IntRect vr = clampedView(rect);
+
+	if (View *v = findView(vr))
+	{
+		v->lastUse = ++viewCounter;
+		return;
+	}
+
+	if (views.size() >= MAX_VIEWS)
+	{
+		size_t oldest = 0;
+
+		for (size_t i = 1; i < views.size(); ++i)
+			if (views[i].lastUse < views[oldest].lastUse)
+				oldest = i;
+
+		shState->texPool().release(views[oldest].gl);
+		views.erase(views.begin() + oldest);
+	}
+
+	View v;
+	v.rect = vr;
+	v.lastUse = ++viewCounter;
+	v.gl = shState->texPool().request(vr.w, vr.h);
+
+	/* Parts outside the image stay transparent */
+	FBO::bind(v.gl.fbo);
+	glState.clearColor.pushSet(Vec4());
+	FBO::clear();
+	glState.clearColor.pop();
+
+	blit(v.gl, vr, IntRect(0, 0, vr.w, vr.h));
+
+	views.push_back(v);
+}
+
+void MegaTexture::bindView(ShaderBase &shader, const IntRect &rect)
+{
+	int index = pageFor(rect);
+	TEXFBO *tex = 0;
+
+	if (index < 0)
+	{
+		if (View *v = findView(clampedView(rect)))
+			tex = &v->gl;
+		else
+			/* prepareView() was skipped; better to show part
+			 * of the image than to assemble mid draw */
+			index = pageIndex(rect.x, rect.y);
+	}
+
+	if (!tex)
+		tex = &page(index).gl;
+
+	TEX::bind(tex->tex);
+	shader.setTexSize(Vec2i(tex->width, tex->height));
+}
@@ -23,10 +23,19 @@
 #include "sharedstate.h"
 #include "glstate.h"
 #include "exception.h"
+#include "serial-util.h"
+#include "debugwriter.h"
+#include "util.h"
+
+#include <SDL2/SDL_timer.h>
 
 #include <assert.h>
+#include <stdio.h>
 #include <string.h>
 #include <iostream>
+#include <string>
+#include <vector>
+#include <map>
 
 #include "common.h.xxd"
 #include "sprite.frag.xxd"
@@ -35,6 +44,7 @@
 #include "transSimple.frag.xxd"
 #include "bitmapBlit.frag.xxd"
 #include "plane.frag.xxd"
+#include "particle.frag.xxd"
 #include "gray.frag.xxd"
 #include "flatColor.frag.xxd"
 #include "simple.frag.xxd"
@@ -58,6 +68,7 @@
 #include "crt_sprite.frag.xxd"
 #include "cubic_lens.frag.xxd"
 #include "water.frag.xxd"
+#include "windowFrame.frag.xxd"
 #include "binary_glitch.frag.xxd"
 #include "chronos.frag.xxd"
 #include "zoom.vert.xxd"
@@ -93,6 +104,236 @@ static void printProgramLog(GLuint program)
 	std::clog << "Program log:\n" << log;
 }
 
+/* Linked program binaries from previous runs, keyed by program name.
+ * Each entry carries a hash of the driver identity and all sources
+ * that went into it; a mismatch means the binary is stale */
+struct ProgramBinaryCache
+{
+	struct Entry
+	{
+		uint64_t key;
+		GLenum format;
+		std::string data;
+	};
+
+	std::string path;
+	bool loaded;
+	/* Entries were added since the last save */
+	bool dirty;
+	std::map<std::string, Entry> entries;
+
+	ProgramBinaryCache()
+	    : loaded(false),
+	      dirty(false)
+	{}
+
+	bool usable() const
+	{
+		return !path.empty() && gl.GetProgramBinary && gl.ProgramBinary;
+	}
+
+	void load()
+	{
+		loaded = true;
+
+		std::string file;
+
+		if (!readFile(path.c_str(), file))
+			return;
+
+		const char *data = file.c_str();
+		const char *end = data + file.size();
+
+		if (file.size() < 12 || memcmp(data, magic(), 8))
+			return;
+
+		data += 8;
+		int count = readInt32(&data);
+
+		for (int i = 0; i < count; ++i)
+		{
+			if (end - data < 4)
+				return;
+
+			int nameLen = readInt32(&data);
+
+			if (nameLen < 0 || end - data < nameLen + 16)
+				return;
+
+			std::string name(data, nameLen);
+			data += nameLen;
+
+			Entry e;
+			uint32_t keyLo = readInt32(&data);
+			uint32_t keyHi = readInt32(&data);
+			e.key = ((uint64_t) keyHi << 32) | keyLo;
+			e.format = readInt32(&data);
+			int dataLen = readInt32(&data);
+
+			if (dataLen < 0 || end - data < dataLen)
+				return;
+
+			e.data.assign(data, dataLen);
+			data += dataLen;
+
+			entries[name] = e;
+		}
+	}
+
+	/* Written to a temporary file first and renamed over the
+	 * old cache, so a crash mid-write can't leave a truncated
+	 * cache behind */
+	void save()
+	{
+		if (!dirty)
+			return;
+
+		dirty = false;
+
+		std::string file(magic(), 8);
+		std::vector<char> buf(16);
+
+		char *bufP = &buf[0];
+		writeInt32(&bufP, entries.size());
+		file.append(&buf[0], 4);
+
+		std::map<std::string, Entry>::const_iterator iter;
+
+		for (iter = entries.begin(); iter != entries.end(); ++iter)
+		{
+			bufP = &buf[0];
+			writeInt32(&bufP, iter->first.size());
+			file.append(&buf[0], 4);
+			file.append(iter->first);
+
+			bufP = &buf[0];
+			writeInt32(&bufP, (uint32_t) iter->second.key);
+			writeInt32(&bufP, (uint32_t) (iter->second.key >> 32));
+			writeInt32(&bufP, iter->second.format);
+			writeInt32(&bufP, iter->second.data.size());
+			file.append(&buf[0], 16);
+			file.append(iter->second.data);
+		}
+
+		const std::string tmpPath = path + ".tmp";
+		FILE *f = fopen(tmpPath.c_str(), "wb");
+
+		if (!f)
+			return;
+
+		const bool written =
+			fwrite(file.data(), 1, file.size(), f) == file.size();
+
+		if (fclose(f) != 0 || !written)
+		{
+			remove(tmpPath.c_str());
+			return;
+		}
+
+#ifdef _WIN32
+		/* rename() won't replace an existing file here */
+		remove(path.c_str());
+#endif
+
+		if (rename(tmpPath.c_str(), path.c_str()) != 0)
+			remove(tmpPath.c_str());
+	}
+
+	const Entry *find(const char *name, uint64_t key)
+	{
+		if (!loaded)
+			load();
+
+		std::map<std::string, Entry>::const_iterator iter = entries.find(name);
+
+		if (iter == entries.end() || iter->second.key != key)
+			return 0;
+
+		return &iter->second;
+	}
+
+	void store(const char *name, uint64_t key, GLuint program)
+	{
+		GLint length = 0;
+		gl.GetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+		if (length <= 0)
+			return;
+
+		Entry e;
+		e.key = key;
+		e.data.resize(length);
+
+		GLsizei written = 0;
+		gl.GetProgramBinary(program, length, &written, &e.format, &e.data[0]);
+
+		if (written <= 0)
+			return;
+
+		e.data.resize(written);
+		entries[name] = e;
+
+		/* Persisted by flushBinaryCache() at the next
+		 * idle point, not in the middle of gameplay */
+		dirty = true;
+	}
+
+	static const char *magic()
+	{
+		return "MKXPPBC1";
+	}
+};
+
+static ProgramBinaryCache binaryCache;
+
+/* FNV-1a */
+static uint64_t hashBytes(uint64_t hash, const void *data, size_t size)
+{
+	const unsigned char *bytes = static_cast<const unsigned char*>(data);
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001B3ULL;
+	}
+
+	return hash;
+}
+
+static uint64_t hashString(uint64_t hash, const GLubyte *str)
+{
+	const char *s = str ? (const char*) str : "";
+
+	return hashBytes(hash, s, strlen(s) + 1);
+}
+
+static uint64_t programKey(const unsigned char *vert, int vertSize,
+                           const unsigned char *frag, int fragSize)
+{
+	uint64_t hash = 0xCBF29CE484222325ULL;
+
+	hash = hashString(hash, gl.GetString(GL_VENDOR));
+	hash = hashString(hash, gl.GetString(GL_RENDERER));
+	hash = hashString(hash, gl.GetString(GL_VERSION));
+	hash = hashBytes(hash, &gl.glsles, sizeof(gl.glsles));
+	hash = hashBytes(hash, ___shader_common_h, ___shader_common_h_len);
+	hash = hashBytes(hash, vert, vertSize);
+	hash = hashBytes(hash, frag, fragSize);
+
+	return hash;
+}
+
+void Shader::setBinaryCachePath(const std::string &path)
+{
+	binaryCache.path = path;
+}
+
+void Shader::flushBinaryCache()
+{
+	if (binaryCache.usable())
+		binaryCache.save();
+}
+
 Shader::Shader()
 {
 	vertShader = gl.CreateShader(GL_VERTEX_SHADER);
@@ -103,7 +344,11 @@ Shader::Shader()
 
 Shader::~Shader()
 {
-	gl.UseProgram(0);
+	/* Go through glState so its cached binding can't outlive
+	 * the program (and match a later one reusing the name) */
+	if (glState.program.get() == program)
+		glState.program.set(0);
+
 	gl.DeleteProgram(program);
 	gl.DeleteShader(vertShader);
 	gl.DeleteShader(fragShader);
@@ -116,7 +361,7 @@ void Shader::bind()
 
 void Shader::unbind()
 {
-	gl.ActiveTexture(GL_TEXTURE0);
+	GLState::activeTexture(0);
 	glState.program.set(0);
 }
 
@@ -155,10 +400,64 @@ static void setupShaderSource(GLuint shader, GLenum type,
 	gl.ShaderSource(shader, i, shaderSrc, shaderSrcSize);
 }
 
+bool Shader::initFromBinary(const char *programName, uint64_t key)
+{
+	const ProgramBinaryCache::Entry *e = binaryCache.find(programName, key);
+
+	if (!e)
+		return false;
+
+	gl.ProgramBinary(program, e->format, e->data.data(), e->data.size());
+
+	GLint success;
+	gl.GetProgramiv(program, GL_LINK_STATUS, &success);
+
+	/* Driver rejected it (eg. after an update); compile from source */
+	return success;
+}
+
 void Shader::init(const unsigned char *vert, int vertSize,
                   const unsigned char *frag, int fragSize,
                   const char *vertName, const char *fragName,
                   const char *programName)
+{
+	const Uint64 startTicks = SDL_GetPerformanceCounter();
+
+	const bool useCache = binaryCache.usable();
+	uint64_t key = 0;
+
+	if (useCache)
+	{
+		key = programKey(vert, vertSize, frag, fragSize);
+
+		if (initFromBinary(programName, key))
+		{
+			logInitTime(programName, startTicks, true);
+			return;
+		}
+	}
+
+	compile(vert, vertSize, frag, fragSize, vertName, fragName, programName);
+
+	if (useCache)
+		binaryCache.store(programName, key, program);
+
+	logInitTime(programName, startTicks, false);
+}
+
+void Shader::logInitTime(const char *programName, uint64_t startTicks, bool cached)
+{
+	const double ms = (SDL_GetPerformanceCounter() - startTicks) * 1000.0
+	                / SDL_GetPerformanceFrequency();
+
+	Debug() << "Shader:" << programName << (cached ? "loaded from cache in" : "compiled in")
+	        << ms << "ms";
+}
+
+void Shader::compile(const unsigned char *vert, int vertSize,
+                     const unsigned char *frag, int fragSize,
+                     const char *vertName, const char *fragName,
+                     const char *programName)
 {
 	GLint success;
 
@@ -198,6 +497,9 @@ void Shader::init(const unsigned char *vert, int vertSize,
 	gl.BindAttribLocation(program, TexCoord, "texCoord");
 	gl.BindAttribLocation(program, Color, "color");
 
+	if (gl.ProgramParameteri && binaryCache.usable())
+		gl.ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
 	gl.LinkProgram(program);
 
 	gl.GetProgramiv(program, GL_LINK_STATUS, &success);
@@ -223,24 +525,93 @@ void Shader::initFromFile(const char *_vertFile, const char *_fragFile,
 	     _vertFile, _fragFile, programName);
 }
 
+bool Shader::updateShadow(GLint location, const float *value, int size)
+{
+	/* Unused uniforms were optimized out; nothing to upload */
+	if (location < 0)
+		return false;
+
+	const size_t bytes = size * sizeof(float);
+
+	for (size_t i = 0; i < uniformShadows.size(); ++i)
+	{
+		UniformShadow &u = uniformShadows[i];
+
+		if (u.location != location)
+			continue;
+
+		if (u.size == size && !memcmp(u.value, value, bytes))
+		{
+			++glCallStats.elided;
+			return false;
+		}
+
+		u.size = size;
+		memcpy(u.value, value, bytes);
+		++glCallStats.issued;
+
+		return true;
+	}
+
+	UniformShadow u;
+	u.location = location;
+	u.size = size;
+	memcpy(u.value, value, bytes);
+	uniformShadows.push_back(u);
+
+	++glCallStats.issued;
+
+	return true;
+}
+
+void Shader::setFloatUniform(GLint location, float value)
+{
+	if (updateShadow(location, &value, 1))
+		gl.Uniform1f(location, value);
+}
+
+void Shader::setIntUniform(GLint location, int value)
+{
+	/* Only used for sampler units, which are exact as floats */
+	const float shadow = value;
+
+	if (updateShadow(location, &shadow, 1))
+		gl.Uniform1i(location, value);
+}
+
+void Shader::setVec2fUniform(GLint location, float x, float y)
+{
+	const float value[] = { x, y };
+
+	if (updateShadow(location, value, 2))
+		gl.Uniform2f(location, x, y);
+}
+
 void Shader::setVec4Uniform(GLint location, const Vec4 &vec)
 {
-	gl.Uniform4f(location, vec.x, vec.y, vec.z, vec.w);
+	const float value[] = { vec.x, vec.y, vec.z, vec.w };
+
+	if (updateShadow(location, value, 4))
+		gl.Uniform4f(location, vec.x, vec.y, vec.z, vec.w);
 }
 
 void Shader::setVec2Uniform(GLint location, const Vec2i &vec)
 {
-	gl.Uniform2f(location, 1.f / vec.x, 1.f / vec.y);
+	setVec2fUniform(location, 1.f / vec.x, 1.f / vec.y);
 }
 
-void Shader::setTexUniform(GLint location, unsigned unitIndex, TEX::ID texture)
+void Shader::setMat4Uniform(GLint location, const float value[16])
 {
-	GLenum texUnit = GL_TEXTURE0 + unitIndex;
+	if (updateShadow(location, value, 16))
+		gl.UniformMatrix4fv(location, 1, GL_FALSE, value);
+}
 
-	gl.ActiveTexture(texUnit);
-	gl.BindTexture(GL_TEXTURE_2D, texture.gl);
-	gl.Uniform1i(location, unitIndex);
-	gl.ActiveTexture(GL_TEXTURE0);
+void Shader::setTexUniform(GLint location, unsigned unitIndex, TEX::ID texture)
+{
+	GLState::activeTexture(unitIndex);
+	GLState::bindTexture(texture.gl);
+	setIntUniform(location, unitIndex);
+	GLState::activeTexture(0);
 }
 
 void ShaderBase::GLProjMat::apply(const Vec2i &value)
@@ -277,12 +648,12 @@ void ShaderBase::applyViewportProj()
 
 void ShaderBase::setTexSize(const Vec2i &value)
 {
-	gl.Uniform2f(u_texSizeInv, 1.f / value.x, 1.f / value.y);
+	setVec2fUniform(u_texSizeInv, 1.f / value.x, 1.f / value.y);
 }
 
 void ShaderBase::setTranslation(const Vec2i &value)
 {
-	gl.Uniform2f(u_translation, value.x, value.y);
+	setVec2fUniform(u_translation, value.x, value.y);
 }
 
 
@@ -312,7 +683,7 @@ SimpleShader::SimpleShader()
 
 void SimpleShader::setTexOffsetX(int value)
 {
-	gl.Uniform1f(u_texOffsetX, value);
+	setFloatUniform(u_texOffsetX, value);
 }
 
 
@@ -343,7 +714,7 @@ SimpleSpriteShader::SimpleSpriteShader()
 
 void SimpleSpriteShader::setSpriteMat(const float value[16])
 {
-	gl.UniformMatrix4fv(u_spriteMat, 1, GL_FALSE, value);
+	setMat4Uniform(u_spriteMat, value);
 }
 
 
@@ -359,12 +730,12 @@ AlphaSpriteShader::AlphaSpriteShader()
 
 void AlphaSpriteShader::setSpriteMat(const float value[16])
 {
-	gl.UniformMatrix4fv(u_spriteMat, 1, GL_FALSE, value);
+	setMat4Uniform(u_spriteMat, value);
 }
 
 void AlphaSpriteShader::setAlpha(float value)
 {
-	gl.Uniform1f(u_alpha, value);
+	setFloatUniform(u_alpha, value);
 }
 
 
@@ -398,12 +769,12 @@ void TransShader::setTransMap(TEX::ID tex)
 
 void TransShader::setProg(float value)
 {
-	gl.Uniform1f(u_prog, value);
+	setFloatUniform(u_prog, value);
 }
 
 void TransShader::setVague(float value)
 {
-	gl.Uniform1f(u_vague, value);
+	setFloatUniform(u_vague, value);
 }
 
 
@@ -430,7 +801,7 @@ void SimpleTransShader::setFrozenScene(TEX::ID tex)
 
 void SimpleTransShader::setProg(float value)
 {
-	gl.Uniform1f(u_prog, value);
+	setFloatUniform(u_prog, value);
 }
 
 
@@ -446,11 +817,12 @@ SpriteShader::SpriteShader()
 	GET_U(opacity);
 	GET_U(bushDepth);
 	GET_U(bushOpacity);
+	GET_U(hueAdjust);
 }
 
 void SpriteShader::setSpriteMat(const float value[16])
 {
-	gl.UniformMatrix4fv(u_spriteMat, 1, GL_FALSE, value);
+	setMat4Uniform(u_spriteMat, value);
 }
 
 void SpriteShader::setTone(const Vec4 &tone)
@@ -465,17 +837,22 @@ void SpriteShader::setColor(const Vec4 &color)
 
 void SpriteShader::setOpacity(float value)
 {
-	gl.Uniform1f(u_opacity, value);
+	setFloatUniform(u_opacity, value);
 }
 
 void SpriteShader::setBushDepth(float value)
 {
-	gl.Uniform1f(u_bushDepth, value);
+	setFloatUniform(u_bushDepth, value);
 }
 
 void SpriteShader::setBushOpacity(float value)
 {
-	gl.Uniform1f(u_bushOpacity, value);
+	setFloatUniform(u_bushOpacity, value);
+}
+
+void SpriteShader::setHueAdjust(float value)
+{
+	setFloatUniform(u_hueAdjust, value);
 }
 
 
@@ -489,6 +866,7 @@ PlaneShader::PlaneShader()
 	GET_U(color);
 	GET_U(flash);
 	GET_U(opacity);
+	GET_U(srcRect);
 }
 
 void PlaneShader::setTone(const Vec4 &tone)
@@ -508,7 +886,33 @@ void PlaneShader::setFlash(const Vec4 &flash)
 
 void PlaneShader::setOpacity(float value)
 {
-	gl.Uniform1f(u_opacity, value);
+	setFloatUniform(u_opacity, value);
+}
+
+void PlaneShader::setSrcRect(const Vec4 &value)
+{
+	setVec4Uniform(u_srcRect, value);
+}
+
+
+ParticleShader::ParticleShader()
+{
+	INIT_SHADER(simpleColor, particle, ParticleShader);
+
+	ShaderBase::init();
+
+	GET_U(tone);
+	GET_U(color);
+}
+
+void ParticleShader::setTone(const Vec4 &tone)
+{
+	setVec4Uniform(u_tone, tone);
+}
+
+void ParticleShader::setColor(const Vec4 &color)
+{
+	setVec4Uniform(u_color, color);
 }
 
 
@@ -523,7 +927,7 @@ GrayShader::GrayShader()
 
 void GrayShader::setGray(float value)
 {
-	gl.Uniform1f(u_gray, value);
+	setFloatUniform(u_gray, value);
 }
 
 
@@ -538,14 +942,14 @@ TilemapShader::TilemapShader()
 
 void TilemapShader::setAniIndex(int value)
 {
-	gl.Uniform1f(u_aniIndex, value);
+	setFloatUniform(u_aniIndex, value);
 }
 
 
 
 FlashMapShader::FlashMapShader()
 {
-	INIT_SHADER(simpleColor, flashMap, FlashMapShader);
+	INIT_SHADER(simple, flashMap, FlashMapShader);
 
 	ShaderBase::init();
 
@@ -554,7 +958,7 @@ FlashMapShader::FlashMapShader()
 
 void FlashMapShader::setAlpha(float value)
 {
-	gl.Uniform1f(u_alpha, value);
+	setFloatUniform(u_alpha, value);
 }
 
 
@@ -569,7 +973,7 @@ HueShader::HueShader()
 
 void HueShader::setHueAdjust(float value)
 {
-	gl.Uniform1f(u_hueAdjust, value);
+	setFloatUniform(u_hueAdjust, value);
 }
 
 
@@ -584,7 +988,7 @@ SimpleMatrixShader::SimpleMatrixShader()
 
 void SimpleMatrixShader::setMatrix(const float value[16])
 {
-	gl.UniformMatrix4fv(u_matrix, 1, GL_FALSE, value);
+	setMat4Uniform(u_matrix, value);
 }
 
 
@@ -617,7 +1021,7 @@ BltShader::BltShader()
 
 void BltShader::setSource()
 {
-	gl.Uniform1i(u_source, 0);
+	setIntUniform(u_source, 0);
 }
 
 void BltShader::setDestination(const TEX::ID value)
@@ -627,12 +1031,12 @@ void BltShader::setDestination(const TEX::ID value)
 
 void BltShader::setSubRect(const FloatRect &value)
 {
-	gl.Uniform4f(u_subRect, value.x, value.y, value.w, value.h);
+	setVec4Uniform(u_subRect, Vec4(value.x, value.y, value.w, value.h));
 }
 
 void BltShader::setOpacity(float value)
 {
-	gl.Uniform1f(u_opacity, value);
+	setFloatUniform(u_opacity, value);
 }
 
 ObscuredShader::ObscuredShader()
@@ -642,6 +1046,7 @@ ObscuredShader::ObscuredShader()
 	ShaderBase::init();
 
 	GET_U(obscured);
+	GET_U(hueAdjust);
 }
 
 void ObscuredShader::setObscured(const TEX::ID value)
@@ -649,6 +1054,11 @@ void ObscuredShader::setObscured(const TEX::ID value)
 	setTexUniform(u_obscured, 1, value);
 }
 
+void ObscuredShader::setHueAdjust(float value)
+{
+	setFloatUniform(u_hueAdjust, value);
+}
+
 MaskShader::MaskShader()
 {
 	INIT_SHADER(mask, mask, MaskShader);
@@ -689,11 +1099,17 @@ ScannedShaderSprite::ScannedShaderSprite()
 	ShaderBase::init();
 
 	GET_U(spriteMat);
+	GET_U(hueAdjust);
 }
 
 void ScannedShaderSprite::setSpriteMat(const float value[16])
 {
-	gl.UniformMatrix4fv(u_spriteMat, 1, GL_FALSE, value);
+	setMat4Uniform(u_spriteMat, value);
+}
+
+void ScannedShaderSprite::setHueAdjust(float value)
+{
+	setFloatUniform(u_hueAdjust, value);
 }
 
 ChronosShader::ChronosShader()
@@ -708,8 +1124,8 @@ ChronosShader::ChronosShader()
 
 void ChronosShader::setrgbOffset(const Vec4 ox, const Vec4 oy)
 {
-	gl.Uniform4f(u_rgbOffsetx, ox.x, ox.y, ox.z, 0);
-	gl.Uniform4f(u_rgbOffsety, oy.x, oy.y, oy.z, 0);
+	setVec4Uniform(u_rgbOffsetx, Vec4(ox.x, ox.y, ox.z, 0));
+	setVec4Uniform(u_rgbOffsety, Vec4(oy.x, oy.y, oy.z, 0));
 }
 
 ZoomShader::ZoomShader()
@@ -723,7 +1139,7 @@ ZoomShader::ZoomShader()
 
 void ZoomShader::setZoom(const Vec2 zoom)
 {
-	gl.Uniform2f(u_zoom, zoom.x, zoom.y);
+	setVec2fUniform(u_zoom, zoom.x, zoom.y);
 }
 
 CubicShader::CubicShader()
@@ -737,7 +1153,7 @@ CubicShader::CubicShader()
 
 void CubicShader::setiTime(const float value)
 {
-	gl.Uniform1f(u_iTime, value);
+	setFloatUniform(u_iTime, value);
 }
 
 WaterShader::WaterShader()
@@ -748,16 +1164,54 @@ WaterShader::WaterShader()
 
 	GET_U(iTime);
 	GET_U(opacity);
+	GET_U(srcRect);
 }
 
 void WaterShader::setiTime(const float value)
 {
-	gl.Uniform1f(u_iTime, value);
+	setFloatUniform(u_iTime, value);
 }
 
 void WaterShader::setOpacity(const float value)
 {
-	gl.Uniform1f(u_opacity, value);
+	setFloatUniform(u_opacity, value);
+}
+
+void WaterShader::setSrcRect(const Vec4 &value)
+{
+	setVec4Uniform(u_srcRect, value);
+}
+
+WindowFrameShader::WindowFrameShader()
+{
+	INIT_SHADER(simple, windowFrame, WindowFrameShader);
+
+	ShaderBase::init();
+
+	GET_U(skinSize);
+	GET_U(frameSize);
+	GET_U(backOpacity);
+	GET_U(bgStretch);
+}
+
+void WindowFrameShader::setSkinSize(const Vec2i &value)
+{
+	setVec2fUniform(u_skinSize, value.x, value.y);
+}
+
+void WindowFrameShader::setFrameSize(const Vec2i &value)
+{
+	setVec2fUniform(u_frameSize, value.x, value.y);
+}
+
+void WindowFrameShader::setBackOpacity(float value)
+{
+	setFloatUniform(u_backOpacity, value);
+}
+
+void WindowFrameShader::setBgStretch(bool value)
+{
+	setFloatUniform(u_bgStretch, value ? 1.0f : 0.0f);
 }
 
 BinaryShader::BinaryShader()
@@ -771,5 +1225,5 @@ BinaryShader::BinaryShader()
 
 void BinaryShader::setStrength(const float value)
 {
-	gl.Uniform1f(u_strength, value);
+	setFloatUniform(u_strength, value);
 }
\ No newline at end of file
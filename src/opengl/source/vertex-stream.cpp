@@ -0,0 +1,210 @@
+/*
+** vertex-stream.cpp
+**
+** This file is part of mkxp.
+**
+** Copyright (C) 2014 Jonas Kulla <Nyocurio@gmail.com>
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "vertex-stream.h"
+
+#include "glstate.h"
+#include "debugwriter.h"
+
+#include <string.h>
+
+#define STREAM_ALIGN 64
+
+/* Frames are fenced and retired as a whole, so a single
+ * upload must leave room for a few of them in the ring */
+#define STREAM_MAX_FRACTION 4
+
+/* Give up on a fence after this long (ns) rather than
+ * hang on a lost context */
+#define FENCE_TIMEOUT 1000000000ULL
+
+VertexStream::VertexStream(GLsizeiptr capacity)
+    : vbo(VBO::ID(0)),
+      capacity(capacity),
+      persistent(false),
+      mapped(0),
+      head(0),
+      fencedHead(0),
+      frameStart(0),
+      safe(0),
+      generation(1),
+      frameCount(0)
+{
+	if (capacity <= 0)
+	{
+		this->capacity = 0;
+		return;
+	}
+
+	vbo = VBO::gen();
+	VBO::bind(vbo);
+
+	if (gl.BufferStorage && gl.MapBufferRange && gl.FenceSync)
+	{
+		const GLbitfield flags =
+			GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		gl.BufferStorage(GL_ARRAY_BUFFER, capacity, 0, flags);
+		mapped = (char*) gl.MapBufferRange(GL_ARRAY_BUFFER, 0, capacity, flags);
+		persistent = (mapped != 0);
+	}
+
+	if (!persistent)
+	{
+		/* Storage created by BufferStorage is immutable,
+		 * so start over with a fresh name */
+		if (gl.BufferStorage)
+		{
+			VBO::unbind();
+			VBO::del(vbo);
+			vbo = VBO::gen();
+			VBO::bind(vbo);
+		}
+
+		VBO::allocEmpty(capacity, GL_STREAM_DRAW);
+	}
+
+	VBO::unbind();
+
+	Debug() << "Vertex stream:" << capacity / 1024 << "KiB,"
+	        << (persistent ? "persistently mapped" : "orphaning");
+}
+
+VertexStream::~VertexStream()
+{
+	if (!enabled())
+		return;
+
+	for (size_t i = 0; i < pending.size(); ++i)
+		gl.DeleteSync(pending[i].fence);
+
+	if (persistent)
+	{
+		VBO::bind(vbo);
+		gl.UnmapBuffer(GL_ARRAY_BUFFER);
+		VBO::unbind();
+	}
+
+	VBO::del(vbo);
+}
+
+bool VertexStream::fits(GLsizeiptr size) const
+{
+	return enabled() && size > 0 && size <= capacity / STREAM_MAX_FRACTION;
+}
+
+void VertexStream::retireOldest()
+{
+	Pending &p = pending.front();
+
+	gl.ClientWaitSync(p.fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+	gl.DeleteSync(p.fence);
+	safe = p.end;
+
+	pending.pop_front();
+}
+
+bool VertexStream::write(const void *data, GLsizeiptr size, Alloc &out)
+{
+	uint64_t pos = (head + STREAM_ALIGN-1) & ~(uint64_t) (STREAM_ALIGN-1);
+
+	/* Never split an allocation across the end */
+	if (pos % capacity + size > (uint64_t) capacity)
+		pos += capacity - pos % capacity;
+
+	if (persistent)
+	{
+		while (pos + size - safe > (uint64_t) capacity)
+		{
+			/* Only earlier frames can be retired. If everything
+			 * left is this frame's, it is filling up the ring on
+			 * its own; the data already written may not have been
+			 * drawn yet, so no fence would let us reuse it */
+			if (pending.empty())
+				return false;
+
+			retireOldest();
+		}
+	}
+	else if (head > 0 && pos / capacity != (head-1) / capacity)
+	{
+		/* Orphaning would detach this frame's earlier
+		 * allocations from the buffer name they're drawn from */
+		if (head > frameStart)
+			return false;
+
+		/* Wrapped around at the start of a frame; let the driver
+		 * hand us fresh storage while the old one drains. Older
+		 * allocations already went stale at endFrame() */
+		VBO::bind(vbo);
+		VBO::allocEmpty(capacity, GL_STREAM_DRAW);
+		VBO::unbind();
+	}
+
+	const GLintptr offset = pos % capacity;
+
+	if (persistent)
+	{
+		/* Written straight into the mapping, no GL call */
+		memcpy(mapped + offset, data, size);
+		glCallStats.bufBytes += size;
+	}
+	else
+	{
+		VBO::bind(vbo);
+		VBO::uploadSubData(offset, size, data);
+		VBO::unbind();
+	}
+
+	head = pos + size;
+
+	out.offset = offset;
+	out.generation = generation;
+
+	return true;
+}
+
+bool VertexStream::valid(const Alloc &alloc) const
+{
+	return enabled() && alloc.generation == generation;
+}
+
+void VertexStream::endFrame()
+{
+	if (!enabled())
+		return;
+
+	if (persistent && head != fencedHead)
+	{
+		Pending p;
+		p.fence = gl.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		p.end = head;
+
+		pending.push_back(p);
+		fencedHead = head;
+	}
+
+	frameStart = head;
+
+	++generation;
+	++frameCount;
+}
@@ -0,0 +1,136 @@
+/*
+** eventgrid.h
+**
+** This file is part of mkxp.
+**
+** Copyright (C) 2013 Jonas Kulla <Nyocurio@gmail.com>
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef EVENTGRID_H
+#define EVENTGRID_H
+
+#include "serializable.h"
+#include "etc-internal.h"
+
+#include <stdint.h>
+#include <vector>
+#include <map>
+
+class Table;
+
+/* Uniform grid bucketing map events by the tile they
+ * stand on, so per-tile lookups don't have to walk
+ * every event on the map. Events are also bucketed by
+ * every tile their collision footprint covers */
+class EventGrid : public Serializable
+{
+public:
+	EventGrid(int width, int height);
+	EventGrid(const EventGrid &other);
+	virtual ~EventGrid() {}
+
+	int width() const { return w; }
+	int height() const { return h; }
+	int count() const { return entries.size(); }
+
+	/* Changes whenever an event is added, moved, removed
+	 * or changes state. Unique across all grids, like
+	 * Table::revision() */
+	uint64_t revision() const { return rev; }
+
+	/* Only changes when passable(..., false) may answer
+	 * differently: state changes, and events moving that
+	 * aren't characters (tile events, blank ones without
+	 * a graphic) */
+	uint64_t passRevision() const { return passRev; }
+
+	/* Inserting an existing id moves it instead */
+	void insert(int id, int x, int y);
+	void move(int id, int x, int y);
+	void remove(int id);
+	void clear();
+
+	/* Per-event data consulted by passable() */
+	void setState(int id, int tileId, bool through, bool noGraphic);
+
+	/* Tiles the event covers, relative to where it stands
+	 * (Game_Event#collision). Defaults to just (0, 0) */
+	void setFootprint(int id, const std::vector<Vec2i> &offsets);
+
+	/* Ids of all events on tile (x, y), in ascending order.
+	 * Only valid until the next call */
+	const std::vector<int> &at(int x, int y) const;
+
+	/* Ids of all events whose footprint covers tile (x, y),
+	 * in ascending order. Only valid until the next call */
+	const std::vector<int> &covering(int x, int y) const;
+
+	/* Equivalent of Game_Map#passable? (minus the valid? check);
+	 * events with id 'selfId' are ignored. Without 'characters',
+	 * events showing a character graphic are ignored as well */
+	bool passable(const Table &data, const Table &passages,
+	              const Table &priorities,
+	              int x, int y, int d, int selfId,
+	              bool characters = true) const;
+
+	/* Whether a visible, solid event other than 'selfId'
+	 * stands on (x, y), blocking characters from entering */
+	bool occupied(int x, int y, int selfId) const;
+
+	/* Saved as a placeholder only; loads as an empty grid */
+	int serialSize() const;
+	void serialize(char *buffer) const;
+	static EventGrid *deserialize(const char *data, int len);
+
+private:
+	enum
+	{
+		Through   = 1 << 0,
+		NoGraphic = 1 << 1
+	};
+
+	struct Entry
+	{
+		int x, y;
+		int cell;
+		int tileId;
+		int flags;
+
+		std::vector<Vec2i> footprint;
+		/* Cells linked in 'covers' */
+		std::vector<int> covered;
+	};
+
+	static bool character(const Entry &e);
+	static bool affectsPassage(const Entry &e);
+
+	int cellIndex(int x, int y) const;
+	void link(int id, Entry &e);
+	void unlink(int id, Entry &e);
+
+	int w, h;
+	uint64_t rev;
+	uint64_t passRev;
+	std::map<int, Entry> entries;
+	/* Events by the tile they stand on */
+	std::vector<std::vector<int> > cells;
+	/* Events by every tile they cover */
+	std::vector<std::vector<int> > covers;
+
+	mutable std::vector<int> offMap;
+};
+
+#endif // EVENTGRID_H
@@ -0,0 +1,92 @@
+/*
+** pathfinder.h
+**
+** This file is part of mkxp.
+**
+** Copyright (C) 2013 Jonas Kulla <Nyocurio@gmail.com>
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PATHFINDER_H
+#define PATHFINDER_H
+
+#include <stdint.h>
+#include <vector>
+
+class Table;
+class EventGrid;
+
+/* Grid search over map Tables using the same step rules
+ * as Game_Character#passable? (minus the player check).
+ * Directions are RMXP style: 2 down, 4 left, 6 right, 8 up */
+class Pathfinder
+{
+public:
+	Pathfinder(const EventGrid &grid, const Table &data,
+	           const Table &passages, const Table &priorities);
+
+	/* Can a character standing on (x, y) move one tile in 'd'?
+	 * 'occupied' also rejects tiles other characters stand on;
+	 * without 'characters' they are left out entirely (see
+	 * EventGrid::passable) */
+	bool canStep(int x, int y, int d, int selfId,
+	             bool occupied = true, bool characters = true) const;
+
+	/* A* from (sx, sy) to (tx, ty). On success, fills 'dirs' with
+	 * the steps to take. Gives up after 'maxNodes' expansions */
+	bool findPath(int sx, int sy, int tx, int ty, int selfId,
+	              int maxNodes, std::vector<int> &dirs) const;
+
+	int width() const;
+	int height() const;
+
+	const EventGrid &grid;
+	const Table &data;
+	const Table &passages;
+	const Table &priorities;
+};
+
+/* Distance field towards a single target, for many characters
+ * homing in on the same spot (usually the player). Only
+ * recomputed when the target, map data or events other than
+ * walking characters change */
+class FlowField
+{
+public:
+	FlowField();
+
+	void update(const Pathfinder &pf, int tx, int ty);
+	void invalidate();
+
+	/* Step to take from (x, y), or 0 if unreachable / at target */
+	int direction(int x, int y) const;
+	/* Steps remaining from (x, y), or -1 if unreachable */
+	int distance(int x, int y) const;
+
+private:
+	void compute(const Pathfinder &pf);
+
+	int w, h;
+	int tx, ty;
+
+	/* Inputs the current field was built from */
+	uint64_t gridRev, dataRev, passRev, prioRev;
+	bool valid;
+
+	std::vector<int> dist;
+	std::vector<uint8_t> dirs;
+};
+
+#endif // PATHFINDER_H
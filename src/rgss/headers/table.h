@@ -40,6 +40,12 @@ public:
 	int ySize() const { return ys; }
 	int zSize() const { return zs; }
 
+	/* Changes on every set()/resize(). Values are drawn from
+	 * one process wide counter, so no two tables (or states of
+	 * one table) ever share a revision and caches derived from
+	 * the data can key on it alone */
+	uint64_t revision() const { return rev; }
+
 	int16_t get(int x, int y = 0, int z = 0) const;
 	void set(int16_t value, int x, int y = 0, int z = 0);
 
@@ -63,9 +69,13 @@ public:
 	}
 
 	sigc::signal<void> modified;
+	/* Emitted by set() with the cell's coordinates,
+	 * ahead of 'modified'. resize() only emits 'modified' */
+	sigc::signal<void, int, int, int> cellModified;
 
 private:
 	int xs, ys, zs;
+	uint64_t rev;
 	std::vector<int16_t> data;
 };
 
@@ -0,0 +1,417 @@
+/*
+** eventgrid.cpp
+**
+** This file is part of mkxp.
+**
+** Copyright (C) 2013 Jonas Kulla <Nyocurio@gmail.com>
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "eventgrid.h"
+
+#include "table.h"
+#include "util.h"
+
+#include <algorithm>
+
+/* Grids are only created and modified on the RGSS thread */
+static uint64_t nextRevision()
+{
+	static uint64_t counter = 0;
+
+	return ++counter;
+}
+
+/* Ruby semantics: result takes the sign of the divisor */
+static inline int rmod(int value, int range)
+{
+	int res = value % range;
+	return res < 0 ? res + range : res;
+}
+
+static void addId(std::vector<int> &ids, int id)
+{
+	std::vector<int>::iterator iter = std::lower_bound(ids.begin(), ids.end(), id);
+
+	if (iter == ids.end() || *iter != id)
+		ids.insert(iter, id);
+}
+
+static void removeId(std::vector<int> &ids, int id)
+{
+	std::vector<int>::iterator iter = std::lower_bound(ids.begin(), ids.end(), id);
+
+	if (iter != ids.end() && *iter == id)
+		ids.erase(iter);
+}
+
+/* Out of range reads yield 0 instead of nil */
+static inline int tableAt(const Table &t, int i)
+{
+	if (i < 0 || i >= t.xSize())
+		return 0;
+
+	return t.at(i);
+}
+
+EventGrid::EventGrid(int width, int height)
+    : w(std::max(width, 0)),
+      h(std::max(height, 0)),
+      rev(nextRevision()),
+      passRev(rev),
+      cells(w*h),
+      covers(w*h)
+{}
+
+EventGrid::EventGrid(const EventGrid &other)
+    : w(other.w), h(other.h),
+      rev(nextRevision()),
+      passRev(rev),
+      entries(other.entries),
+      cells(other.cells),
+      covers(other.covers)
+{}
+
+bool EventGrid::character(const Entry &e)
+{
+	return e.tileId == 0 && !(e.flags & NoGraphic);
+}
+
+/* Whether the event takes part in passable(..., false) */
+bool EventGrid::affectsPassage(const Entry &e)
+{
+	return e.tileId >= 0 && !(e.flags & Through) && !character(e);
+}
+
+int EventGrid::cellIndex(int x, int y) const
+{
+	if (x < 0 || x >= w || y < 0 || y >= h)
+		return -1;
+
+	return y*w + x;
+}
+
+void EventGrid::link(int id, Entry &e)
+{
+	e.cell = cellIndex(e.x, e.y);
+
+	if (e.cell >= 0)
+		addId(cells[e.cell], id);
+
+	for (size_t i = 0; i < e.footprint.size(); ++i)
+	{
+		const int cell = cellIndex(e.x + e.footprint[i].x,
+		                           e.y + e.footprint[i].y);
+
+		if (cell < 0)
+			continue;
+
+		addId(covers[cell], id);
+		e.covered.push_back(cell);
+	}
+}
+
+void EventGrid::unlink(int id, Entry &e)
+{
+	if (e.cell >= 0)
+		removeId(cells[e.cell], id);
+
+	for (size_t i = 0; i < e.covered.size(); ++i)
+		removeId(covers[e.covered[i]], id);
+
+	e.cell = -1;
+	e.covered.clear();
+}
+
+void EventGrid::insert(int id, int x, int y)
+{
+	std::map<int, Entry>::iterator iter = entries.find(id);
+
+	if (iter != entries.end())
+	{
+		move(id, x, y);
+		return;
+	}
+
+	Entry &e = entries[id];
+	e.x = x;
+	e.y = y;
+	e.tileId = 0;
+	e.flags = 0;
+	e.footprint.assign(1, Vec2i(0, 0));
+
+	link(id, e);
+	rev = nextRevision();
+
+	/* Fresh entries are characters until setState() */
+}
+
+void EventGrid::move(int id, int x, int y)
+{
+	std::map<int, Entry>::iterator iter = entries.find(id);
+
+	if (iter == entries.end())
+	{
+		insert(id, x, y);
+		return;
+	}
+
+	Entry &e = iter->second;
+
+	if (e.x == x && e.y == y)
+		return;
+
+	unlink(id, e);
+
+	e.x = x;
+	e.y = y;
+
+	link(id, e);
+	rev = nextRevision();
+
+	if (affectsPassage(e))
+		passRev = rev;
+}
+
+void EventGrid::remove(int id)
+{
+	std::map<int, Entry>::iterator iter = entries.find(id);
+
+	if (iter == entries.end())
+		return;
+
+	const bool passage = affectsPassage(iter->second);
+
+	unlink(id, iter->second);
+	entries.erase(iter);
+	rev = nextRevision();
+
+	if (passage)
+		passRev = rev;
+}
+
+void EventGrid::clear()
+{
+	entries.clear();
+
+	for (size_t i = 0; i < cells.size(); ++i)
+	{
+		cells[i].clear();
+		covers[i].clear();
+	}
+
+	rev = passRev = nextRevision();
+}
+
+void EventGrid::setState(int id, int tileId, bool through, bool noGraphic)
+{
+	std::map<int, Entry>::iterator iter = entries.find(id);
+
+	if (iter == entries.end())
+		return;
+
+	Entry &e = iter->second;
+	const int flags = (through ? Through : 0) | (noGraphic ? NoGraphic : 0);
+
+	if (e.tileId == tileId && e.flags == flags)
+		return;
+
+	e.tileId = tileId;
+	e.flags = flags;
+	rev = passRev = nextRevision();
+}
+
+void EventGrid::setFootprint(int id, const std::vector<Vec2i> &offsets)
+{
+	std::map<int, Entry>::iterator iter = entries.find(id);
+
+	if (iter == entries.end())
+		return;
+
+	Entry &e = iter->second;
+
+	if (e.footprint == offsets)
+		return;
+
+	unlink(id, e);
+	e.footprint = offsets;
+	link(id, e);
+
+	rev = nextRevision();
+}
+
+const std::vector<int> &EventGrid::at(int x, int y) const
+{
+	int cell = cellIndex(x, y);
+
+	if (cell >= 0)
+		return cells[cell];
+
+	/* Events off the map aren't bucketed; this is rare
+	 * enough that a linear scan is fine */
+	offMap.clear();
+
+	std::map<int, Entry>::const_iterator iter;
+
+	for (iter = entries.begin(); iter != entries.end(); ++iter)
+		if (iter->second.x == x && iter->second.y == y)
+			offMap.push_back(iter->first);
+
+	return offMap;
+}
+
+const std::vector<int> &EventGrid::covering(int x, int y) const
+{
+	int cell = cellIndex(x, y);
+
+	if (cell >= 0)
+		return covers[cell];
+
+	offMap.clear();
+
+	std::map<int, Entry>::const_iterator iter;
+
+	for (iter = entries.begin(); iter != entries.end(); ++iter)
+	{
+		const Entry &e = iter->second;
+
+		for (size_t i = 0; i < e.footprint.size(); ++i)
+		{
+			if (e.x + e.footprint[i].x == x && e.y + e.footprint[i].y == y)
+			{
+				offMap.push_back(iter->first);
+				break;
+			}
+		}
+	}
+
+	return offMap;
+}
+
+bool EventGrid::passable(const Table &data, const Table &passages,
+                         const Table &priorities,
+                         int x, int y, int d, int selfId,
+                         bool characters) const
+{
+	if (w == 0 || h == 0)
+		return false;
+
+	x = rmod(x, w);
+	y = rmod(y, h);
+
+	/* Change direction (0,2,4,6,8,10) to obstacle bit (0,1,2,4,8,0) */
+	const int shift = d / 2 - 1;
+	const int bit = shift >= 0 ? (1 << shift) & 0x0f : 0;
+
+	const std::vector<int> &cell = cells[y*w + x];
+
+	for (size_t i = 0; i < cell.size(); ++i)
+	{
+		const int id = cell[i];
+
+		if (id == selfId)
+			continue;
+
+		const Entry &e = entries.find(id)->second;
+
+		if (e.tileId < 0 || (e.flags & Through))
+			continue;
+
+		if (!characters && character(e))
+			continue;
+
+		const int pass = tableAt(passages, e.tileId);
+
+		if (e.tileId == 0 && (e.flags & NoGraphic))
+			return false;
+		else if (pass & bit)
+			return false;
+		else if ((pass & 0x0f) == 0x0f)
+			return false;
+		else if (tableAt(priorities, e.tileId) == 0)
+			return true;
+	}
+
+	if (x >= data.xSize() || y >= data.ySize())
+		return true;
+
+	/* Search layers from the top down */
+	int blank = 0;
+
+	for (int i = 2; i >= 0; --i)
+	{
+		if (i >= data.zSize())
+			continue;
+
+		const int tileId = data.at(x, y, i);
+
+		/* Only handle blank if all three layers are blank */
+		if (tileId < 48 && i > 0)
+		{
+			if (++blank < 3)
+				continue;
+		}
+
+		const int pass = tableAt(passages, tileId);
+
+		if (pass & bit)
+			return false;
+		else if ((pass & 0x0f) == 0x0f)
+			return false;
+		else if (tableAt(priorities, tileId) == 0)
+			return true;
+	}
+
+	return true;
+}
+
+bool EventGrid::occupied(int x, int y, int selfId) const
+{
+	const int cell = cellIndex(x, y);
+
+	if (cell < 0)
+		return false;
+
+	const std::vector<int> &ids = cells[cell];
+
+	for (size_t i = 0; i < ids.size(); ++i)
+	{
+		if (ids[i] == selfId)
+			continue;
+
+		const Entry &e = entries.find(ids[i])->second;
+
+		if (!(e.flags & (Through | NoGraphic)))
+			return true;
+	}
+
+	return false;
+}
+
+/* Serializable. The grid is derived from the map's events, so
+ * saves only carry a placeholder; an empty grid comes back,
+ * which Game_Map#event_grid rebuilds from the loaded events */
+int EventGrid::serialSize() const
+{
+	return 0;
+}
+
+void EventGrid::serialize(char *) const
+{}
+
+EventGrid *EventGrid::deserialize(const char *, int)
+{
+	return new EventGrid(0, 0);
+}
@@ -0,0 +1,306 @@
+/*
+** pathfinder.cpp
+**
+** This file is part of mkxp.
+**
+** Copyright (C) 2013 Jonas Kulla <Nyocurio@gmail.com>
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pathfinder.h"
+
+#include "eventgrid.h"
+#include "table.h"
+
+#include <queue>
+#include <algorithm>
+#include <stdlib.h>
+
+static const int stepDirs[] = { 2, 4, 6, 8 };
+
+static inline int dirX(int d)
+{
+	return d == 6 ? 1 : d == 4 ? -1 : 0;
+}
+
+static inline int dirY(int d)
+{
+	return d == 2 ? 1 : d == 8 ? -1 : 0;
+}
+
+Pathfinder::Pathfinder(const EventGrid &grid, const Table &data,
+                       const Table &passages, const Table &priorities)
+    : grid(grid),
+      data(data),
+      passages(passages),
+      priorities(priorities)
+{}
+
+int Pathfinder::width() const
+{
+	return grid.width();
+}
+
+int Pathfinder::height() const
+{
+	return grid.height();
+}
+
+bool Pathfinder::canStep(int x, int y, int d, int selfId,
+                         bool occupied, bool characters) const
+{
+	const int nx = x + dirX(d);
+	const int ny = y + dirY(d);
+
+	if (nx < 0 || nx >= width() || ny < 0 || ny >= height())
+		return false;
+
+	/* Leaving the current tile */
+	if (!grid.passable(data, passages, priorities, x, y, d, selfId, characters))
+		return false;
+
+	/* Entering the next one */
+	if (!grid.passable(data, passages, priorities, nx, ny, 10 - d, 0, characters))
+		return false;
+
+	if (occupied && grid.occupied(nx, ny, selfId))
+		return false;
+
+	return true;
+}
+
+namespace
+{
+	struct OpenNode
+	{
+		int f, g;
+		int index;
+
+		bool operator<(const OpenNode &o) const
+		{
+			/* std::priority_queue is a max-heap; prefer
+			 * lowest f, then deepest g to break ties */
+			if (f != o.f)
+				return f > o.f;
+
+			return g < o.g;
+		}
+	};
+}
+
+bool Pathfinder::findPath(int sx, int sy, int tx, int ty, int selfId,
+                          int maxNodes, std::vector<int> &dirs) const
+{
+	const int w = width();
+	const int h = height();
+
+	dirs.clear();
+
+	if (sx < 0 || sx >= w || sy < 0 || sy >= h)
+		return false;
+	if (tx < 0 || tx >= w || ty < 0 || ty >= h)
+		return false;
+
+	if (sx == tx && sy == ty)
+		return true;
+
+	const int start = sy*w + sx;
+	const int goal = ty*w + tx;
+
+	std::vector<int> gScore(w*h, -1);
+	/* Direction taken to reach each node */
+	std::vector<uint8_t> cameBy(w*h, 0);
+	std::vector<bool> closed(w*h, false);
+
+	std::priority_queue<OpenNode> open;
+
+	gScore[start] = 0;
+	OpenNode first = { abs(tx - sx) + abs(ty - sy), 0, start };
+	open.push(first);
+
+	int expanded = 0;
+
+	while (!open.empty())
+	{
+		const OpenNode cur = open.top();
+		open.pop();
+
+		if (closed[cur.index])
+			continue;
+
+		if (cur.index == goal)
+			break;
+
+		closed[cur.index] = true;
+
+		if (maxNodes > 0 && ++expanded > maxNodes)
+			return false;
+
+		const int x = cur.index % w;
+		const int y = cur.index / w;
+
+		for (int i = 0; i < 4; ++i)
+		{
+			const int d = stepDirs[i];
+			const int nx = x + dirX(d);
+			const int ny = y + dirY(d);
+			const int next = ny*w + nx;
+
+			if (nx < 0 || nx >= w || ny < 0 || ny >= h || closed[next])
+				continue;
+
+			/* Characters may walk up to an occupied goal (eg. to touch it) */
+			if (!canStep(x, y, d, selfId, next != goal))
+				continue;
+
+			const int g = cur.g + 1;
+
+			if (gScore[next] >= 0 && gScore[next] <= g)
+				continue;
+
+			gScore[next] = g;
+			cameBy[next] = d;
+
+			OpenNode node = { g + abs(tx - nx) + abs(ty - ny), g, next };
+			open.push(node);
+		}
+	}
+
+	if (gScore[goal] < 0)
+		return false;
+
+	/* Walk back from the goal */
+	for (int index = goal; index != start;)
+	{
+		const int d = cameBy[index];
+		dirs.push_back(d);
+
+		index -= dirY(d) * w + dirX(d);
+	}
+
+	std::reverse(dirs.begin(), dirs.end());
+
+	return true;
+}
+
+FlowField::FlowField()
+    : w(0), h(0),
+      tx(-1), ty(-1),
+      gridRev(0), dataRev(0), passRev(0), prioRev(0),
+      valid(false)
+{}
+
+void FlowField::invalidate()
+{
+	valid = false;
+}
+
+void FlowField::update(const Pathfinder &pf, int tx, int ty)
+{
+	if (valid
+	&&  this->tx == tx && this->ty == ty
+	&&  w == pf.width() && h == pf.height()
+	&&  gridRev == pf.grid.passRevision()
+	&&  dataRev == pf.data.revision()
+	&&  passRev == pf.passages.revision()
+	&&  prioRev == pf.priorities.revision())
+	{
+		return;
+	}
+
+	this->tx = tx;
+	this->ty = ty;
+	w = pf.width();
+	h = pf.height();
+
+	gridRev = pf.grid.passRevision();
+	dataRev = pf.data.revision();
+	passRev = pf.passages.revision();
+	prioRev = pf.priorities.revision();
+
+	compute(pf);
+	valid = true;
+}
+
+/* Breadth first search outwards from the target. Each reached
+ * tile records the direction that leads one step closer.
+ * Characters are ignored here since they also sit on the
+ * tiles being routed from; the move itself will still fail
+ * if someone is in the way. This also keeps the field valid
+ * while they walk around (see EventGrid::passRevision) */
+void FlowField::compute(const Pathfinder &pf)
+{
+	dist.assign(w*h, -1);
+	dirs.assign(w*h, 0);
+
+	if (tx < 0 || tx >= w || ty < 0 || ty >= h)
+		return;
+
+	std::vector<int> queue;
+	queue.reserve(w*h);
+
+	const int target = ty*w + tx;
+	dist[target] = 0;
+	queue.push_back(target);
+
+	for (size_t head = 0; head < queue.size(); ++head)
+	{
+		const int index = queue[head];
+		const int x = index % w;
+		const int y = index / w;
+
+		for (int i = 0; i < 4; ++i)
+		{
+			/* Neighbour sitting in direction 'd' steps back
+			 * towards us with the opposite direction */
+			const int d = stepDirs[i];
+			const int nx = x + dirX(d);
+			const int ny = y + dirY(d);
+
+			if (nx < 0 || nx >= w || ny < 0 || ny >= h)
+				continue;
+
+			const int next = ny*w + nx;
+
+			if (dist[next] >= 0)
+				continue;
+
+			const int back = 10 - d;
+
+			if (!pf.canStep(nx, ny, back, 0, false, false))
+				continue;
+
+			dist[next] = dist[index] + 1;
+			dirs[next] = back;
+			queue.push_back(next);
+		}
+	}
+}
+
+int FlowField::direction(int x, int y) const
+{
+	if (!valid || x < 0 || x >= w || y < 0 || y >= h)
+		return 0;
+
+	return dirs[y*w + x];
+}
+
+int FlowField::distance(int x, int y) const
+{
+	if (!valid || x < 0 || x >= w || y < 0 || y >= h)
+		return -1;
+
+	return dist[y*w + x];
+}
@@ -28,14 +28,24 @@
 #include "exception.h"
 #include "util.h"
 
+/* Tables are only created and modified on the RGSS thread */
+static uint64_t nextRevision()
+{
+	static uint64_t counter = 0;
+
+	return ++counter;
+}
+
 /* Init normally */
 Table::Table(int x, int y /*= 1*/, int z /*= 1*/)
     : xs(x), ys(y), zs(z),
+      rev(nextRevision()),
       data(x*y*z)
 {}
 
 Table::Table(const Table &other)
     : xs(other.xs), ys(other.ys), zs(other.zs),
+      rev(nextRevision()),
       data(other.data)
 {}
 
@@ -54,7 +64,9 @@ void Table::set(int16_t value, int x, int y, int z)
 	}
 
 	data[xs*ys*z + xs*y + x] = value;
+	rev = nextRevision();
 
+	cellModified(x, y, z);
 	modified();
 }
 
@@ -75,8 +87,9 @@ void Table::resize(int x, int y, int z)
 	xs = x;
 	ys = y;
 	zs = z;
+	rev = nextRevision();
 
-	return;
+	modified();
 }
 
 void Table::resize(int x, int y)
@@ -45,6 +45,76 @@ union SDL_Event;
 
 #define MAX_FINGERS 4
 
+/* Lock free ring for exactly one producer and one
+ * consumer thread. 'size' must be a power of two */
+template<typename T, size_t size>
+struct SPSCRing
+{
+	SPSCRing()
+	{
+		SDL_AtomicSet(&head, 0);
+		SDL_AtomicSet(&tail, 0);
+	}
+
+	/* Producer side; fails when the ring is full */
+	bool push(const T &value)
+	{
+		const int t = SDL_AtomicGet(&tail);
+
+		if (t - SDL_AtomicGet(&head) == (int) size)
+			return false;
+
+		ring[t & (size-1)] = value;
+		SDL_AtomicSet(&tail, t + 1);
+
+		return true;
+	}
+
+	/* Consumer side; fails when the ring is empty */
+	bool pop(T &out)
+	{
+		const int h = SDL_AtomicGet(&head);
+
+		if (h == SDL_AtomicGet(&tail))
+			return false;
+
+		out = ring[h & (size-1)];
+		SDL_AtomicSet(&head, h + 1);
+
+		return true;
+	}
+
+private:
+	T ring[size];
+	SDL_atomic_t head;
+	SDL_atomic_t tail;
+};
+
+/* A device button changing state, as seen by the event thread */
+struct InputEvent
+{
+	enum Type
+	{
+		KeyDown, KeyUp,
+		MouseDown, MouseUp,
+		GcButtonDown, GcButtonUp,
+		JoyButtonDown, JoyButtonUp
+	};
+
+	uint8_t type;
+
+	/* Scancode for keys, button index otherwise */
+	uint16_t code;
+
+	/* Keys only: keyStates slot of the key's keycode */
+	uint16_t keySlot;
+
+	/* Microseconds on EventThread::inputClock() */
+	uint64_t time;
+};
+
+#define INPUT_EVENT_RING_SIZE 1024
+
 class EventThread
 {
 public:
@@ -86,6 +156,18 @@ public:
 	static MouseState mouseState;
 	static TouchState touchState;
 	static bool forceTerminate;
+	/* Set while a recording drives the input state;
+	 * device input events are dropped meanwhile. Set by
+	 * the RGSS thread, read by the event thread */
+	static AtomicFlag inputReplay;
+
+	/* Every button transition, in order, for the RGSS thread
+	 * to catch presses shorter than a frame */
+	static SPSCRing<InputEvent, INPUT_EVENT_RING_SIZE> inputEvents;
+
+	/* Microseconds since initInputClock(), 0 before it */
+	static uint64_t inputClock();
+	static void initInputClock();
 
 	static bool allocUserEvents();
 
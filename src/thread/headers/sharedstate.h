@@ -47,15 +47,27 @@ class Oneshot;
 class Steam;
 #endif
 class GLState;
+class FrameProfiler;
 class TexPool;
 class Font;
 class SharedFontState;
 struct GlobalIBO;
+class VertexStream;
 struct Config;
 struct Vec2i;
 struct SharedMidiState;
 class OtherViewMessager;
 
+namespace TileAtlas
+{
+struct Key;
+}
+
+namespace WindowFrame
+{
+struct Key;
+}
+
 struct SharedState
 {
 	void *bindingData() const;
@@ -86,6 +98,8 @@ struct SharedState
 
 	GLState &_glState() const;
 
+	FrameProfiler &profiler() const;
+
 	ShaderSet &shaders() const;
 
 	TexPool &texPool() const;
@@ -102,6 +116,9 @@ struct SharedState
 	void ensureQuadIBO(size_t minSize);
 	GlobalIBO &globalIBO();
 
+	/* Shared ring for per-frame vertex data */
+	VertexStream &vertexStream();
+
 	/* Global general purpose texture */
 	void bindTex();
 	void ensureTexSize(int minW, int minH, Vec2i &currentSizeOut);
@@ -110,10 +127,20 @@ struct SharedState
 
 	Quad &gpQuad() const;
 
-	/* Basically just a simple "TexPool"
-	 * replacement for Tilemap atlas use */
-	void requestAtlasTex(int w, int h, TEXFBO &out);
-	void releaseAtlasTex(TEXFBO &tex);
+	/* Tilemap atlases, shared and cached by contents
+	 * (see TileAtlas::Cache). requestAtlasTex() returns
+	 * true if 'out' still has to be built */
+	bool requestAtlasTex(const TileAtlas::Key &key, TEXFBO &out);
+	void releaseAtlasTex(const TileAtlas::Key &key);
+
+	/* Rendered window frames, shared and cached the same
+	 * way (see WindowFrame::Cache). replaceWindowFrame()
+	 * trades a held frame for another, re-rendering it in
+	 * place when nothing else uses it */
+	bool requestWindowFrame(const WindowFrame::Key &key, TEXFBO &out);
+	bool replaceWindowFrame(const WindowFrame::Key &prev,
+	                        const WindowFrame::Key &key, TEXFBO &out);
+	void releaseWindowFrame(const WindowFrame::Key &key);
 
 	/* Checks EventThread's shutdown request flag and if set,
 	 * requests the binding to terminate. In this case, this
@@ -90,6 +90,47 @@ EventThread::MouseState EventThread::mouseState;
 EventThread::TouchState EventThread::touchState;
 SDL_mutex *EventThread::inputMut;
 bool EventThread::forceTerminate;
+AtomicFlag EventThread::inputReplay;
+SPSCRing<InputEvent, INPUT_EVENT_RING_SIZE> EventThread::inputEvents;
+
+/* Set once SDL is initialized; 'inputClockReady' publishes
+ * the base to the event thread */
+static Uint64 inputClockBase;
+static SDL_atomic_t inputClockReady;
+
+void EventThread::initInputClock()
+{
+	if (SDL_AtomicGet(&inputClockReady))
+		return;
+
+	inputClockBase = SDL_GetPerformanceCounter();
+	SDL_AtomicSet(&inputClockReady, 1);
+}
+
+uint64_t EventThread::inputClock()
+{
+	if (!SDL_AtomicGet(&inputClockReady))
+		return 0;
+
+	const Uint64 freq = SDL_GetPerformanceFrequency();
+	const Uint64 delta = SDL_GetPerformanceCounter() - inputClockBase;
+
+	/* Split to keep the multiplication from overflowing */
+	return (delta / freq) * 1000000 + (delta % freq) * 1000000 / freq;
+}
+
+static void pushInputEvent(uint8_t type, int code, int keySlot = 0)
+{
+	InputEvent e;
+	e.type = type;
+	e.code = code;
+	e.keySlot = keySlot;
+	e.time = EventThread::inputClock();
+
+	/* The RGSS thread stopped draining us (eg. a long load);
+	 * frame sampled state still covers what gets dropped */
+	EventThread::inputEvents.push(e);
+}
 
 /* User event codes */
 enum
@@ -216,10 +257,24 @@ void EventThread::process(RGSSThreadData &rtData)
 		/* Preselect and discard unwanted events here */
 		switch (event.type)
 		{
+		case SDL_KEYDOWN :
+		case SDL_KEYUP :
+		case SDL_CONTROLLERBUTTONDOWN :
+		case SDL_CONTROLLERBUTTONUP :
+		case SDL_CONTROLLERAXISMOTION :
+		case SDL_JOYBUTTONDOWN :
+		case SDL_JOYBUTTONUP :
+		case SDL_JOYHATMOTION :
+		case SDL_JOYAXISMOTION :
+			/* Input state is owned by the replay */
+			if (inputReplay)
+				continue;
+			break;
+
 		case SDL_MOUSEBUTTONDOWN :
 		case SDL_MOUSEBUTTONUP :
 		case SDL_MOUSEMOTION :
-			if (event.button.which == SDL_TOUCH_MOUSEID)
+			if (event.button.which == SDL_TOUCH_MOUSEID || inputReplay)
 				continue;
 			break;
 
@@ -348,6 +403,9 @@ void EventThread::process(RGSSThreadData &rtData)
 			break;
 
 		case SDL_KEYDOWN:
+			if (!event.key.repeat)
+				pushInputEvent(InputEvent::KeyDown, event.key.keysym.scancode,
+				               KEYCODE_TO_SCUFFEDCODE(event.key.keysym.sym));
 			SDL_LockMutex(inputMut);
 			keyStates[KEYCODE_TO_SCUFFEDCODE(event.key.keysym.sym)] = true;
 			SDL_UnlockMutex(inputMut);
@@ -432,6 +490,8 @@ void EventThread::process(RGSSThreadData &rtData)
 			break;
 
 		case SDL_KEYUP :
+			pushInputEvent(InputEvent::KeyUp, event.key.keysym.scancode,
+			               KEYCODE_TO_SCUFFEDCODE(event.key.keysym.sym));
 			SDL_LockMutex(inputMut);
 			keyStates[KEYCODE_TO_SCUFFEDCODE(event.key.keysym.sym)] = false;
 			SDL_UnlockMutex(inputMut);
@@ -452,12 +512,14 @@ void EventThread::process(RGSSThreadData &rtData)
 			break;
 
 		case SDL_CONTROLLERBUTTONDOWN:
+			pushInputEvent(InputEvent::GcButtonDown, event.cbutton.button);
 			SDL_LockMutex(inputMut);
 			gcState.buttons[event.cbutton.button] = true;
 			SDL_UnlockMutex(inputMut);
 			break;
 
 		case SDL_CONTROLLERBUTTONUP:
+			pushInputEvent(InputEvent::GcButtonUp, event.cbutton.button);
 			SDL_LockMutex(inputMut);
 			gcState.buttons[event.cbutton.button] = false;
 			SDL_UnlockMutex(inputMut);
@@ -487,16 +549,22 @@ void EventThread::process(RGSSThreadData &rtData)
 
 		case SDL_JOYBUTTONDOWN :
 			if (joysticks.find(event.jbutton.which) != joysticks.end())
+			{
+				pushInputEvent(InputEvent::JoyButtonDown, event.jbutton.button);
 				SDL_LockMutex(inputMut);
 				joyState.buttons[event.jbutton.button] = true;
 				SDL_UnlockMutex(inputMut);
+			}
 			break;
 
 		case SDL_JOYBUTTONUP :
 			if (joysticks.find(event.jbutton.which) != joysticks.end())
+			{
+				pushInputEvent(InputEvent::JoyButtonUp, event.jbutton.button);
 				SDL_LockMutex(inputMut);
 				joyState.buttons[event.jbutton.button] = false;
 				SDL_UnlockMutex(inputMut);
+			}
 			break;
 
 		case SDL_JOYHATMOTION :
@@ -534,12 +602,14 @@ void EventThread::process(RGSSThreadData &rtData)
 			break;
 
 		case SDL_MOUSEBUTTONDOWN :
+			pushInputEvent(InputEvent::MouseDown, event.button.button);
 			SDL_LockMutex(inputMut);
 			mouseState.buttons[event.button.button] = true;
 			SDL_UnlockMutex(inputMut);
 			break;
 
 		case SDL_MOUSEBUTTONUP :
+			pushInputEvent(InputEvent::MouseUp, event.button.button);
 			SDL_LockMutex(inputMut);
 			mouseState.buttons[event.button.button] = false;
 			SDL_UnlockMutex(inputMut);
@@ -719,6 +789,9 @@ void EventThread::cleanup()
 
 void EventThread::resetInputStates()
 {
+	if (inputReplay)
+		return;
+
 	memset(&keyStates, 0, sizeof(keyStates));
 	memset(&modkeys, 0, sizeof(modkeys));
 	memset(&gcState, 0, sizeof(gcState));
@@ -31,13 +31,17 @@
 #include "steam.h"
 #endif
 #include "glstate.h"
+#include "frameprofiler.h"
 #include "shader.h"
 #include "texpool.h"
 #include "font.h"
 #include "eventthread.h"
 #include "gl-util.h"
 #include "global-ibo.h"
+#include "vertex-stream.h"
 #include "quad.h"
+#include "tileatlas.h"
+#include "windowframe.h"
 #include "binding.h"
 #include "exception.h"
 #include "otherview-message.h"
@@ -51,6 +55,7 @@
 SharedState *SharedState::instance = 0;
 int SharedState::rgssVersion = 0;
 static GlobalIBO *_globalIBO = 0;
+static VertexStream *_vertexStream = 0;
 
 struct SharedStatePrivate
 {
@@ -75,6 +80,8 @@ struct SharedStatePrivate
 
 	GLState _glState;
 
+	FrameProfiler profiler;
+
 	ShaderSet shaders;
 
 	TexPool texPool;
@@ -88,7 +95,8 @@ struct SharedStatePrivate
 
 	TEXFBO gpTexFBO;
 
-	TEXFBO atlasTex;
+	TileAtlas::Cache atlasCache;
+	WindowFrame::Cache frameCache;
 
 	Quad gpQuad;
 
@@ -108,13 +116,18 @@ struct SharedStatePrivate
 	      audio(*threadData),
 	      oneshot(*threadData),
 	      _glState(threadData->config),
+	      profiler(threadData->config),
 	      fontState(threadData->config),
+	      atlasCache(texPool, 64000000 /* 64 MB */),
+	      frameCache(texPool, 16000000 /* 16 MB */),
 	      stampCounter(0),
 		  otherView(threadData->config)
 	{
-		/* Shaders have been compiled in ShaderSet's constructor */
-		if (gl.ReleaseShaderCompiler)
-			gl.ReleaseShaderCompiler();
+		/* Shaders are compiled on first use, so the GLES shader
+		 * compiler can't be released up front anymore */
+		Shader::setBinaryCachePath(config.commonDataPath.empty()
+		                           ? std::string()
+		                           : config.commonDataPath + "shaders.cache");
 
 		fileSystem.addPath(".");
 
@@ -141,9 +154,10 @@ struct SharedStatePrivate
 
 	~SharedStatePrivate()
 	{
+		Shader::flushBinaryCache();
+
 		TEX::del(globalTex);
 		TEXFBO::fini(gpTexFBO);
-		TEXFBO::fini(atlasTex);
 	}
 };
 
@@ -158,6 +172,8 @@ void SharedState::initInstance(RGSSThreadData *threadData)
 	_globalIBO = new GlobalIBO();
 	_globalIBO->ensureSize(1);
 
+	_vertexStream = new VertexStream(threadData->config.vertexStreamSize * 1024);
+
 	SharedState::instance = 0;
 	Font *defaultFont = 0;
 
@@ -170,6 +186,7 @@ void SharedState::initInstance(RGSSThreadData *threadData)
 	catch (const Exception &exc)
 	{
 		delete _globalIBO;
+		delete _vertexStream;
 		delete SharedState::instance;
 		delete defaultFont;
 
@@ -186,6 +203,7 @@ void SharedState::finiInstance()
 	delete SharedState::instance;
 
 	delete _globalIBO;
+	delete _vertexStream;
 }
 
 void SharedState::setScreen(Scene &screen)
@@ -214,6 +232,7 @@ GSATT(Oneshot&, oneshot)
 GSATT(Steam&, steam)
 #endif
 GSATT(GLState&, _glState)
+GSATT(FrameProfiler&, profiler)
 GSATT(ShaderSet&, shaders)
 GSATT(TexPool&, texPool)
 GSATT(Quad&, gpQuad)
@@ -235,6 +254,11 @@ GlobalIBO &SharedState::globalIBO()
 	return *_globalIBO;
 }
 
+VertexStream &SharedState::vertexStream()
+{
+	return *_vertexStream;
+}
+
 void SharedState::bindTex()
 {
 	TEX::bind(p->globalTex);
@@ -288,34 +312,30 @@ TEXFBO &SharedState::gpTexFBO(int minW, int minH)
 	return p->gpTexFBO;
 }
 
-void SharedState::requestAtlasTex(int w, int h, TEXFBO &out)
+bool SharedState::requestAtlasTex(const TileAtlas::Key &key, TEXFBO &out)
 {
-	TEXFBO tex;
-
-	if (w == p->atlasTex.width && h == p->atlasTex.height)
-	{
-		tex = p->atlasTex;
-		p->atlasTex = TEXFBO();
-	}
-	else
-	{
-		TEXFBO::init(tex);
-		TEXFBO::allocEmpty(tex, w, h);
-		TEXFBO::linkFBO(tex);
-	}
+	return p->atlasCache.request(key, out);
+}
 
-	out = tex;
+void SharedState::releaseAtlasTex(const TileAtlas::Key &key)
+{
+	p->atlasCache.release(key);
 }
 
-void SharedState::releaseAtlasTex(TEXFBO &tex)
+bool SharedState::requestWindowFrame(const WindowFrame::Key &key, TEXFBO &out)
 {
-	/* No point in caching an invalid object */
-	if (tex.tex == TEX::ID(0))
-		return;
+	return p->frameCache.request(key, out);
+}
 
-	TEXFBO::fini(p->atlasTex);
+bool SharedState::replaceWindowFrame(const WindowFrame::Key &prev,
+                                     const WindowFrame::Key &key, TEXFBO &out)
+{
+	return p->frameCache.replace(prev, key, out);
+}
 
-	p->atlasTex = tex;
+void SharedState::releaseWindowFrame(const WindowFrame::Key &key)
+{
+	p->frameCache.release(key);
 }
 
 void SharedState::checkShutdown()
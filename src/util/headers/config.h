@@ -33,6 +33,8 @@ struct Config
 	bool debugMode;
 	bool screenMode;
 	bool printFPS;
+	bool frameProfiler;
+	std::string frameProfilerTrace;
 
 	bool fullscreen;
 	bool fixedAspectRatio;
@@ -52,7 +54,29 @@ struct Config
 	bool subImageFix;
 	bool enableBlitting;
 	int maxTextureSize;
+	int megaTexBudget;
 	bool isOtherView;
+	bool otherViewShm;
+
+	/* Render offscreen without presenting anything */
+	bool headless;
+	std::string headlessFrameDump;
+	std::string headlessFrameHashes;
+	int headlessFrameLimit;
+
+	std::string inputRecord;
+	std::string inputReplay;
+	bool inputReplayUncapped;
+
+	bool framePacing;
+	int framePacingSpin;
+	bool framePacingAlignRefresh;
+
+	bool pipelinedPresent;
+
+	int vertexStreamSize;
+
+	bool pixelShadowBuffer;
 
 	std::string gameFolder;
 	bool allowSymlinks;
@@ -77,6 +77,8 @@ void Config::read(int argc, char *argv[])
 	PO_DESC(debugMode, bool, false) \
 	PO_DESC(screenMode, bool, false) \
 	PO_DESC(printFPS, bool, false) \
+	PO_DESC(frameProfiler, bool, false) \
+	PO_DESC(frameProfilerTrace, std::string, "") \
 	PO_DESC(fullscreen, bool, false) \
 	PO_DESC(fixedAspectRatio, bool, true) \
 	PO_DESC(smoothScaling, bool, false) \
@@ -91,6 +93,7 @@ void Config::read(int argc, char *argv[])
 	PO_DESC(subImageFix, bool, false) \
 	PO_DESC(enableBlitting, bool, true) \
 	PO_DESC(maxTextureSize, int, 0) \
+	PO_DESC(megaTexBudget, int, 128) \
 	PO_DESC(gameFolder, std::string, ".") \
 	PO_DESC(allowSymlinks, bool, false) \
 	PO_DESC(iconPath, std::string, "") \
@@ -98,6 +101,20 @@ void Config::read(int argc, char *argv[])
 	PO_DESC(audioChannels, int, 30) \
 	PO_DESC(pathCache, bool, true) \
 	PO_DESC(isOtherView, bool, false) \
+	PO_DESC(otherViewShm, bool, false) \
+	PO_DESC(headless, bool, false) \
+	PO_DESC(headlessFrameDump, std::string, "") \
+	PO_DESC(headlessFrameHashes, std::string, "") \
+	PO_DESC(headlessFrameLimit, int, 0) \
+	PO_DESC(inputRecord, std::string, "") \
+	PO_DESC(inputReplay, std::string, "") \
+	PO_DESC(inputReplayUncapped, bool, false) \
+	PO_DESC(framePacing, bool, false) \
+	PO_DESC(framePacingSpin, int, 500) \
+	PO_DESC(framePacingAlignRefresh, bool, false) \
+	PO_DESC(pipelinedPresent, bool, false) \
+	PO_DESC(vertexStreamSize, int, 4096) \
+	PO_DESC(pixelShadowBuffer, bool, false) \
 	PO_DESC(mjitEnabled, bool, false) \
 	PO_DESC(mjitVerbosity, int, 0) \
 	PO_DESC(mjitMaxCache, int, 100) \